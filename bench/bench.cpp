@@ -0,0 +1,355 @@
+#define ANKERL_NANOBENCH_IMPLEMENT
+#include <nanobench.h>
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <filesystem>
+
+#include <unistd.h>
+
+#include <fmt/format.h>
+
+#include <boost/program_options.hpp>
+
+#include "compiled_template.hpp"
+#include "generator.hpp"
+#include "generator_template.hpp"
+#include "template_program.hpp"
+#include "variable_store.hpp"
+#include "variable_substitutor.hpp"
+
+#include "utils/scan.hpp"
+
+namespace fs = std::filesystem;
+namespace opt = boost::program_options;
+namespace nb = ankerl::nanobench;
+
+namespace {
+
+    constexpr std::size_t VariableCount = 16;
+
+    // 'density' placeholders every 100 characters, the rest is plain text
+    std::string makeLine(std::size_t length, std::size_t density) {
+        std::string line;
+        line.reserve(length + 16);
+
+        std::size_t placed = 0;
+
+        while (line.size() < length) {
+            if (density > 0 && line.size() * density / 100 >= placed) {
+                line += fmt::format("{{{{ var{} }}}}", placed % VariableCount);
+                ++placed;
+            }
+            else {
+                line += "lorem ipsum ";
+            }
+        }
+
+        return line;
+    }
+
+    arti::variable_store makeVars() {
+        arti::variable_store vars;
+
+        for (std::size_t i = 0; i < VariableCount; ++i) {
+            vars.set(fmt::format("var{}", i), fmt::format("value_{}", i));
+        }
+
+        return vars;
+    }
+
+    void writeFile(const fs::path &path, std::string_view content) {
+        std::ofstream{ path } << content;
+    }
+
+    // Scratch config holding 'templateCount' file templates, all of them
+    // rendering the same source with a big vars.toml
+    class fixture {
+      public:
+        fixture(std::size_t templateCount, std::size_t fileVars, std::size_t sourceLines)
+            : m_Root(fs::temp_directory_path() / fmt::format("arti-gen-bench-{}-{}", ::getpid(), s_Created++)) {
+            fs::create_directories(m_Root / "file-template");
+
+            std::string config;
+
+            for (std::size_t i = 0; i < templateCount; ++i) {
+                config += fmt::format(
+                    "[t{}]\n"
+                    "type = \"file\"\n"
+                    "name = \"t{}\"\n"
+                    "root = \"{{{{ name }}}}.txt\"\n"
+                    "folder = \"file-template\"\n\n",
+                    i,
+                    i
+                );
+            }
+
+            writeFile(m_Root / "config.toml", config);
+
+            std::string vars;
+
+            for (std::size_t i = 0; i < fileVars; ++i) {
+                vars += fmt::format("file_var{} = \"value {}\"\n", i, i);
+            }
+
+            writeFile(m_Root / "file-template" / "vars.toml", vars);
+
+            std::string source;
+
+            for (std::size_t i = 0; i < sourceLines; ++i) {
+                source += makeLine(80, i % 4 == 0 ? 3 : 0);
+                source += '\n';
+            }
+
+            writeFile(m_Root / "file-template" / "{{ name }}.txt", source);
+        }
+
+        ~fixture() {
+            std::error_code ec;
+            fs::remove_all(m_Root, ec);
+        }
+
+        fixture(fixture &&) = delete;
+        fixture(const fixture &) = delete;
+
+        fixture &operator=(fixture &&) = delete;
+        fixture &operator=(const fixture &) = delete;
+
+        const fs::path &root() const {
+            return m_Root;
+        }
+
+        arti::generator_template load(std::string_view name) const {
+            return arti::generator_template::loadFromConfig(name, m_Root).value();
+        }
+
+      private:
+        static inline std::size_t s_Created = 0;
+
+        fs::path m_Root;
+    };
+
+    opt::variables_map makeParams(std::vector<std::string> defines) {
+        opt::variables_map params;
+
+        params.emplace("name", opt::variable_value{ std::vector<std::string>{ "bench" }, false });
+        params.emplace("define", opt::variable_value{ std::move(defines), false });
+
+        return params;
+    }
+
+    void substitution(nb::Bench &bench) {
+        const auto vars = makeVars();
+
+        for (const std::size_t length : { 80, 1024, 16384 }) {
+            for (const std::size_t density : { 0, 1, 10 }) {
+                const auto line = makeLine(length, density);
+
+                bench.run(fmt::format("variable_substitutor::run/{}B/{}per100", length, density), [&] {
+                    nb::doNotOptimizeAway(arti::variable_substitutor::run(line, vars));
+                });
+            }
+        }
+    }
+
+    // Source-like text: single braces everywhere, a placeholder every 'spacing' bytes
+    std::string makeSource(std::size_t size, std::size_t spacing) {
+        constexpr std::string_view Line = "    if (value) { return compute(value, { 1, 2 }); }\n";
+
+        std::string source;
+        source.reserve(size + spacing);
+
+        std::size_t nextPlaceholder = spacing;
+
+        while (source.size() < size) {
+            source += Line;
+
+            if (source.size() >= nextPlaceholder) {
+                source += "{{ name }}\n";
+                nextPlaceholder += spacing;
+            }
+        }
+
+        return source;
+    }
+
+    void scanning(nb::Bench &bench) {
+        using scanner = arti::utils::scanner;
+
+        constexpr std::size_t Size = 1 << 20;
+
+        // Reported as bytes per second, the GB/s figure compares the scanners directly
+        bench.unit("byte").batch(Size);
+
+        for (const std::size_t spacing : { std::size_t{ 256 }, std::size_t{ 4096 }, Size }) {
+            const auto source = makeSource(Size, spacing);
+
+            bench.run(fmt::format("std::string_view::find/{}B", spacing), [&] {
+                std::size_t found = 0;
+
+                for (auto pos = source.find("{{"); pos != std::string::npos; pos = source.find("{{", pos + 2)) {
+                    ++found;
+                }
+
+                nb::doNotOptimizeAway(found);
+            });
+
+            for (const auto kernel : { scanner::kernels::Scalar, scanner::kernels::SSE2, scanner::kernels::AVX2 }) {
+                if (! scanner::supported(kernel)) {
+                    continue;
+                }
+
+                bench.run(fmt::format("scanner::findOpening/{}/{}B", scanner::name(kernel), spacing), [&] {
+                    std::size_t found = 0;
+
+                    for (auto pos = scanner::findOpening(source, 0, kernel); pos != std::string::npos; pos = scanner::findOpening(source, pos + 2, kernel)) {
+                        ++found;
+                    }
+
+                    nb::doNotOptimizeAway(found);
+                });
+            }
+
+            bench.run(fmt::format("compiled_template::compileView/{}B", spacing), [&] {
+                nb::doNotOptimizeAway(arti::compiled_template::compileView(source));
+            });
+        }
+
+        bench.unit("op").batch(1);
+    }
+
+    void variableGraphs(nb::Bench &bench, const fixture &scratch) {
+        const auto template_v = scratch.load("t0");
+
+        for (const std::size_t size : { 100, 1000, 10000 }) {
+            // Chains of 10 variables each referencing the next one
+            std::vector<std::string> defines;
+            defines.reserve(size);
+
+            for (std::size_t i = 0; i < size; ++i) {
+                defines.push_back(i % 10 == 9
+                    ? fmt::format("graph{}=leaf {}", i, i)
+                    : fmt::format("graph{}={{{{ graph{} }}}}", i, i + 1));
+            }
+
+            const auto params = makeParams(std::move(defines));
+
+            bench.run(fmt::format("generator::loadVars/{}vars", size), [&] {
+                arti::generator gen{ template_v };
+                nb::doNotOptimizeAway(gen.loadVars(params));
+            });
+        }
+    }
+
+    void templateLoading(nb::Bench &bench) {
+        for (const std::size_t count : { 10, 1000 }) {
+            const fixture scratch{ count, 0, 1 };
+            const auto last = fmt::format("t{}", count - 1);
+
+            bench.run(fmt::format("generator_template::loadFromConfig/{}templates", count), [&] {
+                nb::doNotOptimizeAway(arti::generator_template::loadFromConfig(last, scratch.root()));
+            });
+        }
+
+        const fixture scratch{ 1, 1000, 1 };
+        auto template_v = scratch.load("t0");
+
+        bench.run("generator_template::loadDefaultVars/1000vars", [&] {
+            template_v.loadDefaultVars();
+        });
+    }
+
+    void fileRendering(nb::Bench &bench, const fixture &scratch) {
+        const auto template_v = scratch.load("t0");
+        const auto program = arti::template_program::compile(template_v).value();
+        const auto &content = program.entries().front().content;
+
+        auto vars = makeVars();
+        vars.set("name", "bench");
+
+        bench.run("compiled_template::render/4KB", [&] {
+            nb::doNotOptimizeAway(content.render(vars));
+        });
+
+        const auto filtered = arti::compiled_template::compile(std::string{ "class {{ name | pascal }} { int {{ name | snake | upper }}; };\n" });
+        const auto filteredValues = filtered.bind(vars);
+        std::string filteredOut;
+
+        bench.run("compiled_template::renderTo/filters", [&] {
+            filteredOut.clear();
+            filtered.renderTo(filteredOut, filteredValues);
+            nb::doNotOptimizeAway(filteredOut);
+        });
+
+        vars.set("libraries", "fmt/9.1.0, boost/1.80.0, ctre/3.7.1, tomlplusplus/3.2.0");
+        vars.set("tests", "true");
+
+        const auto flow = arti::compiled_template::compile(std::string{
+            "[requires]\n{% for lib in libraries %}\n{{ lib }}\n{% endfor %}\n{% if tests %}\ngtest/1.12.1\n{% endif %}\n"
+        });
+        const auto flowValues = flow.bind(vars);
+        std::string flowOut;
+
+        bench.run("compiled_template::renderTo/control-flow", [&] {
+            flowOut.clear();
+            flow.renderTo(flowOut, flowValues);
+            nb::doNotOptimizeAway(flowOut);
+        });
+
+        bench.run("template_program::compile/file", [&] {
+            nb::doNotOptimizeAway(arti::template_program::compile(template_v));
+        });
+
+        const auto params = makeParams({});
+        const auto output = scratch.root() / "out";
+        fs::create_directories(output);
+
+        arti::generator gen{ template_v };
+
+        if (! gen.loadVars(params)) {
+            return;
+        }
+
+        arti::generator::run_options options;
+        options.outputRoot = output;
+
+        // Includes creating and removing the output file
+        bench.run("generator::run/file", [&] {
+            arti::generator::run_report report;
+            nb::doNotOptimizeAway(gen.run(program, options, report));
+            fs::remove(output / "bench.txt");
+        });
+    }
+
+}
+
+int main(int argc, char *argv[]) {
+    const fs::path jsonPath = argc > 1 ? argv[1] : "arti-gen-bench.json";
+
+    nb::Bench bench;
+    bench.title("arti-gen").warmup(10).minEpochIterations(20).output(&std::cout);
+
+    {
+        const fixture scratch{ 1, 16, 50 };
+
+        substitution(bench);
+        scanning(bench);
+        variableGraphs(bench, scratch);
+        fileRendering(bench, scratch);
+    }
+
+    templateLoading(bench);
+
+    std::ofstream json{ jsonPath };
+
+    if (! json) {
+        fmt::print(stderr, "Couldn't write the results to '{}'\n", jsonPath.string());
+        return 1;
+    }
+
+    nb::render(nb::templates::json(), bench, json);
+
+    fmt::print("Results written to '{}'\n", jsonPath.string());
+}
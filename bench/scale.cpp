@@ -0,0 +1,790 @@
+#include <array>
+#include <chrono>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <optional>
+#include <algorithm>
+#include <charconv>
+#include <filesystem>
+#include <string_view>
+#include <unordered_map>
+
+#include <unistd.h>
+#include <sys/vfs.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include <linux/magic.h>
+
+#include <fmt/format.h>
+
+#include <boost/program_options.hpp>
+
+#include "generator.hpp"
+#include "generator_template.hpp"
+#include "template_program.hpp"
+
+#include "utils/io.hpp"
+#include "utils/json.hpp"
+#include "utils/trace.hpp"
+
+namespace fs = std::filesystem;
+namespace opt = boost::program_options;
+
+using arti::utils::trace;
+using arti::utils::io_backend;
+
+namespace {
+
+    constexpr std::size_t VariableCount = 16;
+    constexpr std::string_view TemplateName = "scale";
+
+    struct corpus_options {
+        std::size_t files = 2000;
+        std::size_t depth = 4;
+        std::size_t branching = 4;
+        // 'size:weight' buckets, every file's size is drawn around one of them
+        std::string sizes = "512:60,4096:30,65536:9,1048576:1";
+        // Placeholders per KiB of text
+        std::size_t density = 4;
+        double binary = 0.05;
+        uint64_t seed = 1;
+    };
+
+    struct bucket {
+        std::size_t size;
+        std::size_t weight;
+    };
+
+    std::optional<std::vector<bucket>> parseSizes(std::string_view spec) {
+        std::vector<bucket> buckets;
+
+        while (! spec.empty()) {
+            const auto comma = spec.find(',');
+            const auto item = spec.substr(0, comma);
+            const auto colon = item.find(':');
+
+            bucket current{ 0, 1 };
+
+            const auto sizeEnd = item.data() + (colon == std::string_view::npos ? item.size() : colon);
+
+            if (std::from_chars(item.data(), sizeEnd, current.size).ptr != sizeEnd || current.size == 0) {
+                return std::nullopt;
+            }
+
+            if (colon != std::string_view::npos) {
+                const auto weight = item.substr(colon + 1);
+
+                if (std::from_chars(weight.data(), weight.data() + weight.size(), current.weight).ptr != weight.data() + weight.size()) {
+                    return std::nullopt;
+                }
+            }
+
+            buckets.push_back(current);
+            spec = comma == std::string_view::npos ? std::string_view{} : spec.substr(comma + 1);
+        }
+
+        if (buckets.empty()) {
+            return std::nullopt;
+        }
+
+        return buckets;
+    }
+
+    std::string makeText(std::size_t size, std::size_t density, std::mt19937_64 &rng) {
+        constexpr std::string_view Words[] = { "lorem ", "ipsum ", "dolor ", "sit ", "amet, ", "{ return value; }\n", "consectetur\n" };
+
+        std::string text;
+        text.reserve(size + 32);
+
+        // Mean distance between placeholders, text without any when 'density' is 0
+        const std::size_t spacing = density > 0 ? 1024 / density : 0;
+        std::size_t nextPlaceholder = spacing > 0 ? rng() % (2 * spacing) : size;
+
+        while (text.size() < size) {
+            if (text.size() >= nextPlaceholder) {
+                text += fmt::format("{{{{ var{} }}}}", rng() % VariableCount);
+                nextPlaceholder = text.size() + 1 + rng() % (2 * spacing);
+            }
+            else {
+                text += Words[rng() % std::size(Words)];
+            }
+        }
+
+        return text;
+    }
+
+    std::string makeBinary(std::size_t size, std::mt19937_64 &rng) {
+        std::string data(size, '\0');
+
+        for (auto &byte : data) {
+            byte = static_cast<char>(rng() & 0xff);
+        }
+
+        // Guarantees the NUL byte binary detection looks for
+        data[0] = '\0';
+
+        return data;
+    }
+
+    struct corpus_summary {
+        std::size_t files = 0;
+        std::size_t directories = 0;
+        std::size_t binaryFiles = 0;
+        uint64_t bytes = 0;
+    };
+
+    // Writes a config with a single folder template 'scale' below 'configRoot': 'depth' levels of
+    // 'branching' directories each, the files spread over all of them. A directory in every
+    // 'branching' and a file in every 4 have a placeholder in their name.
+    corpus_summary writeCorpus(const fs::path &configRoot, const corpus_options &options, const std::vector<bucket> &buckets) {
+        std::mt19937_64 rng{ options.seed };
+
+        const auto templateRoot = configRoot / "scale-template" / "{{ name }}";
+        fs::create_directories(templateRoot);
+
+        std::ofstream{ configRoot / "config.toml" } << fmt::format(
+            "[{}]\n"
+            "type = \"folder\"\n"
+            "name = \"{}\"\n"
+            "root = \"{{{{ name }}}}\"\n"
+            "folder = \"scale-template\"\n",
+            TemplateName,
+            TemplateName
+        );
+
+        corpus_summary summary;
+
+        std::vector<fs::path> directories{ templateRoot };
+        std::vector<fs::path> level{ templateRoot };
+
+        for (std::size_t d = 0; d < options.depth; ++d) {
+            std::vector<fs::path> next;
+
+            for (const auto &parent : level) {
+                for (std::size_t b = 0; b < options.branching; ++b) {
+                    const auto name = b == 0
+                        ? fmt::format("d{}-{{{{ var{} }}}}", directories.size(), directories.size() % VariableCount)
+                        : fmt::format("d{}", directories.size());
+
+                    auto path = parent / name;
+                    fs::create_directory(path);
+
+                    directories.push_back(path);
+                    next.push_back(std::move(path));
+                }
+            }
+
+            level = std::move(next);
+        }
+
+        summary.directories = directories.size() - 1;
+
+        std::size_t totalWeight = 0;
+
+        for (const auto &current : buckets) {
+            totalWeight += current.weight;
+        }
+
+        std::bernoulli_distribution isBinary{ std::clamp(options.binary, 0.0, 1.0) };
+
+        for (std::size_t i = 0; i < options.files; ++i) {
+            auto pick = rng() % std::max<std::size_t>(totalWeight, 1);
+            auto chosen = buckets.front();
+
+            for (const auto &current : buckets) {
+                if (pick < current.weight) {
+                    chosen = current;
+                    break;
+                }
+
+                pick -= current.weight;
+            }
+
+            // Somewhere between half and one and a half times the bucket's size
+            const auto size = chosen.size / 2 + rng() % (chosen.size + 1);
+            const bool binary = isBinary(rng);
+
+            const auto name = i % 4 == 0
+                ? fmt::format("f{}-{{{{ var{} }}}}.{}", i, i % VariableCount, binary ? "bin" : "txt")
+                : fmt::format("f{}.{}", i, binary ? "bin" : "txt");
+
+            const auto content = binary ? makeBinary(size, rng) : makeText(size, options.density, rng);
+
+            std::ofstream{ directories[i % directories.size()] / name, std::ios::binary } << content;
+
+            summary.files += 1;
+            summary.binaryFiles += binary ? 1 : 0;
+            summary.bytes += content.size();
+        }
+
+        return summary;
+    }
+
+    struct target {
+        std::string name;
+        fs::path directory;
+        bool tmpfs = false;
+    };
+
+    std::optional<bool> isTmpfs(const fs::path &path) {
+        struct statfs st;
+
+        if (::statfs(path.c_str(), &st) != 0) {
+            return std::nullopt;
+        }
+
+        return st.f_type == TMPFS_MAGIC;
+    }
+
+    // Only the counters that are syscalls, io_uring operations are reported on their own
+    constexpr std::array SyscallCounters{
+        std::pair{ trace::counters::OpenCalls, "open" },
+        std::pair{ trace::counters::ReadCalls, "read" },
+        std::pair{ trace::counters::WriteCalls, "write" },
+        std::pair{ trace::counters::StatCalls, "stat" },
+        std::pair{ trace::counters::MkdirCalls, "mkdir" },
+        std::pair{ trace::counters::MapCalls, "mmap" },
+        std::pair{ trace::counters::RingEnterCalls, "io_uring_enter" }
+    };
+
+    struct sample {
+        bool ok = false;
+        uint64_t wallNs = 0;
+        uint64_t peakRssKb = 0;
+        std::array<uint64_t, static_cast<std::size_t>(trace::counters::Count)> counters{};
+    };
+
+    // One whole invocation, loading and compiling the template included, in a child process so its
+    // peak RSS and counters are its own. 'traced' enables the counters, which also records spans.
+    sample measure(const fs::path &configRoot, const fs::path &outputRoot, io_backend::kinds io, std::size_t jobs, bool traced) {
+        int fds[2];
+
+        if (::pipe(fds) != 0) {
+            return {};
+        }
+
+        const pid_t child = ::fork();
+
+        if (child < 0) {
+            ::close(fds[0]);
+            ::close(fds[1]);
+            return {};
+        }
+
+        if (child == 0) {
+            ::close(fds[0]);
+
+            if (traced) {
+                trace::enable();
+            }
+
+            sample result;
+
+            const auto start = std::chrono::steady_clock::now();
+
+            const auto status = [&]() -> tl::expected<void, std::string> {
+                auto template_v = arti::generator_template::loadFromConfig(TemplateName, configRoot);
+
+                if (! template_v) {
+                    return tl::unexpected{ template_v.error().info };
+                }
+
+                const auto program = arti::template_program::compile(*template_v);
+
+                if (! program) {
+                    return tl::unexpected{ program.error() };
+                }
+
+                opt::variables_map params;
+                std::vector<std::string> defines;
+
+                for (std::size_t i = 0; i < VariableCount; ++i) {
+                    defines.push_back(fmt::format("var{}=value_{}", i, i));
+                }
+
+                params.emplace("name", opt::variable_value{ std::vector<std::string>{ "out" }, false });
+                params.emplace("define", opt::variable_value{ std::move(defines), false });
+
+                arti::generator gen{ *template_v };
+
+                if (auto loaded = gen.loadVars(params); ! loaded) {
+                    return loaded;
+                }
+
+                arti::generator::run_options options;
+                options.outputRoot = outputRoot;
+                options.jobs = jobs;
+                options.io = io;
+
+                arti::generator::run_report report;
+                return gen.run(*program, options, report);
+            }();
+
+            result.wallNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+            result.ok = status.has_value();
+
+            if (! status) {
+                fmt::print(stderr, "  {}\n", status.error());
+            }
+
+            for (std::size_t i = 0; i < result.counters.size(); ++i) {
+                result.counters[i] = trace::get(static_cast<trace::counters>(i));
+            }
+
+            [[maybe_unused]] const auto written = ::write(fds[1], &result, sizeof(result));
+            ::_exit(result.ok ? 0 : 1);
+        }
+
+        ::close(fds[1]);
+
+        sample result;
+        const bool received = ::read(fds[0], &result, sizeof(result)) == static_cast<ssize_t>(sizeof(result));
+        ::close(fds[0]);
+
+        int status = 0;
+        struct rusage usage {};
+
+        if (::wait4(child, &status, 0, &usage) < 0 || ! received) {
+            return {};
+        }
+
+        // Kilobytes on Linux
+        result.peakRssKb = static_cast<uint64_t>(usage.ru_maxrss);
+        result.ok = result.ok && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+
+        return result;
+    }
+
+    uint64_t sizeOf(const fs::path &root) {
+        uint64_t total = 0;
+        std::error_code ec;
+
+        for (const auto &entry : fs::recursive_directory_iterator{ root, ec }) {
+            if (entry.is_regular_file(ec)) {
+                total += entry.file_size(ec);
+            }
+        }
+
+        return total;
+    }
+
+    struct result {
+        std::string name;
+        std::string target;
+        std::string io;
+        std::size_t jobs = 0;
+        bool tmpfs = false;
+        double wallMs = 0;
+        double filesPerSecond = 0;
+        double mbPerSecond = 0;
+        uint64_t peakRssKb = 0;
+        uint64_t syscalls = 0;
+        uint64_t ringOperations = 0;
+        std::array<uint64_t, SyscallCounters.size()> calls{};
+    };
+
+    // A single line per result, so a baseline is read back without a JSON parser
+    std::string toJson(const result &current) {
+        std::string calls;
+
+        for (std::size_t i = 0; i < SyscallCounters.size(); ++i) {
+            calls += fmt::format("{}\"{}\": {}", i > 0 ? ", " : "", SyscallCounters[i].second, current.calls[i]);
+        }
+
+        return fmt::format(
+            "{{\"name\": \"{}\", \"target\": \"{}\", \"tmpfs\": {}, \"io\": \"{}\", \"jobs\": {}, \"wall_ms\": {:.3f}, "
+            "\"files_per_s\": {:.1f}, \"mb_per_s\": {:.2f}, \"peak_rss_kb\": {}, \"syscalls\": {}, \"io_uring_ops\": {}, \"calls\": {{{}}}}}",
+            arti::utils::escapeJson(current.name),
+            arti::utils::escapeJson(current.target),
+            current.tmpfs,
+            current.io,
+            current.jobs,
+            current.wallMs,
+            current.filesPerSecond,
+            current.mbPerSecond,
+            current.peakRssKb,
+            current.syscalls,
+            current.ringOperations,
+            calls
+        );
+    }
+
+    std::optional<std::string_view> stringField(std::string_view line, std::string_view key) {
+        const auto marker = fmt::format("\"{}\": \"", key);
+        const auto pos = line.find(marker);
+
+        if (pos == std::string_view::npos) {
+            return std::nullopt;
+        }
+
+        const auto start = pos + marker.size();
+        const auto end = line.find('"', start);
+
+        if (end == std::string_view::npos) {
+            return std::nullopt;
+        }
+
+        return line.substr(start, end - start);
+    }
+
+    std::optional<double> numberField(std::string_view line, std::string_view key) {
+        const auto marker = fmt::format("\"{}\": ", key);
+        const auto pos = line.find(marker);
+
+        if (pos == std::string_view::npos) {
+            return std::nullopt;
+        }
+
+        double value = 0;
+        const auto start = line.data() + pos + marker.size();
+
+        if (std::from_chars(start, line.data() + line.size(), value).ec != std::errc{}) {
+            return std::nullopt;
+        }
+
+        return value;
+    }
+
+    struct baseline_entry {
+        double wallMs = 0;
+        double peakRssKb = 0;
+        double syscalls = 0;
+    };
+
+    std::optional<std::unordered_map<std::string, baseline_entry>> readBaseline(const fs::path &path) {
+        std::ifstream file{ path };
+
+        if (! file) {
+            return std::nullopt;
+        }
+
+        std::unordered_map<std::string, baseline_entry> entries;
+        std::string line;
+
+        while (std::getline(file, line)) {
+            const auto name = stringField(line, "name");
+            const auto wall = numberField(line, "wall_ms");
+
+            if (! name || ! wall) {
+                continue;
+            }
+
+            entries[std::string{ *name }] = baseline_entry{
+                *wall,
+                numberField(line, "peak_rss_kb").value_or(0),
+                numberField(line, "syscalls").value_or(0)
+            };
+        }
+
+        return entries;
+    }
+
+    // Prints every metric that got more than 'threshold' percent worse, the count of regressions
+    std::size_t compare(const std::vector<result> &results, const std::unordered_map<std::string, baseline_entry> &baseline, double threshold) {
+        std::size_t regressions = 0;
+
+        fmt::print("\nCompared with the baseline (threshold {}%):\n", threshold);
+
+        for (const auto &current : results) {
+            const auto found = baseline.find(current.name);
+
+            if (found == baseline.end()) {
+                fmt::print("  {:<24} not in the baseline\n", current.name);
+                continue;
+            }
+
+            const auto check = [&](std::string_view metric, double before, double now) {
+                const double change = before > 0 ? (now - before) * 100.0 / before : 0.0;
+                const bool regressed = change > threshold;
+
+                regressions += regressed ? 1 : 0;
+
+                return fmt::format("{} {:+.1f}%{}", metric, change, regressed ? " REGRESSION" : "");
+            };
+
+            fmt::print(
+                "  {:<24} {}, {}, {}\n",
+                current.name,
+                check("wall", found->second.wallMs, current.wallMs),
+                check("rss", found->second.peakRssKb, static_cast<double>(current.peakRssKb)),
+                check("syscalls", found->second.syscalls, static_cast<double>(current.syscalls))
+            );
+        }
+
+        return regressions;
+    }
+
+    std::vector<std::string> splitList(std::string_view list) {
+        std::vector<std::string> items;
+
+        while (! list.empty()) {
+            const auto comma = list.find(',');
+
+            if (const auto item = list.substr(0, comma); ! item.empty()) {
+                items.emplace_back(item);
+            }
+
+            list = comma == std::string_view::npos ? std::string_view{} : list.substr(comma + 1);
+        }
+
+        return items;
+    }
+
+}
+
+int main(int argc, char *argv[]) {
+    corpus_options corpus;
+
+    opt::options_description description{ "arti-gen-scale: generates a synthetic folder template and times whole runs of it" };
+    auto optionsDef = description.add_options();
+
+    optionsDef("files", opt::value(&corpus.files)->default_value(corpus.files), "Number of files in the template");
+    optionsDef("depth", opt::value(&corpus.depth)->default_value(corpus.depth), "Levels of directories below the template's root");
+    optionsDef("branching", opt::value(&corpus.branching)->default_value(corpus.branching), "Directories in every directory but the last level");
+    optionsDef("sizes", opt::value(&corpus.sizes)->default_value(corpus.sizes), "File size distribution as 'size:weight' buckets in bytes");
+    optionsDef("density", opt::value(&corpus.density)->default_value(corpus.density), "Placeholders per KiB of text");
+    optionsDef("binary", opt::value(&corpus.binary)->default_value(corpus.binary), "Fraction of binary files, copied as they are");
+    optionsDef("seed", opt::value(&corpus.seed)->default_value(corpus.seed), "Seed of the corpus' contents");
+    optionsDef("jobs,j", opt::value<std::string>()->default_value(""), "Comma separated thread counts to sweep, '1,2,4' and every core by default");
+    optionsDef("io", opt::value<std::string>()->default_value("sync,uring"), "Comma separated I/O backends to sweep");
+    optionsDef("tmpfs", opt::value<std::string>()->default_value("/dev/shm"), "tmpfs directory the output is generated into, empty skips it");
+    optionsDef("disk", opt::value<std::string>()->default_value("."), "On disk directory the output is generated into, empty skips it");
+    optionsDef("repeat,r", opt::value<std::size_t>()->default_value(5), "Timed runs per configuration, the median is kept");
+    optionsDef("output,o", opt::value<std::string>()->default_value("arti-gen-scale.json"), "Where the results are written as JSON");
+    optionsDef("compare", opt::value<std::string>(), "Baseline written by an earlier run, exits with 1 when anything regressed");
+    optionsDef("threshold", opt::value<double>()->default_value(10.0), "Percentage a metric may get worse before it's a regression");
+    optionsDef("help,h", "Prints this help message");
+
+    opt::variables_map options;
+
+    try {
+        opt::store(opt::parse_command_line(argc, argv, description), options);
+        opt::notify(options);
+    }
+    catch (const opt::error &err) {
+        fmt::print(stderr, "{}\n", err.what());
+        return 2;
+    }
+
+    if (options.contains("help")) {
+        std::ostringstream help;
+        help << description;
+        fmt::print("{}", help.str());
+        return 0;
+    }
+
+    const auto buckets = parseSizes(corpus.sizes);
+
+    if (! buckets) {
+        fmt::print(stderr, "Invalid '--sizes' distribution '{}'\n", corpus.sizes);
+        return 2;
+    }
+
+    std::vector<std::size_t> jobCounts;
+
+    for (const auto &item : splitList(options["jobs"].as<std::string>())) {
+        std::size_t jobs = 0;
+
+        if (std::from_chars(item.data(), item.data() + item.size(), jobs).ptr != item.data() + item.size() || jobs == 0) {
+            fmt::print(stderr, "Invalid thread count '{}'\n", item);
+            return 2;
+        }
+
+        jobCounts.push_back(jobs);
+    }
+
+    if (jobCounts.empty()) {
+        jobCounts = { 1, 2, 4 };
+
+        if (const std::size_t cores = std::thread::hardware_concurrency(); cores > 4) {
+            jobCounts.push_back(cores);
+        }
+    }
+
+    std::vector<io_backend::kinds> backends;
+
+    for (const auto &item : splitList(options["io"].as<std::string>())) {
+        const auto kind = io_backend::parse(item);
+
+        if (! kind) {
+            fmt::print(stderr, "Unknown I/O backend '{}'\n", item);
+            return 2;
+        }
+
+        // Nothing to measure when the kernel doesn't support it
+        if (*kind == io_backend::kinds::Uring && ! io_backend::create(*kind, 1)) {
+            fmt::print("io_uring isn't available, skipped\n");
+            continue;
+        }
+
+        backends.push_back(*kind);
+    }
+
+    std::vector<target> targets;
+
+    for (const auto &[name, option] : { std::pair{ "tmpfs", "tmpfs" }, std::pair{ "disk", "disk" } }) {
+        const auto directory = options[option].as<std::string>();
+
+        if (directory.empty()) {
+            continue;
+        }
+
+        const auto tmpfs = isTmpfs(directory);
+
+        if (! tmpfs) {
+            fmt::print("'{}' isn't accessible, the {} target is skipped\n", directory, name);
+            continue;
+        }
+
+        if (*tmpfs != (std::string_view{ name } == "tmpfs")) {
+            fmt::print("Warning: '{}' is {}on tmpfs\n", directory, *tmpfs ? "" : "not ");
+        }
+
+        targets.push_back(target{ name, fs::absolute(directory) / fmt::format("arti-gen-scale-{}", ::getpid()), *tmpfs });
+    }
+
+    const auto configRoot = fs::temp_directory_path() / fmt::format("arti-gen-scale-config-{}", ::getpid());
+    const auto summary = writeCorpus(configRoot, corpus, *buckets);
+
+    fmt::print(
+        "Corpus: {} files ({} binary), {} directories, {:.1f} MiB\n",
+        summary.files,
+        summary.binaryFiles,
+        summary.directories,
+        summary.bytes / (1024.0 * 1024.0)
+    );
+
+    const std::size_t repeat = std::max<std::size_t>(options["repeat"].as<std::size_t>(), 1);
+
+    std::vector<result> results;
+    bool failed = false;
+    std::size_t runs = 0;
+
+    for (const auto &current : targets) {
+        for (const auto io : backends) {
+            for (const auto jobs : jobCounts) {
+                result entry;
+                entry.name = fmt::format("{}/{}/j{}", current.name, io_backend::name(io), jobs);
+                entry.target = current.name;
+                entry.io = io_backend::name(io);
+                entry.jobs = jobs;
+                entry.tmpfs = current.tmpfs;
+
+                std::vector<uint64_t> walls;
+                uint64_t outputBytes = 0;
+
+                // The first run is traced for the counters and not timed, span recording has a cost
+                for (std::size_t i = 0; i <= repeat; ++i) {
+                    const auto outputRoot = current.directory / fmt::format("run-{}", runs++);
+                    fs::create_directories(outputRoot);
+
+                    const auto measured = measure(configRoot, outputRoot, io, jobs, i == 0);
+
+                    if (! measured.ok) {
+                        fmt::print(stderr, "{} failed\n", entry.name);
+                        failed = true;
+                    }
+                    else if (i == 0) {
+                        outputBytes = sizeOf(outputRoot);
+                        entry.ringOperations = measured.counters[static_cast<std::size_t>(trace::counters::RingOperations)];
+
+                        for (std::size_t c = 0; c < SyscallCounters.size(); ++c) {
+                            entry.calls[c] = measured.counters[static_cast<std::size_t>(SyscallCounters[c].first)];
+                            entry.syscalls += entry.calls[c];
+                        }
+                    }
+                    else {
+                        walls.push_back(measured.wallNs);
+                        entry.peakRssKb = std::max(entry.peakRssKb, measured.peakRssKb);
+                    }
+
+                    std::error_code ec;
+                    fs::remove_all(outputRoot, ec);
+                }
+
+                if (walls.empty()) {
+                    continue;
+                }
+
+                std::sort(walls.begin(), walls.end());
+
+                const double seconds = walls[walls.size() / 2] / 1e9;
+
+                entry.wallMs = seconds * 1e3;
+                entry.filesPerSecond = summary.files / seconds;
+                entry.mbPerSecond = outputBytes / (1024.0 * 1024.0) / seconds;
+
+                fmt::print(
+                    "{:<24} {:>10.2f} ms {:>12.0f} files/s {:>9.1f} MiB/s {:>9} KiB rss {:>8} syscalls\n",
+                    entry.name,
+                    entry.wallMs,
+                    entry.filesPerSecond,
+                    entry.mbPerSecond,
+                    entry.peakRssKb,
+                    entry.syscalls
+                );
+
+                results.push_back(std::move(entry));
+            }
+        }
+    }
+
+    std::error_code ec;
+    fs::remove_all(configRoot, ec);
+
+    for (const auto &current : targets) {
+        fs::remove_all(current.directory, ec);
+    }
+
+    const fs::path jsonPath = options["output"].as<std::string>();
+    std::ofstream json{ jsonPath };
+
+    if (! json) {
+        fmt::print(stderr, "Couldn't write the results to '{}'\n", jsonPath.string());
+        return 1;
+    }
+
+    json << fmt::format(
+        "{{\n\"corpus\": {{\"files\": {}, \"depth\": {}, \"branching\": {}, \"sizes\": \"{}\", \"density\": {}, \"binary\": {}, "
+        "\"seed\": {}, \"directories\": {}, \"binary_files\": {}, \"bytes\": {}}},\n\"repeat\": {},\n\"results\": [\n",
+        corpus.files,
+        corpus.depth,
+        corpus.branching,
+        arti::utils::escapeJson(corpus.sizes),
+        corpus.density,
+        corpus.binary,
+        corpus.seed,
+        summary.directories,
+        summary.binaryFiles,
+        summary.bytes,
+        repeat
+    );
+
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        json << toJson(results[i]) << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+
+    json << "]\n}\n";
+
+    fmt::print("Results written to '{}'\n", jsonPath.string());
+
+    if (options.contains("compare")) {
+        const fs::path baselinePath = options["compare"].as<std::string>();
+        const auto baseline = readBaseline(baselinePath);
+
+        if (! baseline) {
+            fmt::print(stderr, "Couldn't read the baseline '{}'\n", baselinePath.string());
+            return 1;
+        }
+
+        if (compare(results, *baseline, options["threshold"].as<double>()) > 0) {
+            return 1;
+        }
+    }
+
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <string>
+#include <memory>
+#include <vector>
+#include <functional>
+#include <filesystem>
+#include <string_view>
+
+#include <boost/program_options.hpp>
+
+#include "utils/error.hpp"
+
+#include "generator.hpp"
+#include "generator_template.hpp"
+#include "template_program.hpp"
+#include "variable_store.hpp"
+
+namespace fs = std::filesystem;
+namespace opt = boost::program_options;
+
+namespace arti {
+
+    // Generates many instances of one template, loading and compiling it only once
+    class batch {
+      public:
+        enum class errors {
+            NotFound,
+            ParseError
+        };
+
+        struct instance {
+            std::string label;
+            variable_store vars;
+        };
+
+        using instances_t = std::vector<instance>;
+        using output_t = std::function<void(std::string_view)>;
+        using expected_t = arti::expected<instances_t, errors>;
+
+        // TOML manifests use 'names = [...]' and/or '[[instance]]' tables,
+        // JSONL manifests (.jsonl/.json) hold one name string or flat object per line
+        static expected_t loadManifest(const fs::path &manifest);
+        static instances_t fromNames(const std::vector<std::string> &names);
+
+        batch() = delete;
+        ~batch() = default;
+
+        batch(generator_template template_v, std::shared_ptr<const template_program> program, instances_t instances);
+
+        batch(batch &&) = default;
+        batch(const batch &) = default;
+
+        batch &operator=(batch &&) = default;
+        batch &operator=(const batch &) = default;
+
+        // Per instance results and the summary are written to 'output'
+        tl::expected<void, std::string> run(const opt::variables_map &params, const generator::run_options &options, const output_t &output) const;
+
+      private:
+        generator_template m_Template;
+        std::shared_ptr<const template_program> m_Program;
+        instances_t m_Instances;
+    };
+
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <ctime>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <vector>
+#include <optional>
+#include <filesystem>
+#include <string_view>
+#include <unordered_map>
+
+#include "variable_store.hpp"
+
+namespace fs = std::filesystem;
+
+namespace arti {
+
+    // The built-in variables of a run: 'now', 'today', 'year', 'cwd', 'full_cwd', 'hostname', 'user',
+    // 'git_user', 'git_email', 'uuid', 'random_seed' and 'env_<NAME>' for any environment variable.
+    // Each one is only computed once something references it, then kept for the rest of the run.
+    // A run generating several projects gives each one its own 'uuid' and 'random_seed'.
+    // Safe to share between threads.
+    class builtin_providers {
+      public:
+        // Variables by name, as the client of a daemon sent them
+        using environment_t = std::unordered_map<std::string, std::string>;
+        using environment_ptr = std::shared_ptr<const environment_t>;
+
+        // An empty 'cwd' is the process' current directory. Without an 'environment', 'env_*', 'user'
+        // and the git config locations come from the process' own.
+        explicit builtin_providers(fs::path cwd = {}, environment_ptr environment = nullptr);
+        // One more project of 'run': its 'uuid' and 'random_seed' are its own, anything else is the run's
+        explicit builtin_providers(std::shared_ptr<builtin_providers> run);
+        ~builtin_providers() = default;
+
+        builtin_providers(builtin_providers &&) = delete;
+        builtin_providers(const builtin_providers &) = delete;
+
+        builtin_providers &operator=(builtin_providers &&) = delete;
+        builtin_providers &operator=(const builtin_providers &) = delete;
+
+        static bool provides(std::string_view name);
+
+        // Null for anything but a built-in, or one without a value (an unset environment variable, no git user)
+        std::optional<std::string_view> get(std::string_view name);
+
+        // Sets every built-in 'vars' doesn't define that's in 'referenced', or referenced by the value of
+        // a variable that is, however indirectly. Used before resolving 'vars'.
+        void provide(const std::vector<std::string_view> &referenced, variable_store &vars);
+
+        // Every built-in but the environment ones, for when what's referenced isn't known
+        void provideAll(variable_store &vars);
+
+      private:
+        std::optional<std::string> compute(std::string_view name);
+        const std::tm &localTime();
+        const fs::path &cwd();
+        std::optional<std::string_view> variable(std::string_view name) const;
+        // Reads 'user.name' and 'user.email' from git's system, global and repository config files
+        void readGitConfig();
+
+        std::mutex m_Mutex;
+        // Set for a project, provides every built-in shared by the whole run
+        std::shared_ptr<builtin_providers> m_Run;
+        fs::path m_Cwd;
+        environment_ptr m_Environment;
+        std::optional<std::tm> m_Time;
+        // Node based, the views handed out stay valid
+        std::unordered_map<std::string, std::optional<std::string>> m_Values;
+    };
+
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <string>
+#include <filesystem>
+
+#include <tl/expected.hpp>
+
+#include "command.hpp"
+
+namespace fs = std::filesystem;
+
+namespace arti {
+
+    // Thin client of 'server', forwards a command line and relays its output
+    class client {
+      public:
+        // The exit code of the forwarded command
+        static tl::expected<int, std::string> forward(
+            const fs::path &socketPath,
+            int argc,
+            char *argv[],
+            const fs::path &cwd,
+            const command::output_t &output
+        );
+
+        client() = delete;
+        ~client() = delete;
+
+        client(client &&) = delete;
+        client(const client &) = delete;
+
+        client &operator=(client &&) = delete;
+        client &operator=(const client &) = delete;
+    };
+
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <string>
+#include <memory>
+#include <functional>
+#include <filesystem>
+#include <string_view>
+
+#include <tl/expected.hpp>
+
+#include <boost/program_options.hpp>
+
+#include "generator.hpp"
+#include "template_cache.hpp"
+
+namespace fs = std::filesystem;
+namespace opt = boost::program_options;
+
+namespace arti {
+
+    // One command line invocation, run by the CLI itself and by the 'serve'
+    // daemon on behalf of its clients
+    class command {
+      public:
+        using loaded_ptr = std::shared_ptr<const template_cache::loaded_t>;
+        using loader_t = std::function<tl::expected<loaded_ptr, std::string>(std::string_view, template_cache::modes)>;
+        using output_t = std::function<void(std::string_view)>;
+
+        struct context {
+            // Output root, relative paths and the 'cwd' built-ins are resolved against it
+            fs::path cwd;
+            loader_t loader;
+            output_t output;
+            // Running inside the daemon, '--client' is ignored and '--serve' rejected
+            bool remote = false;
+            // The client's environment when remote, the built-ins read it instead of the process' own
+            builtin_providers::environment_ptr environment = nullptr;
+        };
+
+        // Current directory, the template cache and stdout
+        static context local();
+
+        static int run(int argc, char *argv[], const context &ctx);
+        static int execute(const opt::variables_map &vars, const context &ctx);
+
+        static fs::path socketPath(const opt::variables_map &vars);
+
+        command() = delete;
+        ~command() = delete;
+
+        command(command &&) = delete;
+        command(const command &) = delete;
+
+        command &operator=(command &&) = delete;
+        command &operator=(const command &) = delete;
+
+      private:
+        static void printVersion(const context &ctx);
+        static tl::expected<loaded_ptr, std::string> loadTemplate(const opt::variables_map &vars, const context &ctx);
+        static generator::run_options loadRunOptions(const opt::variables_map &vars, const context &ctx);
+        static bool isBatch(const opt::variables_map &vars);
+        static int runBatch(loaded_ptr loaded, const opt::variables_map &vars, const context &ctx);
+        static int packTemplate(const opt::variables_map &vars, const context &ctx);
+        // Streams the '--render' file, or stdin, to stdout with bounded memory
+        static int renderStream(const opt::variables_map &vars, const context &ctx);
+        // Generates, then regenerates on every change to the template until interrupted
+        static int watchTemplate(loaded_ptr loaded, const opt::variables_map &vars, const context &ctx);
+        // Prints what a run would do as JSON, without touching the output
+        static int printPlan(const generator &gen, const template_cache::loaded_t &loaded, const opt::variables_map &vars, const context &ctx);
+    };
+
+}
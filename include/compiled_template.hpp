@@ -0,0 +1,118 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+#include "filter_chain.hpp"
+#include "variable_store.hpp"
+
+namespace arti {
+
+    // Template text parsed once into literal spans and variable slots,
+    // rendering only concatenates them into a single buffer.
+    // A slot is a variable with its filter chain, '{{ name | snake }}' and '{{ name }}' are two slots.
+    // '{% if %}' and '{% for %}' blocks compile into a few more segment kinds run as bytecode,
+    // a template without any keeps the plain concatenation.
+    class compiled_template {
+      public:
+        struct segment {
+            enum class kinds : uint8_t {
+                Literal,
+                Variable,
+                // Tests whether slot 'offset' is truthy, negated when 'length' is 1
+                Test,
+                // Tests whether the last tested slot equals, or differs from, the source text at 'offset'
+                Equals,
+                NotEquals,
+                // Jumps to segment 'length', unless the last test passed
+                JumpUnless,
+                Jump,
+                // Starts a loop over the comma separated items of slot 'offset'
+                ForBegin,
+                // Moves the innermost loop to its next item, leaving it for segment 'length' after the last
+                ForNext
+            };
+
+            kinds kind;
+            // Literal: offset into the source, Variable: slot index
+            uint64_t offset;
+            uint64_t length;
+        };
+
+        struct placeholder {
+            filter_chain chain;
+            // Right past its closing '}}'
+            std::size_t end;
+        };
+
+        compiled_template() = default;
+        ~compiled_template() = default;
+
+        compiled_template(compiled_template &&) = default;
+        compiled_template(const compiled_template &) = default;
+
+        compiled_template &operator=(compiled_template &&) = default;
+        compiled_template &operator=(const compiled_template &) = default;
+
+        static compiled_template compile(std::string source);
+        // Does not copy 'source', it must outlive the compiled template
+        static compiled_template compileView(std::string_view source);
+
+        // Rebuilds a template parsed earlier (e.g. a cached one) without parsing 'source' again.
+        // Null when the segments don't fit 'source' and 'slots', or their blocks don't nest.
+        static std::optional<compiled_template> fromSegments(std::string_view source, std::vector<segment> segments, std::vector<std::string> slots);
+
+        // The '{{ ... }}' opening at 'pos', null when the text there isn't a placeholder.
+        // It never spans lines, so a line of 'src' is all it needs to be seen whole.
+        static std::optional<placeholder> matchPlaceholder(std::string_view src, std::size_t pos);
+
+        std::string_view source() const;
+
+        // The canonical spelling of every slot's chain, the bare variable name when unfiltered
+        const std::vector<std::string> &slots() const;
+        const std::vector<filter_chain> &chains() const;
+        const std::vector<segment> &segments() const;
+
+        bool hasVariables() const;
+        bool hasControlFlow() const;
+        // A slot naming the variable of an enclosing '{% for %}', bound to its current item
+        bool loopBound(std::size_t slot) const;
+        // Number of placeholder occurrences, a variable used twice counts twice
+        std::size_t placeholderCount() const;
+
+        std::vector<std::string_view> undefinedVariables(const variable_store &vars) const;
+        // The unfiltered value of every slot's variable
+        std::vector<std::string_view> bind(const variable_store &vars) const;
+
+        void renderTo(std::string &out, const std::vector<std::string_view> &values) const;
+        // Filtered slots are rendered once into 'filtered', keyed by their chain, and reused from there
+        // by every template sharing it. It must only ever see values bound from the same variables.
+        void renderTo(std::vector<std::string_view> &chunks, const std::vector<std::string_view> &values, variable_store &filtered) const;
+        std::string render(const variable_store &vars) const;
+
+      private:
+        // Unbalanced blocks compile again with 'tags' off, leaving every '{%' as text
+        bool parse(bool tags);
+        void reset();
+        // Every offset, slot and jump in range, and every loop bound slot inside its loop
+        bool verify() const;
+
+        template <typename literal_fn, typename variable_fn>
+        void execute(const std::vector<std::string_view> &values, literal_fn &&literal, variable_fn &&variable) const;
+
+        std::string m_Storage;
+        std::string_view m_View;
+        bool m_Owning = true;
+        std::vector<segment> m_Segments;
+        std::vector<std::string> m_Slots;
+        std::vector<filter_chain> m_Chains;
+        // 0 for free variables, the depth of the binding loop plus one otherwise
+        std::vector<uint32_t> m_Depths;
+        bool m_Flow = false;
+        std::size_t m_LiteralSize = 0;
+    };
+
+}
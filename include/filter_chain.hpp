@@ -0,0 +1,60 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <optional>
+#include <string_view>
+
+namespace arti {
+
+    // The variable and filters of a '{{ name | snake | replace("_", "-") }}' placeholder,
+    // parsed once when the template compiles and applied straight into an output buffer
+    class filter_chain {
+      public:
+        enum class kinds {
+            Upper,
+            Lower,
+            Snake,
+            Camel,
+            Pascal,
+            Kebab,
+            Trim,
+            Replace,
+            Default
+        };
+
+        struct filter {
+            kinds kind;
+            std::vector<std::string> arguments;
+        };
+
+        // Whatever sits between '{{' and '}}', null when it isn't a valid placeholder
+        static std::optional<filter_chain> parse(std::string_view expression);
+
+        filter_chain() = default;
+        ~filter_chain() = default;
+
+        filter_chain(filter_chain &&) = default;
+        filter_chain(const filter_chain &) = default;
+
+        filter_chain &operator=(filter_chain &&) = default;
+        filter_chain &operator=(const filter_chain &) = default;
+
+        std::string_view variable() const;
+        // Spelled the same for equal chains whatever their spacing, a bare variable is its name
+        const std::string &key() const;
+
+        bool filtered() const;
+        // An undefined variable isn't worth a warning when the chain gives it a default
+        bool hasDefault() const;
+
+        // Appends 'value' with every filter applied to 'out'
+        void apply(std::string_view value, std::string &out) const;
+
+      private:
+        std::string m_Variable;
+        std::string m_Key;
+        std::vector<filter> m_Filters;
+    };
+
+}
@@ -1,10 +1,16 @@
 #pragma once
 
+#include <optional>
+#include <functional>
+
 #include <boost/program_options.hpp>
 
+#include "utils/io.hpp"
+#include "utils/tar.hpp"
 #include "utils/error.hpp"
 
 #include "generator_template.hpp"
+#include "template_program.hpp"
 
 namespace opt = boost::program_options;
 
@@ -12,29 +18,121 @@ namespace arti {
 
     class generator {
       public:
-        using variables_map = std::unordered_map<std::string, std::string>;
+        struct run_options {
+            // Worker threads used to render folder templates, 1 renders inline
+            std::size_t jobs = 1;
+            // Directory the output is generated into, empty uses the current directory
+            fs::path outputRoot;
+            utils::io_backend::kinds io = utils::io_backend::kinds::Auto;
+            // Renders over existing output, rewriting only the files whose content changed
+            bool update = false;
+            // Where output manifests are read and written, empty disables them
+            fs::path manifestDirectory;
+            // Set, the output is streamed into this archive and the disk isn't looked at
+            utils::tar_writer *archive = nullptr;
+        };
+
+        struct run_report {
+            std::vector<std::string> messages;
+            std::size_t filesCreated = 0;
+            // Only set by updates
+            std::size_t filesUpdated = 0;
+            std::size_t filesUnchanged = 0;
+            std::size_t directoriesCreated = 0;
+            std::size_t skipped = 0;
+            // The output file or root folder was already there, nothing was generated
+            bool rootExisted = false;
+        };
+
+        enum class plan_actions {
+            Create,
+            // Updates only, the existing file holds different content
+            Replace,
+            // Updates only, the existing file or directory already matches
+            Unchanged,
+            // Already there, kept as it is
+            Skip,
+            // In the way of the output: an existing root, or a path of the wrong type
+            Conflict
+        };
+
+        struct planned_entry {
+            std::string path;
+            // Index of the directory entry holding it, the root for a folder's top level entries
+            std::size_t parent = 0;
+            bool directory = false;
+            plan_actions action = plan_actions::Create;
+            // Rendered size and content hash, files only
+            uint64_t size = 0;
+            uint64_t hash = 0;
+            // mtime of an existing file, only known when it was compared
+            int64_t mtime = 0;
+            // Warnings found while rendering this entry
+            std::vector<std::string> messages;
+            // Files only, its views point into the program and this generator's variables
+            utils::io_backend::file_request request;
+        };
+
+        // Everything a run would do, computed without writing anything. Paths
+        // below a directory that doesn't exist yet aren't checked at all.
+        struct output_plan {
+            template_program::types type = template_program::types::Unknown;
+            // Output file or root folder
+            std::string output;
+            // Walk order, a folder's root comes first
+            std::vector<planned_entry> entries;
+            std::vector<std::string> messages;
+            std::size_t conflicts = 0;
+            // Content hashes were computed for every file, passthrough ones included
+            bool hashed = false;
+        };
 
         generator() = delete;
 
         generator(generator_template &&template_v);
+        // Only views 'template_v', which must outlive the generator
         generator(const generator_template &template_v);
 
         ~generator() = default;
 
-        generator(generator &&) = default;
-        generator(const generator &) = default;
+        // Its variables are layered over the template's, it stays where it was built
+        generator(generator &&) = delete;
+        generator(const generator &) = delete;
 
-        generator &operator=(generator &&) = default;
-        generator &operator=(const generator &) = default;
+        generator &operator=(generator &&) = delete;
+        generator &operator=(const generator &) = delete;
+
+        // 'overrides' are applied after the command line definitions. Only the built-ins 'program' uses,
+        // directly or through other variables, are computed; all of them are without it.
+        tl::expected<void, std::string> loadVars(const opt::variables_map &params, const variable_store &overrides = {}, const template_program *program = nullptr);
+        // Sets every '--define' of 'params' in 'vars'
+        static tl::expected<void, std::string> loadDefines(const opt::variables_map &params, variable_store &vars);
 
-        tl::expected<void, std::string> loadVars(const opt::variables_map &params);
         tl::expected<void, std::string> run() const;
+        tl::expected<void, std::string> run(const run_options &options) const;
+        tl::expected<void, std::string> run(const template_program &program, const run_options &options, run_report &report) const;
+
+        // Updates and manifests always hash, 'hashAll' also hashes passthrough files otherwise
+        tl::expected<output_plan, std::string> plan(const template_program &program, const run_options &options, bool hashAll = false) const;
+        // Carries out 'plan', which must come from this generator and a still alive program
+        tl::expected<void, std::string> execute(const output_plan &plan, const run_options &options, run_report &report) const;
+        // Writes every entry into 'options.archive' as soon as it's rendered, with paths relative
+        // to the output's parent. No file's content is kept once it's in the archive.
+        tl::expected<void, std::string> archive(const template_program &program, const run_options &options, run_report &report) const;
 
       private:
+        // Receives every entry as soon as it's planned, a failure stops the planning
+        using entry_sink = std::function<tl::expected<void, std::string>(planned_entry &)>;
+
+        tl::expected<output_plan, std::string> plan(const template_program &program, const run_options &options, bool hashAll, const entry_sink &sink) const;
+
         tl::expected<void, std::string> processVars();
 
-        generator_template m_Template;
-        variables_map m_Vars;
+        std::optional<generator_template> m_Owned;
+        const generator_template *m_Template;
+        variable_store m_Vars;
+        // Filtered values by chain, shared by every file of a run, planned chunks point into it
+        mutable variable_store m_Filtered;
     };
 
 }
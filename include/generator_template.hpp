@@ -1,5 +1,6 @@
 #pragma once
 
+#include <memory>
 #include <string>
 #include <filesystem>
 #include <string_view>
@@ -11,6 +12,9 @@
 
 #include <boost/program_options.hpp>
 
+#include "variable_store.hpp"
+#include "builtin_providers.hpp"
+
 #include "utils/error.hpp"
 
 namespace fs = std::filesystem;
@@ -19,9 +23,15 @@ namespace opt = boost::program_options;
 namespace arti {
 
     class generator;
+    class template_program;
+    class template_cache;
+    class template_pack;
 
     class generator_template {
       friend class generator;
+      friend class template_program;
+      friend class template_cache;
+      friend class template_pack;
 
       public:
         enum class types {
@@ -36,11 +46,16 @@ namespace arti {
             ParseError
         };
 
-        using variables_map = std::unordered_map<std::string, std::string>;
         using expected_t = arti::expected<generator_template, errors>;
+        using status_t = arti::expected<void, errors>;
 
         static expected_t loadFromPath(fs::path templatePath);
         static expected_t loadFromConfig(std::string_view name);
+        // A pack of 'name' under 'configPath' takes precedence over its config section and folder
+        static expected_t loadFromConfig(std::string_view name, const fs::path &configPath);
+        // Always from the config files and the template folder, ignoring any pack
+        static expected_t loadFromDirectory(std::string_view name, const fs::path &configPath);
+        static expected_t loadFromPack(const fs::path &packPath, const fs::path &configPath);
 
         generator_template() = delete;
         ~generator_template() = default;
@@ -51,31 +66,37 @@ namespace arti {
         generator_template &operator=(generator_template &&) = default;
         generator_template &operator=(const generator_template &) = default;
 
-        void loadDefaultVars();
+        // Reads vars.toml again, a file that doesn't parse is a ParseError
+        status_t loadDefaultVars();
+        // Starts a run on 'cwd' with fresh built-ins, none is computed before something references it.
+        // A null 'environment' is the process' own.
+        void setWorkingDirectory(const fs::path &cwd, builtin_providers::environment_ptr environment = nullptr);
 
         std::string_view getName() const;
         const fs::path &getRootPath() const;
+        // Read from a pack, there's no template folder
+        bool isPacked() const;
+
+        std::string_view operator[](std::string_view key) const {
+            return m_FileVars.at(key);
+        }
+
+        std::string_view at(std::string_view key) const {
+            return m_FileVars.at(key);
+        }
 
-        template <typename T>
-        requires std::is_constructible_v<std::string, T>
-        std::string_view operator[](const T &key) const {
-            if constexpr (std::is_same_v<std::string, T>) {
-                return m_DefaultVars.at(key);
-            }
-            else {
-                return m_DefaultVars.at(std::string{ key });
-            }
+        // vars.toml values, generators layer their own variables and the built-ins they use over it
+        const variable_store &defaultVars() const {
+            return m_FileVars;
         }
 
-        template <typename T>
-        requires std::is_constructible_v<std::string, T>
-        std::string_view at(const T &key) const {
-            if constexpr (std::is_same_v<std::string, T>) {
-                return m_DefaultVars.at(key);
-            }
-            else {
-                return m_DefaultVars.at(std::string{ key });
-            }
+        // The projects generated from this copy on get their own 'uuid' and 'random_seed', the other
+        // built-ins stay shared with the rest of the run
+        void startProject();
+
+        // Shared by every copy made during the current run, projects only have their own 'uuid' and 'random_seed'
+        builtin_providers &builtins() const {
+            return *m_Builtins;
         }
 
         std::string toString() const {
@@ -96,9 +117,9 @@ namespace arti {
             ss << "Root: " << m_TemplateRoot << std::endl;
             ss << "Variables: " << std::endl;
 
-            for (const auto &[k, v] : m_DefaultVars) {
+            m_FileVars.forEach([&](std::string_view k, std::string_view v) {
                 ss << "* " << k << ": " << v << std::endl;
-            }
+            });
 
             return ss.str();
         }
@@ -106,12 +127,20 @@ namespace arti {
       private:
         generator_template(types type, bool nameParamOptional, fs::path path, std::string name, std::string root);
 
+        static expected_t fromConfig(std::string_view name, const toml::table &templateConfig, const fs::path &configPath);
+
+        status_t loadVarsFile();
+
         types m_Type;
         bool m_NameParamOptional;
         fs::path m_Location;
         std::string m_Name;
         std::string m_TemplateRoot;
-        variables_map m_DefaultVars;
+        // Values read from vars.toml
+        variable_store m_FileVars;
+        std::shared_ptr<builtin_providers> m_Builtins = std::make_shared<builtin_providers>();
+        // Set when loaded from a pack, template files are read from it instead of m_Location
+        std::shared_ptr<const template_pack> m_Pack;
     };
 
 }
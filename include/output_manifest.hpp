@@ -0,0 +1,48 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+#include <unordered_map>
+
+namespace fs = std::filesystem;
+
+namespace arti {
+
+    // Size, mtime and content hash of every file a generation left on disk.
+    // A file still matching its size and mtime is known to hold that content
+    // without reading it again, '--update' only compares hashes for those.
+    class output_manifest {
+      public:
+        struct entry {
+            uint64_t size = 0;
+            int64_t mtime = 0;
+            uint64_t hash = 0;
+        };
+
+        // One manifest per generated file or root folder, kept under 'directory'.
+        // A missing or unreadable manifest loads empty.
+        static output_manifest load(const fs::path &directory, const fs::path &output);
+
+        output_manifest() = default;
+        ~output_manifest() = default;
+
+        output_manifest(output_manifest &&) = default;
+        output_manifest(const output_manifest &) = default;
+
+        output_manifest &operator=(output_manifest &&) = default;
+        output_manifest &operator=(const output_manifest &) = default;
+
+        bool save(const fs::path &directory, const fs::path &output) const;
+
+        const entry *find(const std::string &path) const;
+        void set(std::string path, entry value);
+
+      private:
+        static fs::path location(const fs::path &directory, const fs::path &output);
+
+        std::unordered_map<std::string, entry> m_Entries;
+    };
+
+}
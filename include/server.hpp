@@ -0,0 +1,54 @@
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+#include <unordered_map>
+
+#include <tl/expected.hpp>
+
+#include "command.hpp"
+#include "template_cache.hpp"
+
+#include "utils/socket.hpp"
+
+namespace fs = std::filesystem;
+
+namespace arti {
+
+    // Resident daemon, keeps loaded templates in memory and runs the command
+    // lines forwarded by 'client' against them. A request is one frame holding
+    // the client cwd, its arguments and its environment, answered by Output frames
+    // streamed as they are produced and a final Exit frame with the exit code.
+    class server {
+      public:
+        enum class frames : uint64_t {
+            Output,
+            Exit
+        };
+
+        explicit server(fs::path socketPath);
+        ~server() = default;
+
+        server(server &&) = delete;
+        server(const server &) = delete;
+
+        server &operator=(server &&) = delete;
+        server &operator=(const server &) = delete;
+
+        // Blocks serving requests until the process is signaled
+        tl::expected<void, std::string> serve();
+
+      private:
+        void handle(const utils::unix_socket &connection);
+        tl::expected<command::loaded_ptr, std::string> load(std::string_view name, template_cache::modes mode);
+
+        fs::path m_SocketPath;
+
+        std::mutex m_Mutex;
+        std::unordered_map<std::string, command::loaded_ptr> m_Templates;
+    };
+
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "variable_store.hpp"
+#include "builtin_providers.hpp"
+
+#include "utils/error.hpp"
+
+namespace arti {
+
+    // Renders a single template read from a descriptor into another one, through fixed size buffers,
+    // so its memory doesn't depend on the input's size or its longest line.
+    // Only placeholders and their filters are rendered, '{% %}' tags would need their blocks whole.
+    class stream_renderer {
+      public:
+        // Also the longest placeholder recognized, anything past it is text
+        static constexpr std::size_t BufferSize = 64 * 1024;
+        // Only the first few undefined variables are remembered
+        static constexpr std::size_t MaxUndefined = 32;
+
+        enum class errors {
+            UnableToRead,
+            UnableToWrite
+        };
+
+        struct report {
+            uint64_t bytesRead = 0;
+            uint64_t bytesWritten = 0;
+            std::vector<std::string> undefined;
+            // Some '{% ... %}' tag was found and written as it is
+            bool tags = false;
+        };
+
+        using expected_t = arti::expected<report, errors>;
+
+        stream_renderer() = delete;
+        ~stream_renderer() = delete;
+
+        stream_renderer(stream_renderer &&) = delete;
+        stream_renderer(const stream_renderer &) = delete;
+
+        stream_renderer &operator=(stream_renderer &&) = delete;
+        stream_renderer &operator=(const stream_renderer &) = delete;
+
+        // Reads 'input' up to its end, neither descriptor is closed. A variable 'vars' doesn't
+        // define is looked up in 'builtins'.
+        static expected_t run(int input, int output, const variable_store &vars, builtin_providers &builtins);
+    };
+
+}
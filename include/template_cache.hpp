@@ -0,0 +1,62 @@
+#pragma once
+
+#include <string>
+#include <optional>
+#include <filesystem>
+#include <string_view>
+
+#include <tl/expected.hpp>
+
+#include "generator_template.hpp"
+#include "template_program.hpp"
+
+namespace fs = std::filesystem;
+
+namespace arti {
+
+    // Persists a loaded and compiled template in a compact binary file that is
+    // memory mapped back on later runs, skipping TOML parsing and the folder walk.
+    // Entries are invalidated by mtime/size and, when those differ, content hash.
+    class template_cache {
+      public:
+        enum class modes {
+            Enabled,
+            Rebuild,
+            Disabled
+        };
+
+        struct loaded_t {
+            generator_template template_v;
+            template_program program;
+            bool fromCache;
+            // Encoded dependency list, lets long running processes revalidate what they hold
+            std::string dependencies;
+        };
+
+        using expected_t = tl::expected<loaded_t, std::string>;
+
+        template_cache() = delete;
+        ~template_cache() = delete;
+
+        template_cache(template_cache &&) = delete;
+        template_cache(const template_cache &) = delete;
+
+        template_cache &operator=(template_cache &&) = delete;
+        template_cache &operator=(const template_cache &) = delete;
+
+        static expected_t load(std::string_view name, modes mode = modes::Enabled);
+
+        // Whether nothing 'loaded' was built from changed since
+        static bool fresh(const loaded_t &loaded);
+
+        static std::optional<fs::path> directory();
+
+      private:
+        static expected_t loadPack(const fs::path &packPath);
+        // 'refresh' is set when a dependency was only touched and the entry should be rewritten
+        static std::optional<loaded_t> read(const fs::path &cacheFile, bool &refresh);
+        static bool write(const fs::path &cacheFile, const loaded_t &loaded);
+        static std::optional<std::string> encodeDependencies(std::string_view name, const generator_template &template_v, const template_program &program);
+    };
+
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <mutex>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+
+#include <sys/types.h>
+
+#include "utils/error.hpp"
+#include "utils/file.hpp"
+
+namespace fs = std::filesystem;
+
+namespace arti {
+
+    class generator_template;
+
+    // A whole template in one file: its config section, vars.toml and every template
+    // file behind an index. Opening it maps the file once, contents are views into the
+    // mapping, only the entries stored compressed are inflated into memory, the first
+    // time they're read.
+    class template_pack {
+      public:
+        enum class errors {
+            NotFound,
+            Invalid,
+            UnableToWrite
+        };
+
+        struct entry {
+            // Relative to the template folder, as the config's 'root' is
+            std::string path;
+            bool directory = false;
+            mode_t mode = 0644;
+            uint64_t offset = 0;
+            uint64_t size = 0;
+            // Size once inflated, -1 when stored as is
+            int64_t inflated = -1;
+        };
+
+        using expected_t = arti::expected<std::shared_ptr<const template_pack>, errors>;
+        using status_t = arti::expected<void, errors>;
+        using content_t = arti::expected<std::string_view, errors>;
+
+        // Where the pack of the template 'name' lives under a config folder
+        static fs::path location(const fs::path &configPath, std::string_view name);
+
+        static expected_t open(const fs::path &path);
+
+        // Packs 'template_v', loaded from its folder, with 'config' as the section of 'name'.
+        // 'level' above 0 zstd compresses the entries that get smaller.
+        static status_t write(const fs::path &path, std::string_view name, const generator_template &template_v, std::string_view config, int level = 0);
+
+        template_pack() = default;
+        ~template_pack() = default;
+
+        template_pack(template_pack &&) = default;
+        template_pack(const template_pack &) = delete;
+
+        template_pack &operator=(template_pack &&) = default;
+        template_pack &operator=(const template_pack &) = delete;
+
+        // Name the template is looked up by, its config section is keyed by it
+        std::string_view name() const;
+        std::string_view config() const;
+
+        const std::vector<entry> &entries() const;
+        const entry *find(std::string_view path) const;
+        // 'current' is one of entries(). 'Invalid' when it's compressed and doesn't inflate
+        content_t content(const entry &current) const;
+
+        const utils::mapped_file &mapping() const;
+
+      private:
+        struct inflated_entry {
+            std::once_flag once;
+            std::string content;
+            bool valid = false;
+        };
+
+        utils::mapped_file m_Mapping;
+        uint64_t m_DataOffset = 0;
+        std::string m_Name;
+        std::string m_Config;
+        std::vector<entry> m_Entries;
+        // One per entry, filled by the first content() call reading it
+        std::vector<std::unique_ptr<inflated_entry>> m_Inflated;
+    };
+
+}
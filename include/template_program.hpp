@@ -0,0 +1,92 @@
+#pragma once
+
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <unordered_map>
+
+#include <sys/types.h>
+
+#include <tl/expected.hpp>
+
+#include "compiled_template.hpp"
+#include "generator_template.hpp"
+
+#include "utils/file.hpp"
+
+namespace fs = std::filesystem;
+
+namespace arti {
+
+    // Variable independent form of a generator_template: every output path and
+    // file content compiled once, ready to be rendered for any set of variables
+    class template_program {
+      friend class template_cache;
+
+      public:
+        // The parent of every entry right below the template's root
+        static constexpr std::size_t Root = std::numeric_limits<std::size_t>::max();
+
+        // The template's folder is a tree: every entry only compiles its own name and points at
+        // its parent directory, output paths are built from the parent's already rendered one
+        struct entry {
+            fs::path templatePath;
+            // Index of the directory entry holding it, always an earlier one, or 'Root'
+            std::size_t parent = Root;
+            // Its own path component, a file template's whole output name
+            compiled_template name;
+            bool directory = false;
+            // Binary or without any '{{' or '{%', copied from 'templatePath' as is and never compiled
+            bool passthrough = false;
+
+            std::shared_ptr<const utils::mapped_file> source;
+            compiled_template content;
+            mode_t mode = 0644;
+        };
+
+        using types = generator_template::types;
+        using expected_t = tl::expected<template_program, std::string>;
+
+        static expected_t compile(const generator_template &template_v);
+
+        template_program() = default;
+        ~template_program() = default;
+
+        template_program(template_program &&) = default;
+        template_program(const template_program &) = default;
+
+        template_program &operator=(template_program &&) = default;
+        template_program &operator=(const template_program &) = default;
+
+        types type() const;
+        const compiled_template &root() const;
+        const std::vector<entry> &entries() const;
+        // Every free variable the root, names and contents use, loop variables left out
+        std::vector<std::string_view> references() const;
+
+        // Compiles the file template at 'templatePath' again, keeping its place in the tree.
+        // False when it isn't one of the entries, or it can't be read anymore.
+        bool reload(const fs::path &templatePath);
+
+      private:
+        // Compiled from a packed template, every entry is a view into the pack
+        static expected_t fromPack(const generator_template &template_v);
+
+        // Appends 'current', found at 'relativePath', below the directory entry holding it.
+        // 'directories' maps the relative path of every directory entry to its index.
+        void place(entry current, std::string_view relativePath, std::unordered_map<std::string, std::size_t> &directories);
+
+        // Opens and compiles the file at 'file.templatePath'
+        static bool load(entry &file);
+
+        static bool isBinary(std::string_view content);
+        static bool isPassthrough(std::string_view content);
+
+        types m_Type = types::Unknown;
+        compiled_template m_Root;
+        std::vector<entry> m_Entries;
+    };
+
+}
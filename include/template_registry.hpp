@@ -0,0 +1,78 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+#include <unordered_map>
+
+#include <toml.hpp>
+
+#include "utils/error.hpp"
+
+namespace fs = std::filesystem;
+
+namespace arti {
+
+    // Name -> byte ranges index over config.toml and config.d/*.toml. Looking a
+    // template up only parses its own tables, and the index itself is persisted
+    // next to the template cache and rebuilt only when a config file changes.
+    class template_registry {
+      public:
+        enum class errors {
+            ConfigNotFound,
+            NotFound,
+            ParseError
+        };
+
+        using expected_t = arti::expected<template_registry, errors>;
+        using section_t = arti::expected<std::string, errors>;
+        using table_t = arti::expected<toml::table, errors>;
+
+        static expected_t open(const fs::path &configPath);
+
+        template_registry() = delete;
+        ~template_registry() = default;
+
+        template_registry(template_registry &&) = default;
+        template_registry(const template_registry &) = default;
+
+        template_registry &operator=(template_registry &&) = default;
+        template_registry &operator=(const template_registry &) = default;
+
+        // Raw TOML text of every table belonging to 'name'
+        section_t section(std::string_view name) const;
+        // The parsed '[name]' table
+        table_t table(std::string_view name) const;
+
+        std::vector<std::string> names() const;
+
+      private:
+        struct source {
+            fs::path path;
+            int64_t mtime = 0;
+            uint64_t size = 0;
+        };
+
+        struct span {
+            uint64_t source;
+            uint64_t offset;
+            uint64_t length;
+            // Root level 'name.key = ...' lines rather than a '[name]' table
+            bool root;
+        };
+
+        explicit template_registry(fs::path configPath);
+
+        bool readIndex(const fs::path &indexFile);
+        void writeIndex(const fs::path &indexFile) const;
+        void scan(uint64_t sourceIndex, std::string_view content);
+
+        fs::path m_ConfigPath;
+        int64_t m_FragmentsMtime = 0;
+        std::vector<source> m_Sources;
+        std::unordered_map<std::string, std::vector<span>> m_Index;
+    };
+
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <string_view>
+
+namespace arti::utils {
+
+    // Little endian u64 / length prefixed string encoding shared by the on-disk caches
+    class binary_writer {
+      public:
+        void u64(uint64_t v) {
+            char bytes[8];
+
+            for (int i = 0; i < 8; ++i) {
+                bytes[i] = static_cast<char>((v >> (i * 8)) & 0xFF);
+            }
+
+            m_Buffer.append(bytes, 8);
+        }
+
+        void str(std::string_view v) {
+            u64(v.size());
+            m_Buffer.append(v);
+        }
+
+        const std::string &buffer() const {
+            return m_Buffer;
+        }
+
+      private:
+        std::string m_Buffer;
+    };
+
+    class binary_reader {
+      public:
+        explicit binary_reader(std::string_view data)
+            : m_Data(data) {
+        }
+
+        uint64_t u64() {
+            if (m_Pos + 8 > m_Data.size()) {
+                m_Failed = true;
+                return 0;
+            }
+
+            uint64_t v = 0;
+
+            for (int i = 0; i < 8; ++i) {
+                v |= static_cast<uint64_t>(static_cast<unsigned char>(m_Data[m_Pos + i])) << (i * 8);
+            }
+
+            m_Pos += 8;
+
+            return v;
+        }
+
+        // The returned view points into the data being read
+        std::string_view str() {
+            const auto size = u64();
+
+            if (m_Failed || size > m_Data.size() - m_Pos) {
+                m_Failed = true;
+                return {};
+            }
+
+            auto v = m_Data.substr(m_Pos, size);
+            m_Pos += size;
+
+            return v;
+        }
+
+        bool failed() const {
+            return m_Failed;
+        }
+
+        // Bytes left to read, bounds any count read before allocating for it
+        std::size_t remaining() const {
+            return m_Data.size() - m_Pos;
+        }
+
+      private:
+        std::string_view m_Data;
+        std::size_t m_Pos = 0;
+        bool m_Failed = false;
+    };
+
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <optional>
+#include <filesystem>
+#include <string_view>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "utils/error.hpp"
+
+namespace fs = std::filesystem;
+
+namespace arti::utils {
+
+    enum class file_errors {
+        UnableToOpen,
+        AlreadyExisting,
+        UnableToCreate,
+        UnableToWrite
+    };
+
+    // Read-only view of a whole file, memory mapped when possible and
+    // bulk read otherwise (empty files, pipes, special files)
+    class mapped_file {
+      public:
+        using expected_t = arti::expected<mapped_file, file_errors>;
+
+        static expected_t open(const fs::path &path);
+
+        mapped_file() = default;
+        ~mapped_file();
+
+        mapped_file(mapped_file &&other) noexcept;
+        mapped_file(const mapped_file &) = delete;
+
+        mapped_file &operator=(mapped_file &&other) noexcept;
+        mapped_file &operator=(const mapped_file &) = delete;
+
+        std::string_view view() const;
+        mode_t mode() const;
+
+      private:
+        void release();
+
+        void *m_Mapping = nullptr;
+        std::size_t m_Size = 0;
+        std::string m_Buffer;
+        mode_t m_Mode = 0644;
+    };
+
+    std::optional<struct stat> statOf(const fs::path &path);
+    int64_t mtimeOf(const struct stat &st);
+
+    // Creates the directory 'path', 'AlreadyExisting' when anything is already there
+    arti::expected<void, file_errors> makeDirectory(const fs::path &path, mode_t mode = 0777);
+
+    // The '...At' forms create 'name' relative to the directory handle 'at' (or AT_FDCWD)
+    // without walking the whole path again, 'path' only names it in errors
+    arti::expected<void, file_errors> makeDirectoryAt(int at, const char *name, const fs::path &path, mode_t mode = 0777);
+
+    // An O_PATH handle to the directory 'name', only good as the 'at' of other calls. -1 on failure
+    int openDirectoryAt(int at, const char *name);
+
+    // Creates 'path' exclusively and writes all chunks with as few writev calls as possible
+    arti::expected<void, file_errors> writeNewFile(
+        const fs::path &path,
+        const std::vector<std::string_view> &chunks,
+        mode_t mode = 0644
+    );
+
+    arti::expected<void, file_errors> writeNewFileAt(
+        int at,
+        const char *name,
+        const fs::path &path,
+        const std::vector<std::string_view> &chunks,
+        mode_t mode = 0644
+    );
+
+    // A name next to 'path' no other call, of this process or another one, is given. For
+    // a file written in full and then renamed onto 'path'
+    fs::path temporaryPath(const fs::path &path);
+
+    // Writes 'chunks' to a temporary file renamed onto 'path', readers never see a partial
+    // file. The temporary file is removed when anything fails
+    arti::expected<void, file_errors> replaceFile(
+        const fs::path &path,
+        const std::vector<std::string_view> &chunks,
+        mode_t mode = 0644
+    );
+
+    // Creates 'path' exclusively as a byte for byte copy of 'source', reflinked
+    // when the filesystem supports it and copied inside the kernel otherwise
+    arti::expected<void, file_errors> copyNewFile(
+        const fs::path &source,
+        const fs::path &path,
+        mode_t mode = 0644
+    );
+
+    arti::expected<void, file_errors> copyNewFileAt(
+        const fs::path &source,
+        int at,
+        const char *name,
+        const fs::path &path,
+        mode_t mode = 0644
+    );
+
+}
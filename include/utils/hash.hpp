@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+namespace arti::utils {
+
+    // Streaming XXH64, used to fingerprint template sources and rendered output
+    class hasher {
+      public:
+        explicit hasher(uint64_t seed = 0);
+
+        hasher &update(std::string_view data);
+        uint64_t digest() const;
+
+      private:
+        uint64_t m_Acc[4];
+        uint64_t m_Seed;
+        uint64_t m_Total = 0;
+        unsigned char m_Buffer[32];
+        std::size_t m_Buffered = 0;
+    };
+
+    uint64_t hash(std::string_view data, uint64_t seed = 0);
+
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <limits>
+#include <optional>
+#include <filesystem>
+#include <string_view>
+
+#include <sys/types.h>
+
+#include "utils/error.hpp"
+#include "utils/file.hpp"
+
+namespace fs = std::filesystem;
+
+namespace arti::utils {
+
+    // Creates the directories and files of a whole generation run. Every
+    // call takes a full batch, so a backend is free to submit it at once.
+    class io_backend {
+      public:
+        enum class kinds {
+            Auto,
+            Uring,
+            Sync
+        };
+
+        static constexpr std::size_t NoParent = std::numeric_limits<std::size_t>::max();
+
+        struct directory_request {
+            fs::path path;
+            // Index of its parent's request in the same batch, it's then made relative to that directory
+            std::size_t parent = NoParent;
+            // Already there, only opened for what's below it
+            bool existing = false;
+        };
+
+        struct file_request {
+            fs::path path;
+            // Index of its directory in the last makeDirectories batch, it's then created relative to it
+            std::size_t parent = NoParent;
+            mode_t mode = 0644;
+            // Copied byte for byte when set, 'chunks' are written otherwise
+            const fs::path *source = nullptr;
+            std::vector<std::string_view> chunks;
+        };
+
+        using status_t = arti::expected<void, file_errors>;
+
+        // 'Auto' picks io_uring for batches of 'operations' big enough to pay for its setup,
+        // when the kernel supports every operation used. Null when 'Uring' isn't available.
+        static std::unique_ptr<io_backend> create(kinds kind, std::size_t operations);
+        static std::optional<kinds> parse(std::string_view name);
+        static std::string_view name(kinds kind);
+
+        io_backend() = default;
+        virtual ~io_backend();
+
+        io_backend(io_backend &&) = delete;
+        io_backend(const io_backend &) = delete;
+
+        io_backend &operator=(io_backend &&) = delete;
+        io_backend &operator=(const io_backend &) = delete;
+
+        virtual kinds kind() const = 0;
+
+        // Parents must come before their children, an existing one fails with 'AlreadyExisting'.
+        // Each directory stays open until the next batch, what's below it is created relative
+        // to it instead of walking its whole path again.
+        virtual std::vector<status_t> makeDirectories(const std::vector<directory_request> &requests) = 0;
+
+        // Every file is created exclusively and every request is attempted, whatever failed
+        // before it. 'jobs' is only used by backends writing one file at a time
+        virtual std::vector<status_t> writeFiles(const std::vector<file_request> &requests, std::size_t jobs) = 0;
+
+      protected:
+        struct location {
+            int at;
+            const char *name;
+        };
+
+        // Past this many directories the rest are reached by path, files need descriptors too
+        static constexpr std::size_t MaxHandles = 256;
+
+        // Closes the handles of the previous batch and makes room for 'count' new ones
+        void resetHandles(std::size_t count);
+        void keepHandle(std::size_t index, int handle);
+
+        // Relative to the handle of 'parent' when it's open, the whole 'path' otherwise.
+        // 'name' points into 'path'.
+        location locate(const fs::path &path, std::size_t parent) const;
+
+      private:
+        std::vector<int> m_Handles;
+        std::size_t m_Open = 0;
+    };
+
+}
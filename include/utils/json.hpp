@@ -0,0 +1,11 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+namespace arti::utils {
+
+    // Escapes 'text' to be placed between the quotes of a JSON string
+    std::string escapeJson(std::string_view text);
+
+}
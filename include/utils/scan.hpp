@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+namespace arti::utils {
+
+    // Finds '{{' and '{%' candidates 16 or 32 bytes at a time, literal text between
+    // them is skipped without looking at every character individually.
+    // The widest kernel the CPU supports is picked once, at first use.
+    class scanner {
+      public:
+        enum class kernels {
+            Scalar,
+            SSE2,
+            AVX2
+        };
+
+        scanner() = delete;
+        ~scanner() = delete;
+
+        scanner(scanner &&) = delete;
+        scanner(const scanner &) = delete;
+
+        scanner &operator=(scanner &&) = delete;
+        scanner &operator=(const scanner &) = delete;
+
+        // Position of the first '{{' or '{%' at or after 'pos', npos when there is none
+        static std::size_t findOpening(std::string_view text, std::size_t pos = 0);
+        static std::size_t findOpening(std::string_view text, std::size_t pos, kernels kernel);
+
+        static kernels active();
+        static bool supported(kernels kernel);
+        static std::string_view name(kernels kernel);
+    };
+
+}
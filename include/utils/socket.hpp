@@ -0,0 +1,59 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <optional>
+#include <filesystem>
+#include <string_view>
+
+#include "utils/error.hpp"
+
+namespace fs = std::filesystem;
+
+namespace arti::utils {
+
+    enum class socket_errors {
+        PathTooLong,
+        AlreadyListening,
+        UnableToCreate,
+        UnableToBind,
+        UnableToConnect,
+        UnableToAccept
+    };
+
+    // AF_UNIX stream socket exchanging length prefixed frames
+    class unix_socket {
+      public:
+        using expected_t = arti::expected<unix_socket, socket_errors>;
+
+        // Binds 'path' with owner only permissions, replacing a stale socket left behind
+        static expected_t listen(const fs::path &path);
+        static expected_t connect(const fs::path &path);
+
+        unix_socket() = default;
+        ~unix_socket();
+
+        unix_socket(unix_socket &&other) noexcept;
+        unix_socket(const unix_socket &) = delete;
+
+        unix_socket &operator=(unix_socket &&other) noexcept;
+        unix_socket &operator=(const unix_socket &) = delete;
+
+        expected_t accept() const;
+
+        // Sends and receives give up after 'timeout' without progress, a stalled peer fails them
+        bool setTimeout(std::chrono::milliseconds timeout) const;
+
+        bool sendFrame(std::string_view payload) const;
+        // Empty when the peer closed the connection or sent a malformed frame
+        std::optional<std::string> receiveFrame() const;
+
+      private:
+        explicit unix_socket(int fd);
+
+        void release();
+
+        int m_Fd = -1;
+    };
+
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <string_view>
+
+#include <sys/types.h>
+
+#include "utils/error.hpp"
+#include "utils/file.hpp"
+
+namespace arti::utils {
+
+    // Streams a POSIX tar archive into a file or stdout, zstd compressed on demand.
+    // Only one block buffer is held, entries go out as soon as they're added.
+    class tar_writer {
+      public:
+        using expected_t = arti::expected<tar_writer, file_errors>;
+        using status_t = arti::expected<void, file_errors>;
+
+        // '-' writes to stdout. A file is written next to 'target' and only replaces it in
+        // finish(), a failed or abandoned archive leaves it as it was. 'level' 0 doesn't compress.
+        static expected_t open(std::string_view target, int level = 0);
+        static bool compressionSupported();
+
+        tar_writer() = default;
+        ~tar_writer();
+
+        tar_writer(tar_writer &&other) noexcept;
+        tar_writer(const tar_writer &) = delete;
+
+        tar_writer &operator=(tar_writer &&other) noexcept;
+        tar_writer &operator=(const tar_writer &) = delete;
+
+        // Paths are stored as given, relative ones are expected
+        status_t directory(std::string_view path, mode_t mode = 0755);
+        status_t file(std::string_view path, mode_t mode, const std::vector<std::string_view> &chunks);
+
+        // Writes the end of archive marker, flushes and moves a file into place, nothing can be added afterwards
+        status_t finish();
+
+      private:
+        status_t header(std::string_view path, char type, mode_t mode, uint64_t size);
+        status_t put(std::string_view data);
+        status_t pad(uint64_t size);
+        status_t flush(bool last);
+        status_t release();
+
+        int m_Fd = -1;
+        bool m_Owned = false;
+        std::string m_Target;
+        // Written until finish() renames it onto 'm_Target', empty for stdout
+        std::string m_Temp;
+        int64_t m_Mtime = 0;
+
+        std::string m_Buffer;
+        std::string m_Compressed;
+        // ZSTD_CStream, only when compressing
+        void *m_Stream = nullptr;
+    };
+
+}
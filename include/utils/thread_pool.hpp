@@ -0,0 +1,61 @@
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <condition_variable>
+
+namespace arti::utils {
+
+    // Fixed size pool, every worker owns a deque and steals from the others
+    // once it runs dry. Tasks submitted from a worker go to its own deque.
+    class thread_pool {
+      public:
+        using task_t = std::function<void()>;
+
+        explicit thread_pool(std::size_t workers);
+        ~thread_pool();
+
+        thread_pool(thread_pool &&) = delete;
+        thread_pool(const thread_pool &) = delete;
+
+        thread_pool &operator=(thread_pool &&) = delete;
+        thread_pool &operator=(const thread_pool &) = delete;
+
+        void submit(task_t task);
+        void wait();
+
+        std::size_t size() const;
+
+        // Index of the pool worker running the caller, -1 outside of a pool
+        static int workerIndex();
+
+        static std::size_t defaultConcurrency();
+
+      private:
+        struct queue {
+            std::mutex mutex;
+            std::deque<task_t> tasks;
+        };
+
+        void workerLoop(std::size_t index);
+        bool tryPop(std::size_t index, task_t &task);
+
+        std::vector<std::unique_ptr<queue>> m_Queues;
+        std::vector<std::thread> m_Workers;
+
+        std::mutex m_Mutex;
+        std::condition_variable m_TaskReady;
+        std::condition_variable m_AllDone;
+
+        std::atomic<std::size_t> m_Queued = 0;
+        std::atomic<std::size_t> m_Pending = 0;
+        std::atomic<std::size_t> m_NextQueue = 0;
+        bool m_Stop = false;
+    };
+
+}
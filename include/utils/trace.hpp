@@ -0,0 +1,81 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <string>
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+
+namespace fs = std::filesystem;
+
+namespace arti::utils {
+
+    // Process wide counters and timed spans behind '--stats' and '--trace'.
+    // Everything is a single relaxed load until enabled.
+    class trace {
+      public:
+        enum class counters : std::size_t {
+            BytesRead,
+            BytesWritten,
+            FilesCreated,
+            DirectoriesCreated,
+            Placeholders,
+            OpenCalls,
+            ReadCalls,
+            WriteCalls,
+            StatCalls,
+            MkdirCalls,
+            MapCalls,
+            RingEnterCalls,
+            // Submitted through io_uring, not counted as syscalls
+            RingOperations,
+            Count
+        };
+
+        // Records the lifetime of a scope, 'Phase' spans are also summed up by '--stats'
+        class span {
+          public:
+            enum class kinds {
+                Phase,
+                File
+            };
+
+            span(kinds kind, std::string_view name);
+            ~span();
+
+            span(span &&) = delete;
+            span(const span &) = delete;
+
+            span &operator=(span &&) = delete;
+            span &operator=(const span &) = delete;
+
+          private:
+            bool m_Active;
+            kinds m_Kind;
+            std::string m_Name;
+            std::chrono::steady_clock::time_point m_Start;
+        };
+
+        static void enable();
+        static bool enabled();
+
+        static void add(counters counter, uint64_t amount = 1);
+        static uint64_t get(counters counter);
+
+        // Human readable summary of the counters and phase timings
+        static std::string stats();
+        // Chrome trace event format, loadable by chrome://tracing and Perfetto
+        static bool writeChromeTrace(const fs::path &path);
+
+        trace() = delete;
+        ~trace() = delete;
+
+        trace(trace &&) = delete;
+        trace(const trace &) = delete;
+
+        trace &operator=(trace &&) = delete;
+        trace &operator=(const trace &) = delete;
+    };
+
+}
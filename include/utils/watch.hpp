@@ -0,0 +1,65 @@
+#pragma once
+
+#include <chrono>
+#include <vector>
+#include <filesystem>
+#include <unordered_map>
+
+#include "utils/error.hpp"
+
+namespace fs = std::filesystem;
+
+namespace arti::utils {
+
+    enum class watch_errors {
+        UnableToCreate,
+        UnableToWatch,
+        UnableToRead
+    };
+
+    // inotify watches over a whole directory tree, directories created later included
+    class directory_watcher {
+      public:
+        // Everything that happened to a path since the last wait
+        struct change {
+            fs::path path;
+            bool directory = false;
+            // Created or moved in
+            bool created = false;
+            // Deleted or moved away
+            bool removed = false;
+            // Closed after writing, or its mode changed
+            bool written = false;
+        };
+
+        using expected_t = arti::expected<directory_watcher, watch_errors>;
+        using changes_t = arti::expected<std::vector<change>, watch_errors>;
+
+        static expected_t open(const fs::path &root);
+
+        directory_watcher() = default;
+        ~directory_watcher();
+
+        directory_watcher(directory_watcher &&other) noexcept;
+        directory_watcher(const directory_watcher &) = delete;
+
+        directory_watcher &operator=(directory_watcher &&other) noexcept;
+        directory_watcher &operator=(const directory_watcher &) = delete;
+
+        // Blocks until something changes, then keeps gathering changes until none arrives for 'settle'.
+        // Lost events are reported as the root itself being created.
+        changes_t wait(std::chrono::milliseconds settle);
+
+      private:
+        explicit directory_watcher(int fd, fs::path root);
+
+        // Watches 'directory' and every directory below it
+        bool watch(const fs::path &directory);
+        void release();
+
+        int m_Fd = -1;
+        fs::path m_Root;
+        std::unordered_map<int, fs::path> m_Directories;
+    };
+
+}
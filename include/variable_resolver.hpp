@@ -0,0 +1,36 @@
+#pragma once
+
+#include <string>
+
+#include "variable_store.hpp"
+
+#include "utils/error.hpp"
+
+namespace arti {
+
+    // Expands the '{{ var }}' references inside variable values, in place.
+    // Every value is resolved once, after the values it references, so the
+    // whole map resolves in time linear to its size plus its references.
+    class variable_resolver {
+      public:
+        enum class errors {
+            Cycle
+        };
+
+        using expected_t = arti::expected<void, errors>;
+
+        variable_resolver() = delete;
+        ~variable_resolver() = delete;
+
+        variable_resolver(variable_resolver &&) = delete;
+        variable_resolver(const variable_resolver &) = delete;
+
+        variable_resolver &operator=(variable_resolver &&) = delete;
+        variable_resolver &operator=(const variable_resolver &) = delete;
+
+        // References to undefined variables expand to nothing, a cycle is
+        // reported with its full path ('a -> b -> a') and leaves 'vars' untouched
+        static expected_t resolve(variable_store &vars);
+    };
+
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+
+namespace arti {
+
+    // Variables interned into dense ids, every name and value is kept in one
+    // append-only arena so the views handed out stay valid for the store's life.
+    // Lookups take string_views and never allocate.
+    //
+    // A store layered 'over' another one sees the base variables without copying
+    // their text, its own assignments shadow them. The base must outlive it.
+    class variable_store {
+      public:
+        using id_t = uint32_t;
+
+        static constexpr id_t npos = std::numeric_limits<id_t>::max();
+
+        static variable_store over(const variable_store &base);
+
+        variable_store() = default;
+        ~variable_store() = default;
+
+        variable_store(variable_store &&) = default;
+        // Copies end up owning all of their text, a layered store is flattened
+        variable_store(const variable_store &other);
+
+        variable_store &operator=(variable_store &&) = default;
+        variable_store &operator=(const variable_store &other);
+
+        // Id of 'name', added as undefined when it isn't known yet
+        id_t intern(std::string_view name);
+        // 'npos' when 'name' isn't known, known names might still be undefined
+        id_t find(std::string_view name) const;
+
+        void set(std::string_view name, std::string_view value);
+        void set(id_t id, std::string_view value);
+
+        bool contains(std::string_view name) const;
+        std::optional<std::string_view> get(std::string_view name) const;
+        // Throws std::out_of_range when 'name' isn't defined
+        std::string_view at(std::string_view name) const;
+
+        // Ids run from 0 to size(), defined or not
+        std::size_t size() const;
+        bool defined(id_t id) const;
+        std::string_view name(id_t id) const;
+        std::string_view value(id_t id) const;
+
+        // Calls 'fn(name, value)' for every defined variable, in id order
+        template <typename Fn>
+        void forEach(Fn &&fn) const {
+            for (id_t id = 0; id < m_Names.size(); ++id) {
+                if (m_Defined[id]) {
+                    fn(m_Names[id], m_Values[id]);
+                }
+            }
+        }
+
+      private:
+        std::string_view store(std::string_view text);
+
+        const variable_store *m_Base = nullptr;
+
+        std::vector<std::string_view> m_Names;
+        std::vector<std::string_view> m_Values;
+        std::vector<bool> m_Defined;
+        // Only the names added to this store, the base ones are found through m_Base
+        std::unordered_map<std::string_view, id_t> m_Index;
+
+        // The last block is the one being filled
+        std::vector<std::unique_ptr<char[]>> m_Blocks;
+        std::size_t m_BlockUsed = 0;
+    };
+
+}
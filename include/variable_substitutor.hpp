@@ -1,14 +1,14 @@
 #pragma once
 
+#include <string>
 #include <string_view>
-#include <unordered_map>
+
+#include "variable_store.hpp"
 
 namespace arti {
     
     class variable_substitutor {
       public:
-        using variables_map = std::unordered_map<std::string, std::string>;
-
         variable_substitutor() = delete;
         ~variable_substitutor() = delete;
 
@@ -18,7 +18,7 @@ namespace arti {
         variable_substitutor &operator=(variable_substitutor &&) = delete;
         variable_substitutor &operator=(const variable_substitutor &) = delete;
 
-        static std::string run(const std::string &line, const variables_map &vars);
+        static std::string run(const std::string &line, const variable_store &vars);
     };
 
 }
@@ -0,0 +1,502 @@
+#include "batch.hpp"
+
+#include <fstream>
+#include <optional>
+
+#include <toml.hpp>
+
+#include <fmt/format.h>
+
+#include "utils/thread_pool.hpp"
+
+namespace arti {
+
+    namespace {
+
+        variable_store named(std::string_view name) {
+            variable_store vars;
+            vars.set("name", name);
+
+            return vars;
+        }
+
+        // Just enough JSON for flat manifest lines: a string or an object of scalars
+        class jsonl_line_parser {
+          public:
+            explicit jsonl_line_parser(std::string_view line)
+                : m_Line(line) {
+            }
+
+            std::optional<variable_store> parse() {
+                skipSpaces();
+
+                if (peek() == '"') {
+                    auto name = parseString();
+
+                    if (! name || ! atEnd()) {
+                        return std::nullopt;
+                    }
+
+                    return named(*name);
+                }
+
+                if (! consume('{')) {
+                    return std::nullopt;
+                }
+
+                variable_store vars;
+
+                skipSpaces();
+
+                if (consume('}')) {
+                    return atEnd() ? std::optional{ std::move(vars) } : std::nullopt;
+                }
+
+                for (;;) {
+                    skipSpaces();
+
+                    auto key = parseString();
+
+                    skipSpaces();
+
+                    if (! key || ! consume(':')) {
+                        return std::nullopt;
+                    }
+
+                    skipSpaces();
+
+                    auto value = parseScalar();
+
+                    if (! value) {
+                        return std::nullopt;
+                    }
+
+                    vars.set(*key, *value);
+
+                    skipSpaces();
+
+                    if (consume(',')) {
+                        continue;
+                    }
+
+                    if (consume('}')) {
+                        break;
+                    }
+
+                    return std::nullopt;
+                }
+
+                return atEnd() ? std::optional{ std::move(vars) } : std::nullopt;
+            }
+
+          private:
+            char peek() const {
+                return m_Pos < m_Line.size() ? m_Line[m_Pos] : '\0';
+            }
+
+            bool consume(char c) {
+                if (peek() == c) {
+                    ++m_Pos;
+                    return true;
+                }
+
+                return false;
+            }
+
+            void skipSpaces() {
+                while (m_Pos < m_Line.size() && (m_Line[m_Pos] == ' ' || m_Line[m_Pos] == '\t' || m_Line[m_Pos] == '\r')) {
+                    ++m_Pos;
+                }
+            }
+
+            bool atEnd() {
+                skipSpaces();
+                return m_Pos == m_Line.size();
+            }
+
+            static void appendUtf8(std::string &out, uint32_t cp) {
+                if (cp < 0x80) {
+                    out += static_cast<char>(cp);
+                }
+                else if (cp < 0x800) {
+                    out += static_cast<char>(0xC0 | (cp >> 6));
+                    out += static_cast<char>(0x80 | (cp & 0x3F));
+                }
+                else if (cp < 0x10000) {
+                    out += static_cast<char>(0xE0 | (cp >> 12));
+                    out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+                    out += static_cast<char>(0x80 | (cp & 0x3F));
+                }
+                else {
+                    out += static_cast<char>(0xF0 | (cp >> 18));
+                    out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+                    out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+                    out += static_cast<char>(0x80 | (cp & 0x3F));
+                }
+            }
+
+            std::optional<uint32_t> parseHex4() {
+                if (m_Pos + 4 > m_Line.size()) {
+                    return std::nullopt;
+                }
+
+                uint32_t cp = 0;
+
+                for (int i = 0; i < 4; ++i) {
+                    const char c = m_Line[m_Pos++];
+                    cp <<= 4;
+
+                    if (c >= '0' && c <= '9') {
+                        cp |= c - '0';
+                    }
+                    else if (c >= 'a' && c <= 'f') {
+                        cp |= c - 'a' + 10;
+                    }
+                    else if (c >= 'A' && c <= 'F') {
+                        cp |= c - 'A' + 10;
+                    }
+                    else {
+                        return std::nullopt;
+                    }
+                }
+
+                return cp;
+            }
+
+            std::optional<std::string> parseString() {
+                if (! consume('"')) {
+                    return std::nullopt;
+                }
+
+                std::string out;
+
+                while (m_Pos < m_Line.size()) {
+                    const char c = m_Line[m_Pos++];
+
+                    if (c == '"') {
+                        return out;
+                    }
+
+                    if (c != '\\') {
+                        out += c;
+                        continue;
+                    }
+
+                    if (m_Pos == m_Line.size()) {
+                        break;
+                    }
+
+                    switch (const char e = m_Line[m_Pos++]) {
+                        case '"':
+                        case '\\':
+                        case '/':
+                            out += e;
+                            break;
+                        case 'b':
+                            out += '\b';
+                            break;
+                        case 'f':
+                            out += '\f';
+                            break;
+                        case 'n':
+                            out += '\n';
+                            break;
+                        case 'r':
+                            out += '\r';
+                            break;
+                        case 't':
+                            out += '\t';
+                            break;
+                        case 'u': {
+                            auto cp = parseHex4();
+
+                            if (! cp) {
+                                return std::nullopt;
+                            }
+
+                            if (*cp >= 0xD800 && *cp < 0xDC00 && consume('\\') && consume('u')) {
+                                auto low = parseHex4();
+
+                                if (! low || *low < 0xDC00 || *low > 0xDFFF) {
+                                    return std::nullopt;
+                                }
+
+                                *cp = 0x10000 + ((*cp - 0xD800) << 10) + (*low - 0xDC00);
+                            }
+
+                            appendUtf8(out, *cp);
+                            break;
+                        }
+                        default:
+                            return std::nullopt;
+                    }
+                }
+
+                return std::nullopt;
+            }
+
+            std::optional<std::string> parseScalar() {
+                if (peek() == '"') {
+                    return parseString();
+                }
+
+                const auto begin = m_Pos;
+
+                while (m_Pos < m_Line.size() && m_Line[m_Pos] != ',' && m_Line[m_Pos] != '}' && m_Line[m_Pos] != ' ') {
+                    ++m_Pos;
+                }
+
+                const auto raw = m_Line.substr(begin, m_Pos - begin);
+
+                if (raw.empty() || raw == "null") {
+                    return raw.empty() ? std::nullopt : std::optional<std::string>{ "" };
+                }
+
+                if (raw == "true" || raw == "false" || raw.find_first_not_of("+-.eE0123456789") == std::string_view::npos) {
+                    return std::string{ raw };
+                }
+
+                return std::nullopt;
+            }
+
+            std::string_view m_Line;
+            std::size_t m_Pos = 0;
+        };
+
+        std::string labelOf(const variable_store &vars, std::size_t index) {
+            if (auto name = vars.get("name")) {
+                return std::string{ *name };
+            }
+
+            return fmt::format("#{}", index + 1);
+        }
+
+    }
+
+    batch::expected_t batch::loadManifest(const fs::path &manifest) {
+        using error_t = expected_t::unexpected_type;
+
+        if (! fs::exists(manifest)) {
+            return error_t{ { errors::NotFound, fmt::format("Batch manifest '{}' not found", manifest.string()) } };
+        }
+
+        instances_t instances;
+
+        const auto extension = manifest.extension().string();
+
+        if (extension == ".jsonl" || extension == ".json") {
+            std::ifstream input{ manifest };
+            std::string line;
+            std::size_t lineNumber = 0;
+
+            while (std::getline(input, line)) {
+                ++lineNumber;
+
+                if (line.find_first_not_of(" \t\r") == std::string::npos) {
+                    continue;
+                }
+
+                auto vars = jsonl_line_parser{ line }.parse();
+
+                if (! vars) {
+                    return error_t{ { errors::ParseError, fmt::format("{}:{}: expected a string or a flat JSON object", manifest.string(), lineNumber) } };
+                }
+
+                instances.push_back({ labelOf(*vars, instances.size()), std::move(*vars) });
+            }
+
+            return std::move(instances);
+        }
+
+        toml::table table;
+
+        try {
+            table = toml::parse_file(manifest.string());
+        }
+        catch(std::exception &e) {
+            return error_t{ { errors::ParseError, fmt::format("Couldn't parse batch manifest '{}': {}", manifest.string(), e.what()) } };
+        }
+
+        if (auto names = table.get_as<toml::array>("names")) {
+            for (std::size_t i = 0; i < names->size(); ++i) {
+                const auto *name = names->get_as<std::string>(i);
+
+                // Anything else would become an empty name, generating into the current directory itself
+                if (! name) {
+                    return error_t{ { errors::ParseError, fmt::format("'names' entry #{} of '{}' must be a string", i + 1, manifest.string()) } };
+                }
+
+                instances.push_back({ {}, named(name->get()) });
+                instances.back().label = labelOf(instances.back().vars, instances.size() - 1);
+            }
+        }
+
+        if (auto tables = table.get_as<toml::array>("instance")) {
+            for (const auto &node : *tables) {
+                const auto *instanceTable = node.as_table();
+
+                if (! instanceTable) {
+                    return error_t{ { errors::ParseError, fmt::format("'instance' entries of '{}' must be tables", manifest.string()) } };
+                }
+
+                variable_store vars;
+
+                for (const auto &[key, value] : *instanceTable) {
+                    const std::string_view k{ key.str() };
+                    bool scalar = true;
+
+                    // Booleans read as the JSONL manifests' 'true' and 'false'
+                    value.visit([&](auto &&v) {
+                        if constexpr (toml::is_string<decltype(v)>) {
+                            vars.set(k, v.template value_or<std::string>(""));
+                        }
+                        else if constexpr (toml::is_integer<decltype(v)>) {
+                            vars.set(k, std::to_string(v.template value_or<int64_t>(0)));
+                        }
+                        else if constexpr (toml::is_floating_point<decltype(v)>) {
+                            vars.set(k, std::to_string(v.template value_or<double>(0.0)));
+                        }
+                        else if constexpr (toml::is_boolean<decltype(v)>) {
+                            vars.set(k, v.template value_or<bool>(false) ? "true" : "false");
+                        }
+                        else {
+                            scalar = false;
+                        }
+                    });
+
+                    if (! scalar) {
+                        return error_t{ { errors::ParseError, fmt::format("'{}' of instance #{} in '{}' must be a string, number or boolean", k, instances.size() + 1, manifest.string()) } };
+                    }
+                }
+
+                instances.push_back({ labelOf(vars, instances.size()), std::move(vars) });
+            }
+        }
+
+        return std::move(instances);
+    }
+
+    batch::instances_t batch::fromNames(const std::vector<std::string> &names) {
+        instances_t instances;
+        instances.reserve(names.size());
+
+        for (const auto &name : names) {
+            instances.push_back({ name, named(name) });
+        }
+
+        return instances;
+    }
+
+    batch::batch(generator_template template_v, std::shared_ptr<const template_program> program, instances_t instances)
+        : m_Template(std::move(template_v))
+        , m_Program(std::move(program))
+        , m_Instances(std::move(instances)) {
+    }
+
+    tl::expected<void, std::string> batch::run(const opt::variables_map &params, const generator::run_options &options, const output_t &output) const {
+        enum class outcomes {
+            Created,
+            Skipped,
+            Failed
+        };
+
+        struct result {
+            outcomes outcome = outcomes::Created;
+            std::string error;
+            generator::run_report report;
+        };
+
+        std::vector<result> results(m_Instances.size());
+
+        // Instances are already spread across the workers
+        auto instanceOptions = options;
+        instanceOptions.jobs = 1;
+
+        const auto generateInstance = [&](std::size_t i) {
+            auto &current = results[i];
+
+            // Its own 'uuid' and 'random_seed', the dates and the identity are the batch's
+            auto instanceTemplate = m_Template;
+            instanceTemplate.startProject();
+
+            generator gen{ std::move(instanceTemplate) };
+
+            auto ex = gen.loadVars(params, m_Instances[i].vars, m_Program.get());
+
+            if (ex) {
+                ex = gen.run(*m_Program, instanceOptions, current.report);
+            }
+
+            if (! ex) {
+                current.outcome = current.report.rootExisted ? outcomes::Skipped : outcomes::Failed;
+                current.error = std::move(ex).error();
+            }
+        };
+
+        if (options.jobs > 1) {
+            utils::thread_pool pool{ options.jobs };
+
+            for (std::size_t i = 0; i < m_Instances.size(); ++i) {
+                pool.submit([&, i] {
+                    generateInstance(i);
+                });
+            }
+
+            pool.wait();
+        }
+        else {
+            for (std::size_t i = 0; i < m_Instances.size(); ++i) {
+                generateInstance(i);
+            }
+        }
+
+        std::size_t created = 0;
+        std::size_t skipped = 0;
+        std::size_t failed = 0;
+        std::size_t files = 0;
+        std::size_t directories = 0;
+
+        for (std::size_t i = 0; i < m_Instances.size(); ++i) {
+            const auto &current = results[i];
+            const auto &label = m_Instances[i].label;
+
+            for (const auto &message : current.report.messages) {
+                output(fmt::format("[{}] {}\n", label, message));
+            }
+
+            files += current.report.filesCreated;
+            directories += current.report.directoriesCreated;
+
+            switch (current.outcome) {
+                case outcomes::Created:
+                    ++created;
+                    output(fmt::format("[{}] created {} files, {} directories\n", label, current.report.filesCreated, current.report.directoriesCreated));
+                    break;
+                case outcomes::Skipped:
+                    ++skipped;
+                    output(fmt::format("[{}] skipped: {}\n", label, current.error));
+                    break;
+                case outcomes::Failed:
+                    ++failed;
+                    output(fmt::format("[{}] failed: {}\n", label, current.error));
+                    break;
+            }
+        }
+
+        output(fmt::format(
+            "\nBatch summary: {} created, {} skipped, {} failed ({} files, {} directories written)\n",
+            created,
+            skipped,
+            failed,
+            files,
+            directories
+        ));
+
+        if (failed > 0) {
+            return tl::unexpected<std::string>{ fmt::format("{} of {} instances failed", failed, m_Instances.size()) };
+        }
+
+        return {};
+    }
+
+}
@@ -0,0 +1,341 @@
+#include "builtin_providers.hpp"
+
+#include <array>
+#include <random>
+#include <cstdlib>
+#include <fstream>
+#include <algorithm>
+#include <unordered_set>
+
+#include <pwd.h>
+#include <unistd.h>
+
+#include <fmt/format.h>
+#include <fmt/chrono.h>
+
+#include "compiled_template.hpp"
+
+namespace arti {
+
+    namespace {
+        constexpr std::string_view EnvPrefix = "env_";
+
+        constexpr std::array<std::string_view, 11> Names{
+            "now",
+            "today",
+            "year",
+            "cwd",
+            "full_cwd",
+            "hostname",
+            "user",
+            "git_user",
+            "git_email",
+            "uuid",
+            "random_seed"
+        };
+
+        // Different for every project generated by a run
+        constexpr std::array<std::string_view, 2> ProjectNames{
+            "uuid",
+            "random_seed"
+        };
+
+        std::string_view trim(std::string_view text) {
+            constexpr std::string_view Spaces = " \t\r\n";
+
+            const auto begin = text.find_first_not_of(Spaces);
+
+            if (begin == std::string_view::npos) {
+                return {};
+            }
+
+            return text.substr(begin, text.find_last_not_of(Spaces) - begin + 1);
+        }
+
+        // The '[user]' name and email of a single git config file, a later file overrides an earlier one
+        void readUserSection(const fs::path &path, std::optional<std::string> &name, std::optional<std::string> &email) {
+            std::ifstream file{ path };
+            std::string line;
+            bool inUser = false;
+
+            while (std::getline(file, line)) {
+                const auto current = trim(line);
+
+                if (current.empty() || current.front() == '#' || current.front() == ';') {
+                    continue;
+                }
+
+                if (current.front() == '[') {
+                    inUser = current == "[user]";
+                    continue;
+                }
+
+                const auto equals = current.find('=');
+
+                if (! inUser || equals == std::string_view::npos) {
+                    continue;
+                }
+
+                const auto key = trim(current.substr(0, equals));
+                auto value = trim(current.substr(equals + 1));
+
+                if (value.size() >= 2 && value.front() == '"' && value.back() == '"') {
+                    value = value.substr(1, value.size() - 2);
+                }
+
+                if (key == "name") {
+                    name = std::string{ value };
+                }
+                else if (key == "email") {
+                    email = std::string{ value };
+                }
+            }
+        }
+
+        std::string makeUuid() {
+            std::random_device device;
+            std::array<uint8_t, 16> bytes;
+
+            for (auto &byte : bytes) {
+                byte = static_cast<uint8_t>(device());
+            }
+
+            // Version 4, variant 1
+            bytes[6] = (bytes[6] & 0x0f) | 0x40;
+            bytes[8] = (bytes[8] & 0x3f) | 0x80;
+
+            return fmt::format(
+                "{:02x}{:02x}{:02x}{:02x}-{:02x}{:02x}-{:02x}{:02x}-{:02x}{:02x}-{:02x}{:02x}{:02x}{:02x}{:02x}{:02x}",
+                bytes[0], bytes[1], bytes[2], bytes[3], bytes[4], bytes[5], bytes[6], bytes[7],
+                bytes[8], bytes[9], bytes[10], bytes[11], bytes[12], bytes[13], bytes[14], bytes[15]
+            );
+        }
+    }
+
+    builtin_providers::builtin_providers(fs::path cwd, environment_ptr environment)
+        : m_Cwd(std::move(cwd))
+        , m_Environment(std::move(environment)) {
+    }
+
+    builtin_providers::builtin_providers(std::shared_ptr<builtin_providers> run)
+        : m_Run(run->m_Run ? run->m_Run : std::move(run)) {
+    }
+
+    bool builtin_providers::provides(std::string_view name) {
+        if (name.starts_with(EnvPrefix)) {
+            return name.size() > EnvPrefix.size();
+        }
+
+        return std::find(Names.begin(), Names.end(), name) != Names.end();
+    }
+
+    std::optional<std::string_view> builtin_providers::get(std::string_view name) {
+        if (! provides(name)) {
+            return std::nullopt;
+        }
+
+        if (m_Run && std::find(ProjectNames.begin(), ProjectNames.end(), name) == ProjectNames.end()) {
+            return m_Run->get(name);
+        }
+
+        std::lock_guard lock{ m_Mutex };
+
+        auto it = m_Values.find(std::string{ name });
+
+        if (it == m_Values.end()) {
+            it = m_Values.emplace(name, compute(name)).first;
+        }
+
+        if (! it->second) {
+            return std::nullopt;
+        }
+
+        return std::string_view{ *it->second };
+    }
+
+    void builtin_providers::provide(const std::vector<std::string_view> &referenced, variable_store &vars) {
+        std::vector<std::string> pending{ referenced.begin(), referenced.end() };
+        std::unordered_set<std::string> seen;
+        std::vector<std::string> wanted;
+
+        while (! pending.empty()) {
+            auto name = std::move(pending.back());
+            pending.pop_back();
+
+            if (! seen.insert(name).second) {
+                continue;
+            }
+
+            // A defined variable shadows the built-in, what its value references is needed instead
+            if (const auto value = vars.get(name)) {
+                const auto compiled = compiled_template::compileView(*value);
+
+                for (const auto &chain : compiled.chains()) {
+                    pending.emplace_back(chain.variable());
+                }
+            }
+            else if (provides(name)) {
+                wanted.push_back(std::move(name));
+            }
+        }
+
+        for (const auto &name : wanted) {
+            if (const auto value = get(name)) {
+                vars.set(name, *value);
+            }
+        }
+    }
+
+    void builtin_providers::provideAll(variable_store &vars) {
+        for (const auto name : Names) {
+            if (vars.contains(name)) {
+                continue;
+            }
+
+            if (const auto value = get(name)) {
+                vars.set(name, *value);
+            }
+        }
+    }
+
+    std::optional<std::string> builtin_providers::compute(std::string_view name) {
+        if (name.starts_with(EnvPrefix)) {
+            const auto value = variable(name.substr(EnvPrefix.size()));
+
+            return value ? std::optional<std::string>{ *value } : std::nullopt;
+        }
+
+        if (name == "now") {
+            return fmt::format("{:%A %B %d, %Y - %I:%M:%S%p}", localTime());
+        }
+
+        if (name == "today") {
+            return fmt::format("{:%A %B %d, %Y}", localTime());
+        }
+
+        if (name == "year") {
+            return fmt::format("{:%Y}", localTime());
+        }
+
+        if (name == "cwd") {
+            return cwd().filename().string();
+        }
+
+        if (name == "full_cwd") {
+            return cwd().string();
+        }
+
+        if (name == "hostname") {
+            std::array<char, 256> host{};
+
+            if (::gethostname(host.data(), host.size() - 1) != 0) {
+                return std::nullopt;
+            }
+
+            return std::string{ host.data() };
+        }
+
+        if (name == "user") {
+            for (const auto current : { "USER", "LOGNAME" }) {
+                if (const auto value = variable(current); value && ! value->empty()) {
+                    return std::string{ *value };
+                }
+            }
+
+            // The daemon's user isn't its client's, only what the client sent counts
+            if (m_Environment) {
+                return std::nullopt;
+            }
+
+            if (const auto *entry = ::getpwuid(::geteuid())) {
+                return std::string{ entry->pw_name };
+            }
+
+            return std::nullopt;
+        }
+
+        if (name == "git_user" || name == "git_email") {
+            readGitConfig();
+
+            return m_Values[std::string{ name }];
+        }
+
+        if (name == "uuid") {
+            return makeUuid();
+        }
+
+        if (name == "random_seed") {
+            return std::to_string(std::random_device{}());
+        }
+
+        return std::nullopt;
+    }
+
+    const std::tm &builtin_providers::localTime() {
+        // Every date of a run comes from the same instant
+        if (! m_Time) {
+            m_Time = fmt::localtime(std::time(nullptr));
+        }
+
+        return *m_Time;
+    }
+
+    const fs::path &builtin_providers::cwd() {
+        if (m_Cwd.empty()) {
+            m_Cwd = fs::current_path();
+        }
+
+        return m_Cwd;
+    }
+
+    std::optional<std::string_view> builtin_providers::variable(std::string_view name) const {
+        if (m_Environment) {
+            const auto it = m_Environment->find(std::string{ name });
+
+            return it != m_Environment->end() ? std::optional<std::string_view>{ it->second } : std::nullopt;
+        }
+
+        const char *value = std::getenv(std::string{ name }.c_str());
+
+        return value ? std::optional<std::string_view>{ value } : std::nullopt;
+    }
+
+    void builtin_providers::readGitConfig() {
+        std::optional<std::string> name;
+        std::optional<std::string> email;
+
+        readUserSection("/etc/gitconfig", name, email);
+
+        const auto home = variable("HOME").value_or(std::string_view{});
+        const auto xdgConfig = variable("XDG_CONFIG_HOME").value_or(std::string_view{});
+
+        if (! xdgConfig.empty()) {
+            readUserSection(fs::path{ xdgConfig } / "git" / "config", name, email);
+        }
+        else if (! home.empty()) {
+            readUserSection(fs::path{ home } / ".config" / "git" / "config", name, email);
+        }
+
+        if (! home.empty()) {
+            readUserSection(fs::path{ home } / ".gitconfig", name, email);
+        }
+
+        // The repository holding the output, if any
+        std::error_code ec;
+
+        for (auto dir = cwd(); ! dir.empty(); dir = dir.parent_path()) {
+            if (fs::is_directory(dir / ".git", ec)) {
+                readUserSection(dir / ".git" / "config", name, email);
+                break;
+            }
+
+            if (dir == dir.root_path()) {
+                break;
+            }
+        }
+
+        m_Values.insert_or_assign("git_user", std::move(name));
+        m_Values.insert_or_assign("git_email", std::move(email));
+    }
+
+}
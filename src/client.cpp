@@ -0,0 +1,83 @@
+#include "client.hpp"
+
+#include <unistd.h>
+
+#include <fmt/format.h>
+
+#include "server.hpp"
+
+#include "utils/binary.hpp"
+#include "utils/socket.hpp"
+
+namespace arti {
+
+    tl::expected<int, std::string> client::forward(
+        const fs::path &socketPath,
+        int argc,
+        char *argv[],
+        const fs::path &cwd,
+        const command::output_t &output
+    ) {
+        using error_t = tl::unexpected<std::string>;
+
+        auto connectionEx = utils::unix_socket::connect(socketPath);
+
+        if (! connectionEx) {
+            auto [errorCode, errorInfo] = std::move(connectionEx).error();
+
+            return error_t{ fmt::format("Couldn't reach the daemon, start it with '--serve' ({})", errorInfo) };
+        }
+
+        auto connection = std::move(connectionEx).value();
+
+        utils::binary_writer request;
+
+        request.str(cwd.string());
+        request.u64(argc > 0 ? argc - 1 : 0);
+
+        for (int i = 1; i < argc; ++i) {
+            request.str(argv[i]);
+        }
+
+        // The built-ins reading the environment see the client's, not the daemon's
+        uint64_t variableCount = 0;
+
+        while (environ[variableCount]) {
+            ++variableCount;
+        }
+
+        request.u64(variableCount);
+
+        for (uint64_t i = 0; i < variableCount; ++i) {
+            request.str(environ[i]);
+        }
+
+        if (! connection.sendFrame(request.buffer())) {
+            return error_t{ "Couldn't send the request to the daemon" };
+        }
+
+        while (auto frame = connection.receiveFrame()) {
+            utils::binary_reader in{ *frame };
+
+            const auto kind = static_cast<server::frames>(in.u64());
+
+            if (kind == server::frames::Output) {
+                const auto text = in.str();
+
+                if (! in.failed()) {
+                    output(text);
+                }
+            }
+            else if (kind == server::frames::Exit) {
+                const auto code = static_cast<int>(in.u64());
+
+                if (! in.failed()) {
+                    return code;
+                }
+            }
+        }
+
+        return error_t{ "The daemon closed the connection before finishing the request" };
+    }
+
+}
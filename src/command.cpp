@@ -0,0 +1,822 @@
+#include "command.hpp"
+
+#include <array>
+#include <chrono>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <optional>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <fmt/format.h>
+
+#include "internal/config.hpp"
+
+#include "options_parser.hpp"
+#include "template_pack.hpp"
+#include "template_registry.hpp"
+#include "batch.hpp"
+#include "stream_renderer.hpp"
+#include "variable_resolver.hpp"
+#include "server.hpp"
+#include "client.hpp"
+#include "utils/tar.hpp"
+#include "utils/json.hpp"
+#include "utils/trace.hpp"
+#include "utils/watch.hpp"
+#include "utils/thread_pool.hpp"
+
+namespace arti {
+
+    command::context command::local() {
+        return {
+            fs::current_path(),
+            [](std::string_view name, template_cache::modes mode) -> tl::expected<loaded_ptr, std::string> {
+                auto loadedEx = template_cache::load(name, mode);
+
+                if (! loadedEx) {
+                    return tl::unexpected<std::string>{ std::move(loadedEx).error() };
+                }
+
+                return std::make_shared<const template_cache::loaded_t>(std::move(loadedEx).value());
+            },
+            [](std::string_view text) {
+                fmt::print("{}", text);
+            }
+        };
+    }
+
+    int command::run(int argc, char *argv[], const context &ctx) {
+        auto parserEx = [&] {
+            arti::options_parser options;
+
+            return options.parse(argc, argv);
+        }();
+
+        if (!parserEx) {
+            auto [errorCode, errorInfo] = std::move(parserEx).error();
+
+            switch (errorCode) {
+                case decltype(errorCode)::Empty:
+                    ctx.output(fmt::format("{}, see usage with '--help' or '-h'\n", errorInfo));
+                    break;
+                case decltype(errorCode)::Help:
+                    ctx.output(fmt::format("{}\n", errorInfo));
+                    break;
+                case decltype(errorCode)::Invalid:
+                    ctx.output(fmt::format("Invalid params provided: '{}'\n", errorInfo));
+                    break;
+            }
+
+            return 1;
+        }
+
+        auto options = std::move(parserEx).value();
+
+        if (options.contains("serve")) {
+            if (ctx.remote) {
+                ctx.output("A daemon can't be started through another one\n");
+                return 1;
+            }
+
+            server server_v{ socketPath(options) };
+
+            if (auto ex = server_v.serve(); ! ex) {
+                ctx.output(fmt::format("{}\n", ex.error()));
+                return 1;
+            }
+
+            return 0;
+        }
+
+        if (options.contains("client") && ! ctx.remote) {
+            auto forwardEx = client::forward(socketPath(options), argc, argv, ctx.cwd, ctx.output);
+
+            if (! forwardEx) {
+                ctx.output(fmt::format("{}\n", forwardEx.error()));
+                return 1;
+            }
+
+            return forwardEx.value();
+        }
+
+        // A streamed archive or render owns stdout, everything else goes to stderr
+        auto runCtx = ctx;
+
+        const bool ownsStdout = (options.contains("tar") && options.at("tar").as<std::string>() == "-") || options.contains("render");
+
+        if (! ctx.remote && ownsStdout) {
+            runCtx.output = [](std::string_view text) {
+                fmt::print(stderr, "{}", text);
+            };
+        }
+
+        const bool instrumented = options.contains("stats") || options.contains("trace");
+
+        if (! instrumented) {
+            return execute(options, runCtx);
+        }
+
+        // Counters and spans are process wide, concurrent requests would mix theirs
+        if (runCtx.remote) {
+            runCtx.output("'--stats' and '--trace' aren't available through the daemon\n");
+            return 1;
+        }
+
+        utils::trace::enable();
+
+        const int code = execute(options, runCtx);
+
+        if (options.contains("stats")) {
+            runCtx.output(utils::trace::stats());
+        }
+
+        if (options.contains("trace")) {
+            const auto tracePath = runCtx.cwd / options.at("trace").as<std::string>();
+
+            if (! utils::trace::writeChromeTrace(tracePath)) {
+                runCtx.output(fmt::format("Couldn't write the trace to '{}'\n", tracePath.string()));
+                return 1;
+            }
+        }
+
+        return code;
+    }
+
+    int command::execute(const opt::variables_map &options, const context &ctx) {
+        if (options.contains("version")) {
+            printVersion(ctx);
+            return 1;
+        }
+
+        // TODO: Implement TUI
+
+        if (options.contains("interactive")) {
+            ctx.output("Interactive TUI not implemented yet!\n");
+            return 1;
+        }
+
+        if (options.contains("pack")) {
+            return packTemplate(options, ctx);
+        }
+
+        if (options.contains("render")) {
+            return renderStream(options, ctx);
+        }
+
+        using span = utils::trace::span;
+
+        auto loadTemplateEx = [&] {
+            const span phase{ span::kinds::Phase, "load template" };
+
+            return loadTemplate(options, ctx);
+        }();
+
+        if (!loadTemplateEx) {
+            ctx.output(fmt::format("Error loading the template: {}\n", loadTemplateEx.error()));
+
+            return 1;
+        }
+
+        auto loaded = std::move(loadTemplateEx).value();
+
+        const bool dryRun = options.contains("dry-run") || options.contains("plan");
+
+        if (dryRun && isBatch(options)) {
+            ctx.output("A dry run plans a single generation, it can't be combined with a batch\n");
+            return 1;
+        }
+
+        const bool toArchive = options.contains("tar");
+
+        if (! toArchive && options.contains("zstd")) {
+            ctx.output("'--zstd' compresses the archive written by '--tar' or the entries written by '--pack'\n");
+            return 1;
+        }
+
+        if (toArchive && (isBatch(options) || options.contains("update"))) {
+            ctx.output("A tar archive holds a single fresh generation, it can't be combined with a batch or '--update'\n");
+            return 1;
+        }
+
+        if (options.contains("watch")) {
+            if (dryRun || toArchive || isBatch(options)) {
+                ctx.output("'--watch' keeps a single generation on disk up to date, it can't be combined with a batch, '--tar' or a dry run\n");
+                return 1;
+            }
+
+            return watchTemplate(std::move(loaded), options, ctx);
+        }
+
+        if (isBatch(options)) {
+            return runBatch(std::move(loaded), options, ctx);
+        }
+
+        auto template_v = loaded->template_v;
+        template_v.setWorkingDirectory(ctx.cwd, ctx.environment);
+
+        arti::generator gen{ std::move(template_v) };
+
+        auto varsEx = [&] {
+            const span phase{ span::kinds::Phase, "resolve variables" };
+
+            return gen.loadVars(options, {}, &loaded->program);
+        }();
+
+        if (! varsEx) {
+            ctx.output(fmt::format("{}\n", varsEx.error()));
+            return 1;
+        }
+
+        if (dryRun) {
+            return printPlan(gen, *loaded, options, ctx);
+        }
+
+        std::optional<utils::tar_writer> archive;
+
+        if (toArchive) {
+            const auto target = options.at("tar").as<std::string>();
+
+            if (target == "-" && ctx.remote) {
+                ctx.output("The daemon can't stream an archive to the client's stdout, give '--tar' a file\n");
+                return 1;
+            }
+
+            const auto level = options.contains("zstd") ? options.at("zstd").as<int>() : 0;
+            auto archiveEx = utils::tar_writer::open(target == "-" ? target : (ctx.cwd / target).string(), level);
+
+            if (! archiveEx) {
+                ctx.output(fmt::format("Couldn't open the archive: {}\n", archiveEx.error().info));
+                return 1;
+            }
+
+            archive.emplace(std::move(archiveEx).value());
+        }
+
+        arti::generator::run_report report;
+
+        auto runEx = [&] {
+            const span phase{ span::kinds::Phase, "generate" };
+
+            auto runOptions = loadRunOptions(options, ctx);
+
+            if (archive) {
+                runOptions.archive = &archive.value();
+            }
+
+            return gen.run(loaded->program, runOptions, report);
+        }();
+
+        for (const auto &message : report.messages) {
+            ctx.output(fmt::format("{}\n", message));
+        }
+
+        if (! runEx) {
+            ctx.output(fmt::format("{}\n", runEx.error()));
+            return 1;
+        }
+
+        if (archive) {
+            if (auto ex = archive->finish(); ! ex) {
+                ctx.output(fmt::format("Couldn't write the archive, {}\n", ex.error().info));
+                return 1;
+            }
+        }
+
+        return 0;
+    }
+
+    int command::printPlan(const generator &gen, const template_cache::loaded_t &loaded, const opt::variables_map &vars, const context &ctx) {
+        using types = template_program::types;
+        using plan_actions = generator::plan_actions;
+
+        auto planEx = [&] {
+            const utils::trace::span phase{ utils::trace::span::kinds::Phase, "generate" };
+
+            return gen.plan(loaded.program, loadRunOptions(vars, ctx), true);
+        }();
+
+        if (! planEx) {
+            ctx.output(fmt::format("{}\n", planEx.error()));
+            return 1;
+        }
+
+        const auto &plan = planEx.value();
+
+        const auto actionName = [](plan_actions action) -> std::string_view {
+            switch (action) {
+                case plan_actions::Create:
+                    return "create";
+                case plan_actions::Replace:
+                    return "replace";
+                case plan_actions::Unchanged:
+                    return "unchanged";
+                case plan_actions::Skip:
+                    return "skip";
+                case plan_actions::Conflict:
+                    return "conflict";
+            }
+
+            return "unknown";
+        };
+
+        std::array<std::size_t, 5> counts{};
+        std::vector<std::string> warnings = plan.messages;
+        std::string entries;
+
+        for (const auto &entry : plan.entries) {
+            ++counts[static_cast<std::size_t>(entry.action)];
+            warnings.insert(warnings.end(), entry.messages.begin(), entry.messages.end());
+
+            if (! entries.empty()) {
+                entries += ",\n";
+            }
+
+            if (entry.directory) {
+                entries += fmt::format(
+                    R"(    {{ "path": "{}", "kind": "directory", "action": "{}" }})",
+                    utils::escapeJson(entry.path),
+                    actionName(entry.action)
+                );
+            }
+            else {
+                entries += fmt::format(
+                    R"(    {{ "path": "{}", "kind": "file", "action": "{}", "size": {}, "hash": "{:016x}" }})",
+                    utils::escapeJson(entry.path),
+                    actionName(entry.action),
+                    entry.size,
+                    entry.hash
+                );
+            }
+        }
+
+        std::string warningList;
+
+        for (const auto &warning : warnings) {
+            warningList += fmt::format(R"({}"{}")", warningList.empty() ? "" : ", ", utils::escapeJson(warning));
+        }
+
+        ctx.output(fmt::format(
+            "{{\n"
+            R"(  "template": "{}",)" "\n"
+            R"(  "type": "{}",)" "\n"
+            R"(  "output": "{}",)" "\n"
+            R"(  "conflicts": {},)" "\n"
+            R"(  "summary": {{ "create": {}, "replace": {}, "unchanged": {}, "skip": {}, "conflict": {} }},)" "\n"
+            R"(  "warnings": [{}],)" "\n"
+            R"(  "entries": [)" "\n"
+            "{}\n"
+            "  ]\n"
+            "}}\n",
+            utils::escapeJson(vars.at("template").as<std::string>()),
+            plan.type == types::File ? "file" : "folder",
+            utils::escapeJson(plan.output),
+            plan.conflicts,
+            counts[0], counts[1], counts[2], counts[3], counts[4],
+            warningList,
+            entries
+        ));
+
+        // Whatever a real run would refuse to generate fails the dry run as well
+        return plan.conflicts == 0 ? 0 : 1;
+    }
+
+    int command::packTemplate(const opt::variables_map &vars, const context &ctx) {
+        const auto name = vars.at("pack").as<std::string>();
+        const fs::path configPath{ arti::config::config_path };
+
+        auto registryEx = template_registry::open(configPath);
+
+        if (! registryEx) {
+            ctx.output(fmt::format("Error loading the template: {}\n", registryEx.error().info));
+            return 1;
+        }
+
+        auto sectionEx = registryEx->section(name);
+
+        if (! sectionEx) {
+            ctx.output(fmt::format("Error loading the template: {}\n", sectionEx.error().info));
+            return 1;
+        }
+
+        auto templateEx = generator_template::loadFromDirectory(name, configPath);
+
+        if (! templateEx) {
+            ctx.output(fmt::format("Error loading the template: {}\n", templateEx.error().info));
+            return 1;
+        }
+
+        const auto level = vars.contains("zstd") ? vars.at("zstd").as<int>() : 0;
+
+        if (level > 0 && ! utils::tar_writer::compressionSupported()) {
+            ctx.output("This build doesn't support zstd compression\n");
+            return 1;
+        }
+
+        const auto packPath = template_pack::location(configPath, name);
+
+        if (auto ex = template_pack::write(packPath, name, templateEx.value(), sectionEx.value(), level); ! ex) {
+            ctx.output(fmt::format("Couldn't pack the template: {}\n", ex.error().info));
+            return 1;
+        }
+
+        ctx.output(fmt::format("Packed '{}' into '{}', it's used instead of its folder until removed\n", name, packPath.string()));
+
+        return 0;
+    }
+
+    int command::renderStream(const opt::variables_map &vars, const context &ctx) {
+        if (ctx.remote) {
+            ctx.output("The daemon can't stream to the client's stdout, run '--render' without '--client'\n");
+            return 1;
+        }
+
+        // A template only brings its variables along, 'name' isn't required
+        std::optional<generator_template> template_v;
+        variable_store renderVars;
+
+        if (vars.contains("template")) {
+            auto loadedEx = loadTemplate(vars, ctx);
+
+            if (! loadedEx) {
+                ctx.output(fmt::format("Error loading the template: {}\n", loadedEx.error()));
+                return 1;
+            }
+
+            template_v.emplace(loadedEx.value()->template_v);
+
+            renderVars = variable_store::over(template_v->defaultVars());
+        }
+
+        if (vars.contains("name")) {
+            renderVars.set("name", vars.at("name").as<std::vector<std::string>>().front());
+        }
+
+        if (auto ex = generator::loadDefines(vars, renderVars); ! ex) {
+            ctx.output(fmt::format("{}\n", ex.error()));
+            return 1;
+        }
+
+        // The template isn't known ahead, built-ins it uses are looked up as they're met.
+        // Those the variables use are needed before resolving them.
+        builtin_providers builtins{ ctx.cwd, ctx.environment };
+        std::vector<std::string_view> defined;
+
+        renderVars.forEach([&](std::string_view k, std::string_view) {
+            defined.push_back(k);
+        });
+
+        builtins.provide(defined, renderVars);
+
+        if (auto ex = variable_resolver::resolve(renderVars); ! ex) {
+            ctx.output(fmt::format("{}\n", ex.error().info));
+            return 1;
+        }
+
+        const auto source = vars.at("render").as<std::string>();
+        const auto sourcePath = ctx.cwd / source;
+        const int input = source == "-" ? STDIN_FILENO : ::open(sourcePath.c_str(), O_RDONLY | O_CLOEXEC);
+
+        if (input < 0) {
+            ctx.output(fmt::format("Couldn't open '{}': {}\n", sourcePath.string(), std::strerror(errno)));
+            return 1;
+        }
+
+        auto renderEx = [&] {
+            const utils::trace::span phase{ utils::trace::span::kinds::Phase, "render" };
+
+            return stream_renderer::run(input, STDOUT_FILENO, renderVars, builtins);
+        }();
+
+        if (input != STDIN_FILENO) {
+            ::close(input);
+        }
+
+        if (! renderEx) {
+            const auto [errorCode, errorInfo] = std::move(renderEx).error();
+
+            switch (errorCode) {
+                case decltype(errorCode)::UnableToRead:
+                    ctx.output(fmt::format("Couldn't read the template: {}\n", errorInfo));
+                    break;
+                case decltype(errorCode)::UnableToWrite:
+                    ctx.output(fmt::format("Couldn't write the output: {}\n", errorInfo));
+                    break;
+            }
+
+            return 1;
+        }
+
+        for (const auto &name : renderEx->undefined) {
+            ctx.output(fmt::format("Warning: undefined variable '{}' used in '{}'\n", name, source));
+        }
+
+        if (renderEx->tags) {
+            ctx.output("Warning: '{% %}' tags aren't run by '--render', they were written as they are\n");
+        }
+
+        return 0;
+    }
+
+    int command::watchTemplate(loaded_ptr loaded, const opt::variables_map &vars, const context &ctx) {
+        using clock_t = std::chrono::steady_clock;
+
+        // Saves usually come as a few events in a row, they're handled together
+        constexpr std::chrono::milliseconds Settle{ 5 };
+
+        if (ctx.remote) {
+            ctx.output("'--watch' runs until interrupted, it isn't available through the daemon\n");
+            return 1;
+        }
+
+        // Variables view the template and the plan views the program, both stay right here
+        auto template_v = loaded->template_v;
+        template_v.setWorkingDirectory(ctx.cwd, ctx.environment);
+
+        if (template_v.isPacked()) {
+            ctx.output(fmt::format("'{}' is packed, there's no template folder to watch\n", template_v.getName()));
+            return 1;
+        }
+
+        auto program = loaded->program;
+        loaded.reset();
+
+        arti::generator gen{ template_v };
+
+        auto runOptions = loadRunOptions(vars, ctx);
+        runOptions.update = true;
+        runOptions.manifestDirectory = template_cache::directory().value_or(fs::path{});
+
+        // The names the variables were resolved for, they only need resolving again when these change
+        std::vector<std::string> references;
+        // Failing to resolve leaves them half done, nothing is generated until they resolve again
+        bool resolved = false;
+        // A vars.toml saved half edited doesn't parse, it's only read again once saved again
+        bool varsFileValid = true;
+
+        const auto loadVars = [&] {
+            resolved = false;
+
+            if (auto ex = gen.loadVars(vars, {}, &program); ! ex) {
+                ctx.output(fmt::format("{}\n", ex.error()));
+                return false;
+            }
+
+            const auto current = program.references();
+            references.assign(current.begin(), current.end());
+            resolved = true;
+
+            return true;
+        };
+
+        const auto generate = [&](clock_t::time_point start) {
+            arti::generator::run_report report;
+
+            const auto ex = gen.run(program, runOptions, report);
+
+            for (const auto &message : report.messages) {
+                ctx.output(fmt::format("{}\n", message));
+            }
+
+            if (! ex) {
+                ctx.output(fmt::format("{}\n", ex.error()));
+                return;
+            }
+
+            const auto elapsed = std::chrono::duration<double, std::milli>(clock_t::now() - start).count();
+
+            ctx.output(fmt::format("Generated in {:.1f} ms\n", elapsed));
+        };
+
+        if (! loadVars()) {
+            return 1;
+        }
+
+        generate(clock_t::now());
+
+        const auto &location = template_v.getRootPath();
+        auto watcherEx = utils::directory_watcher::open(location);
+
+        if (! watcherEx) {
+            ctx.output(fmt::format("Couldn't watch '{}': {}\n", location.string(), watcherEx.error().info));
+            return 1;
+        }
+
+        auto watcher = std::move(watcherEx).value();
+        const auto varsPath = location / "vars.toml";
+
+        ctx.output(fmt::format("Watching '{}' for changes, Ctrl+C stops\n", location.string()));
+
+        while (true) {
+            // Whatever the last round printed shows before blocking, even through a pipe
+            std::fflush(stdout);
+
+            auto changesEx = watcher.wait(Settle);
+
+            if (! changesEx) {
+                ctx.output(fmt::format("Stopped watching: {}\n", changesEx.error().info));
+                return 1;
+            }
+
+            const auto start = clock_t::now();
+
+            bool varsChanged = false;
+            // Files added, removed or renamed change the tree, the whole template compiles again
+            bool structural = false;
+            std::vector<fs::path> edited;
+
+            for (const auto &change : changesEx.value()) {
+                std::error_code ec;
+                const bool exists = fs::exists(change.path, ec);
+
+                if (change.path == varsPath) {
+                    varsChanged = true;
+                }
+                else if (change.directory) {
+                    structural = true;
+                }
+                else if (std::any_of(program.entries().begin(), program.entries().end(), [&](const auto &current) { return current.templatePath == change.path; })) {
+                    // Saving through a rename removes and creates the same path, it's still there
+                    if (exists) {
+                        edited.push_back(change.path);
+                    }
+                    else {
+                        structural = true;
+                    }
+                }
+                else if (change.created && exists) {
+                    structural = true;
+                }
+            }
+
+            if (! varsChanged && ! structural && edited.empty()) {
+                continue;
+            }
+
+            for (const auto &path : edited) {
+                structural = structural || ! program.reload(path);
+            }
+
+            if (structural) {
+                auto programEx = template_program::compile(template_v);
+
+                if (! programEx) {
+                    ctx.output(fmt::format("{}\n", programEx.error()));
+                    continue;
+                }
+
+                program = std::move(programEx).value();
+            }
+
+            if (varsChanged) {
+                auto varsEx = template_v.loadDefaultVars();
+                template_v.setWorkingDirectory(ctx.cwd, ctx.environment);
+
+                varsFileValid = varsEx.has_value();
+
+                if (! varsEx) {
+                    ctx.output(fmt::format("{}\nWaiting for it to be fixed\n", varsEx.error().info));
+                }
+            }
+
+            if (! varsFileValid) {
+                continue;
+            }
+
+            const auto current = program.references();
+
+            if (varsChanged || ! resolved || ! std::equal(current.begin(), current.end(), references.begin(), references.end())) {
+                if (! loadVars()) {
+                    continue;
+                }
+            }
+
+            generate(start);
+        }
+    }
+
+    fs::path command::socketPath(const opt::variables_map &vars) {
+        if (vars.contains("socket")) {
+            return vars.at("socket").as<std::string>();
+        }
+
+        if (const char *runtimeDir = std::getenv("XDG_RUNTIME_DIR"); runtimeDir && *runtimeDir) {
+            return fs::path{ runtimeDir } / "arti-gen.sock";
+        }
+
+        return fs::temp_directory_path() / fmt::format("arti-gen-{}.sock", ::getuid());
+    }
+
+    void command::printVersion(const context &ctx) {
+        using namespace arti;
+
+        ctx.output(fmt::format(
+            "{} version {}\n\n"
+            "       Author:  {}\n"
+            "Author Github: {}\n",
+            config::project_name,
+            config::project_version,
+            config::project_author,
+            config::project_author_github
+        ));
+    }
+
+    tl::expected<command::loaded_ptr, std::string> command::loadTemplate(const opt::variables_map &vars, const context &ctx) {
+        using expected_t = tl::expected<loaded_ptr, std::string>;
+        using error_t = expected_t::unexpected_type;
+        using cache_modes = arti::template_cache::modes;
+
+        if (! vars.contains("template")) {
+            return error_t{ "Template parameter is required" };
+        }
+
+        auto templateParam = vars.at("template").as<std::string>();
+
+        const auto cacheMode = [&] {
+            if (vars.contains("no-cache")) {
+                return cache_modes::Disabled;
+            }
+            else if (vars.contains("rebuild-cache")) {
+                return cache_modes::Rebuild;
+            }
+
+            return cache_modes::Enabled;
+        }();
+
+        return ctx.loader(templateParam, cacheMode);
+    }
+
+    generator::run_options command::loadRunOptions(const opt::variables_map &vars, const context &ctx) {
+        arti::generator::run_options runOptions;
+
+        if (vars.contains("jobs")) {
+            runOptions.jobs = vars.at("jobs").as<std::size_t>();
+
+            if (runOptions.jobs == 0) {
+                runOptions.jobs = arti::utils::thread_pool::defaultConcurrency();
+            }
+        }
+
+        if (vars.contains("io")) {
+            // Already validated by the options parser
+            runOptions.io = utils::io_backend::parse(vars.at("io").as<std::string>()).value_or(utils::io_backend::kinds::Auto);
+        }
+
+        runOptions.update = vars.contains("update");
+
+        // Updates always refresh the manifest, they already stat every file
+        if (runOptions.update || vars.contains("manifest")) {
+            runOptions.manifestDirectory = template_cache::directory().value_or(fs::path{});
+        }
+
+        runOptions.outputRoot = ctx.cwd;
+
+        return runOptions;
+    }
+
+    bool command::isBatch(const opt::variables_map &vars) {
+        return vars.contains("batch") || (vars.contains("name") && vars.at("name").as<std::vector<std::string>>().size() > 1);
+    }
+
+    int command::runBatch(loaded_ptr loaded, const opt::variables_map &vars, const context &ctx) {
+        arti::batch::instances_t instances;
+
+        if (vars.contains("batch")) {
+            auto manifestEx = arti::batch::loadManifest(ctx.cwd / vars.at("batch").as<std::string>());
+
+            if (! manifestEx) {
+                auto [errorCode, errorInfo] = std::move(manifestEx).error();
+
+                ctx.output(fmt::format("{}\n", errorInfo));
+                return 1;
+            }
+
+            instances = std::move(manifestEx).value();
+        }
+        else {
+            instances = arti::batch::fromNames(vars.at("name").as<std::vector<std::string>>());
+        }
+
+        auto template_v = loaded->template_v;
+        template_v.setWorkingDirectory(ctx.cwd, ctx.environment);
+
+        // The program is shared with the loader, a warm daemon keeps serving it
+        std::shared_ptr<const template_program> program{ loaded, &loaded->program };
+
+        arti::batch batch_v{ std::move(template_v), std::move(program), std::move(instances) };
+
+        const utils::trace::span phase{ utils::trace::span::kinds::Phase, "batch" };
+
+        if (auto ex = batch_v.run(vars, loadRunOptions(vars, ctx), ctx.output); ! ex) {
+            ctx.output(fmt::format("{}\n", ex.error()));
+            return 1;
+        }
+
+        return 0;
+    }
+
+}
@@ -0,0 +1,843 @@
+#include "compiled_template.hpp"
+
+#include <limits>
+#include <charconv>
+#include <optional>
+#include <algorithm>
+#include <unordered_map>
+
+#include "utils/scan.hpp"
+
+namespace arti {
+
+    namespace {
+        constexpr auto npos = std::string_view::npos;
+
+        bool isAlpha(char c) {
+            return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+        }
+
+        bool isIdent(char c) {
+            return isAlpha(c) || (c >= '0' && c <= '9') || c == '_';
+        }
+
+        bool isBlank(char c) {
+            return c == ' ' || c == '\t';
+        }
+
+        // Empty, 'false' and '0' are false, anything else is true
+        bool truthy(std::string_view value) {
+            return ! value.empty() && value != "false" && value != "0";
+        }
+
+        // Pops the next comma separated item off 'rest', spaces around it trimmed and empty ones skipped
+        std::optional<std::string_view> nextItem(std::string_view &rest) {
+            constexpr std::string_view Spaces = " \t\r\n";
+
+            while (! rest.empty()) {
+                const auto comma = rest.find(',');
+                auto item = rest.substr(0, comma);
+
+                rest = comma == npos ? std::string_view{} : rest.substr(comma + 1);
+
+                const auto begin = item.find_first_not_of(Spaces);
+
+                if (begin != npos) {
+                    return item.substr(begin, item.find_last_not_of(Spaces) - begin + 1);
+                }
+            }
+
+            return std::nullopt;
+        }
+
+        // Start of the '}}' or '%}' closing a tag body from 'cur', outside of quoted text and on the same line
+        std::size_t findClosing(std::string_view src, std::size_t cur, char closing) {
+            char quote = 0;
+
+            while (cur < src.size() && src[cur] != '\n') {
+                if (quote == 0 && src[cur] == closing && cur + 1 < src.size() && src[cur + 1] == '}') {
+                    return cur;
+                }
+
+                if (quote == 0 && (src[cur] == '"' || src[cur] == '\'')) {
+                    quote = src[cur];
+                }
+                else if (quote == '"' && src[cur] == '\\') {
+                    ++cur;
+                }
+                else if (src[cur] == quote) {
+                    quote = 0;
+                }
+
+                ++cur;
+            }
+
+            return npos;
+        }
+
+        // The words of a '{% ... %}' tag: identifiers, '==', '!=' and quoted text without escapes
+        class tag_reader {
+          public:
+            tag_reader(std::string_view src, std::size_t begin, std::size_t end)
+                : m_Src{ src }, m_Pos{ begin }, m_End{ end } {}
+
+            bool done() {
+                skipBlanks();
+                return m_Pos >= m_End;
+            }
+
+            std::string_view identifier() {
+                skipBlanks();
+
+                const auto begin = m_Pos;
+
+                if (m_Pos < m_End && isAlpha(m_Src[m_Pos])) {
+                    while (m_Pos < m_End && isIdent(m_Src[m_Pos])) {
+                        ++m_Pos;
+                    }
+                }
+
+                return m_Src.substr(begin, m_Pos - begin);
+            }
+
+            bool consume(std::string_view token) {
+                skipBlanks();
+
+                if (m_End - m_Pos >= token.size() && m_Src.substr(m_Pos, token.size()) == token) {
+                    m_Pos += token.size();
+                    return true;
+                }
+
+                return false;
+            }
+
+            // Source offset and length of the quoted text
+            std::optional<std::pair<std::size_t, std::size_t>> quoted() {
+                skipBlanks();
+
+                if (m_Pos >= m_End || (m_Src[m_Pos] != '"' && m_Src[m_Pos] != '\'')) {
+                    return std::nullopt;
+                }
+
+                const auto close = m_Src.find(m_Src[m_Pos], m_Pos + 1);
+
+                if (close == npos || close >= m_End || m_Src.substr(m_Pos, close - m_Pos).find('\\') != npos) {
+                    return std::nullopt;
+                }
+
+                const std::pair<std::size_t, std::size_t> ret{ m_Pos + 1, close - m_Pos - 1 };
+                m_Pos = close + 1;
+
+                return ret;
+            }
+
+          private:
+            void skipBlanks() {
+                while (m_Pos < m_End && isBlank(m_Src[m_Pos])) {
+                    ++m_Pos;
+                }
+            }
+
+            std::string_view m_Src;
+            std::size_t m_Pos;
+            std::size_t m_End;
+        };
+    }
+
+    compiled_template compiled_template::compile(std::string source) {
+        compiled_template ret;
+        ret.m_Storage = std::move(source);
+
+        if (! ret.parse(true)) {
+            ret.reset();
+            ret.parse(false);
+        }
+
+        return ret;
+    }
+
+    compiled_template compiled_template::compileView(std::string_view source) {
+        compiled_template ret;
+        ret.m_View = source;
+        ret.m_Owning = false;
+
+        if (! ret.parse(true)) {
+            ret.reset();
+            ret.parse(false);
+        }
+
+        return ret;
+    }
+
+    std::optional<compiled_template> compiled_template::fromSegments(std::string_view source, std::vector<segment> segments, std::vector<std::string> slots) {
+        compiled_template ret;
+        ret.m_View = source;
+        ret.m_Owning = false;
+        ret.m_Segments = std::move(segments);
+        ret.m_Slots = std::move(slots);
+        ret.m_Chains.reserve(ret.m_Slots.size());
+        ret.m_Depths.reserve(ret.m_Slots.size());
+
+        // A loop bound slot is spelled '<chain>\n<loop depth>'
+        for (const auto &slot : ret.m_Slots) {
+            const auto separator = slot.find('\n');
+            const auto chain = std::string_view{ slot }.substr(0, separator);
+
+            ret.m_Chains.push_back(filter_chain::parse(chain).value_or(filter_chain{}));
+
+            if (separator == std::string::npos) {
+                ret.m_Depths.push_back(0);
+                continue;
+            }
+
+            uint32_t depth = 0;
+            const auto *end = slot.data() + slot.size();
+            const auto [ptr, ec] = std::from_chars(slot.data() + separator + 1, end, depth);
+
+            if (ec != std::errc{} || ptr != end || depth == std::numeric_limits<uint32_t>::max()) {
+                return std::nullopt;
+            }
+
+            ret.m_Depths.push_back(depth + 1);
+        }
+
+        if (! ret.verify()) {
+            return std::nullopt;
+        }
+
+        for (const auto &seg : ret.m_Segments) {
+            if (seg.kind == segment::kinds::Literal) {
+                ret.m_LiteralSize += seg.length;
+            }
+            else if (seg.kind != segment::kinds::Variable) {
+                ret.m_Flow = true;
+            }
+        }
+
+        return ret;
+    }
+
+    bool compiled_template::verify() const {
+        using kinds = segment::kinds;
+
+        const auto src = source();
+        const auto count = m_Segments.size();
+
+        // The ForNext of the innermost loop running each segment, npos outside of any
+        std::vector<std::size_t> owners(count + 1, npos);
+        std::vector<std::size_t> loops;
+
+        const auto inSource = [&](const segment &seg) {
+            return seg.offset <= src.size() && seg.length <= src.size() - seg.offset;
+        };
+
+        // The frames a slot reads from are all pushed already
+        const auto inScope = [&](const segment &seg) {
+            return seg.offset < m_Slots.size() && m_Depths[seg.offset] <= loops.size();
+        };
+
+        for (std::size_t i = 0; i < count; ++i) {
+            const auto &seg = m_Segments[i];
+            owners[i] = loops.empty() ? npos : loops.back();
+
+            switch (seg.kind) {
+                case kinds::Literal:
+                case kinds::Equals:
+                case kinds::NotEquals:
+                    if (! inSource(seg)) {
+                        return false;
+                    }
+                    break;
+                case kinds::Variable:
+                case kinds::Test:
+                    if (! inScope(seg) || (seg.kind == kinds::Test && seg.length > 1)) {
+                        return false;
+                    }
+                    break;
+                case kinds::ForBegin:
+                    // Always right before its ForNext, which runs inside the loop
+                    if (! inScope(seg) || i + 1 >= count || m_Segments[i + 1].kind != kinds::ForNext) {
+                        return false;
+                    }
+
+                    loops.push_back(i + 1);
+                    break;
+                case kinds::ForNext:
+                    if (loops.empty() || loops.back() != i || seg.length <= i || seg.length > count) {
+                        return false;
+                    }
+                    break;
+                case kinds::JumpUnless:
+                case kinds::Jump:
+                    if (seg.length > count) {
+                        return false;
+                    }
+
+                    // The only jump back closes the innermost loop, right before where its ForNext leaves
+                    if (seg.length <= i) {
+                        if (seg.kind != kinds::Jump || loops.empty() || seg.length != loops.back() || m_Segments[loops.back()].length != i + 1) {
+                            return false;
+                        }
+
+                        loops.pop_back();
+                    }
+                    break;
+                default:
+                    return false;
+            }
+        }
+
+        if (! loops.empty()) {
+            return false;
+        }
+
+        // Jumps forward stay within the loop they're in, they never land in another one's body
+        for (std::size_t i = 0; i < count; ++i) {
+            const auto &seg = m_Segments[i];
+
+            if ((seg.kind == kinds::Jump || seg.kind == kinds::JumpUnless) && seg.length > i && owners[seg.length] != owners[i]) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    std::string_view compiled_template::source() const {
+        if (m_Owning) {
+            return m_Storage;
+        }
+
+        return m_View;
+    }
+
+    void compiled_template::reset() {
+        m_Segments.clear();
+        m_Slots.clear();
+        m_Chains.clear();
+        m_Depths.clear();
+        m_LiteralSize = 0;
+        m_Flow = false;
+    }
+
+    std::optional<compiled_template::placeholder> compiled_template::matchPlaceholder(std::string_view src, std::size_t pos) {
+        auto cur = pos + 2;
+
+        while (cur < src.size() && src[cur] == ' ') {
+            ++cur;
+        }
+
+        const auto nameBegin = cur;
+
+        if (cur < src.size() && isAlpha(src[cur])) {
+            while (cur < src.size() && isIdent(src[cur])) {
+                ++cur;
+            }
+        }
+
+        const auto nameEnd = cur;
+
+        while (cur < src.size() && src[cur] == ' ') {
+            ++cur;
+        }
+
+        // Filters run up to the closing '}}' outside of their quoted arguments, on the same line
+        if (nameBegin != nameEnd && cur < src.size() && src[cur] == '|') {
+            cur = findClosing(src, cur, '}');
+        }
+
+        if (nameBegin == nameEnd || cur == npos || src.compare(cur, 2, "}}") != 0) {
+            return std::nullopt;
+        }
+
+        auto chain = filter_chain::parse(src.substr(nameBegin, cur - nameBegin));
+
+        // An unknown filter or bad arguments leave the text as it is, like any other non placeholder
+        if (! chain) {
+            return std::nullopt;
+        }
+
+        return placeholder{ std::move(*chain), cur + 2 };
+    }
+
+    bool compiled_template::parse(bool tags) {
+        using kinds = segment::kinds;
+
+        struct block {
+            bool loop;
+            // Loop: the variable bound to each item
+            std::string_view variable;
+            // If: the JumpUnless waiting for the next clause, npos after an 'else'. Loop: its ForNext
+            std::size_t pending;
+            // If: the Jumps to its end closing every clause
+            std::vector<std::size_t> exits;
+        };
+
+        const std::string_view src = source();
+
+        const auto pushLiteral = [&](std::size_t begin, std::size_t end) {
+            if (end > begin) {
+                m_Segments.push_back({ kinds::Literal, begin, end - begin });
+                m_LiteralSize += end - begin;
+            }
+        };
+
+        const auto emit = [&](kinds kind, uint64_t offset = 0, uint64_t length = 0) {
+            m_Segments.push_back({ kind, offset, length });
+            return m_Segments.size() - 1;
+        };
+
+        std::unordered_map<std::string, uint64_t> slotIndex;
+        std::vector<block> blocks;
+
+        // A variable named by an enclosing loop gets a slot of its own, bound to that loop's item
+        const auto slotOf = [&](filter_chain chain) {
+            uint32_t depth = 0;
+            auto key = chain.key();
+
+            for (auto it = blocks.rbegin(); it != blocks.rend(); ++it) {
+                if (it->loop && it->variable == chain.variable()) {
+                    depth = static_cast<uint32_t>(std::count_if(blocks.begin(), it.base(), [](const block &current) {
+                        return current.loop;
+                    }));
+
+                    key += '\n';
+                    key += std::to_string(depth - 1);
+                    break;
+                }
+            }
+
+            auto [it, inserted] = slotIndex.try_emplace(key, m_Slots.size());
+
+            if (inserted) {
+                m_Slots.push_back(std::move(key));
+                m_Chains.push_back(std::move(chain));
+                m_Depths.push_back(depth);
+            }
+
+            return it->second;
+        };
+
+        // '[not] variable' or 'variable (==|!=) "text"', nothing is emitted unless it's valid
+        const auto condition = [&](tag_reader &reader) {
+            const bool negated = reader.consume("not ");
+            const auto name = reader.identifier();
+
+            if (name.empty()) {
+                return false;
+            }
+
+            auto kind = kinds::Test;
+            std::optional<std::pair<std::size_t, std::size_t>> text;
+
+            if (! reader.done()) {
+                kind = reader.consume("==") ? kinds::Equals : reader.consume("!=") ? kinds::NotEquals : kinds::Test;
+                text = reader.quoted();
+
+                if (negated || kind == kinds::Test || ! text || ! reader.done()) {
+                    return false;
+                }
+            }
+
+            emit(kinds::Test, slotOf(*filter_chain::parse(name)), negated ? 1 : 0);
+
+            if (text) {
+                emit(kind, text->first, text->second);
+            }
+
+            return true;
+        };
+
+        // False when it isn't a valid tag, nothing is emitted and it's left as text then.
+        // A valid one closing the wrong block, or none, unbalances the template.
+        const auto tag = [&](tag_reader reader, bool &balanced) {
+            const auto emitted = m_Segments.size();
+            const auto keyword = reader.identifier();
+
+            if (keyword == "if") {
+                if (! condition(reader)) {
+                    return false;
+                }
+
+                blocks.push_back({ false, {}, emit(kinds::JumpUnless), {} });
+                return true;
+            }
+
+            if (keyword == "for") {
+                const auto variable = reader.identifier();
+
+                if (variable.empty() || ! reader.consume("in ")) {
+                    return false;
+                }
+
+                const auto list = reader.identifier();
+
+                if (list.empty() || ! reader.done()) {
+                    return false;
+                }
+
+                emit(kinds::ForBegin, slotOf(*filter_chain::parse(list)));
+                blocks.push_back({ true, variable, emit(kinds::ForNext), {} });
+                return true;
+            }
+
+            if (keyword == "elif") {
+                // Checked ahead, the clause before is closed first
+                auto ahead = reader;
+
+                if (! condition(ahead)) {
+                    return false;
+                }
+
+                m_Segments.resize(emitted);
+            }
+            else if ((keyword != "else" && keyword != "endif" && keyword != "endfor") || ! reader.done()) {
+                return false;
+            }
+
+            const bool closesLoop = keyword == "endfor";
+            const bool closesIf = keyword == "endif";
+
+            if (blocks.empty() || blocks.back().loop != closesLoop || (! closesIf && ! closesLoop && blocks.back().pending == npos)) {
+                balanced = false;
+                return true;
+            }
+
+            auto &current = blocks.back();
+
+            if (closesLoop) {
+                emit(kinds::Jump, 0, current.pending);
+                m_Segments[current.pending].length = m_Segments.size();
+                blocks.pop_back();
+                return true;
+            }
+
+            if (closesIf) {
+                if (current.pending != npos) {
+                    m_Segments[current.pending].length = m_Segments.size();
+                }
+
+                for (const auto exit : current.exits) {
+                    m_Segments[exit].length = m_Segments.size();
+                }
+
+                blocks.pop_back();
+                return true;
+            }
+
+            current.exits.push_back(emit(kinds::Jump));
+            m_Segments[current.pending].length = m_Segments.size();
+            current.pending = npos;
+
+            if (keyword == "elif") {
+                condition(reader);
+                current.pending = emit(kinds::JumpUnless);
+            }
+
+            return true;
+        };
+
+        bool balanced = true;
+        std::size_t literalBegin = 0;
+        std::size_t pos = 0;
+
+        while ((pos = utils::scanner::findOpening(src, pos)) != npos) {
+            // '\{{' and '\{%' are emitted as a literal '{{' and '{%'
+            if (pos > literalBegin && src[pos - 1] == '\\') {
+                pushLiteral(literalBegin, pos - 1);
+                literalBegin = pos;
+                pos += 2;
+                continue;
+            }
+
+            if (src[pos + 1] == '%') {
+                const auto close = tags ? findClosing(src, pos + 2, '%') : npos;
+
+                if (close == npos) {
+                    ++pos;
+                    continue;
+                }
+
+                // A tag alone on its line takes the whole line with it
+                auto lineBegin = pos;
+                auto lineEnd = close + 2;
+
+                while (lineBegin > literalBegin && isBlank(src[lineBegin - 1])) {
+                    --lineBegin;
+                }
+
+                while (lineEnd < src.size() && isBlank(src[lineEnd])) {
+                    ++lineEnd;
+                }
+
+                const bool ownLine = (lineBegin == 0 || src[lineBegin - 1] == '\n')
+                    && (lineEnd == src.size() || src[lineEnd] == '\n' || src.compare(lineEnd, 2, "\r\n") == 0);
+
+                if (! ownLine) {
+                    lineBegin = pos;
+                    lineEnd = close + 2;
+                }
+                else if (lineEnd < src.size()) {
+                    lineEnd += src[lineEnd] == '\r' ? 2 : 1;
+                }
+
+                pushLiteral(literalBegin, lineBegin);
+                literalBegin = lineBegin;
+
+                if (! tag(tag_reader{ src, pos + 2, close }, balanced)) {
+                    ++pos;
+                    continue;
+                }
+
+                if (! balanced) {
+                    return false;
+                }
+
+                m_Flow = true;
+
+                pos = lineEnd;
+                literalBegin = pos;
+                continue;
+            }
+
+            auto match = matchPlaceholder(src, pos);
+
+            if (! match) {
+                ++pos;
+                continue;
+            }
+
+            pushLiteral(literalBegin, pos);
+            m_Segments.push_back({ kinds::Variable, slotOf(std::move(match->chain)), 0 });
+
+            pos = match->end;
+            literalBegin = pos;
+        }
+
+        pushLiteral(literalBegin, src.size());
+
+        return blocks.empty();
+    }
+
+    const std::vector<std::string> &compiled_template::slots() const {
+        return m_Slots;
+    }
+
+    const std::vector<filter_chain> &compiled_template::chains() const {
+        return m_Chains;
+    }
+
+    const std::vector<compiled_template::segment> &compiled_template::segments() const {
+        return m_Segments;
+    }
+
+    bool compiled_template::hasVariables() const {
+        return ! m_Slots.empty();
+    }
+
+    bool compiled_template::hasControlFlow() const {
+        return m_Flow;
+    }
+
+    bool compiled_template::loopBound(std::size_t slot) const {
+        return m_Depths[slot] != 0;
+    }
+
+    std::size_t compiled_template::placeholderCount() const {
+        return std::count_if(m_Segments.begin(), m_Segments.end(), [](const segment &current) {
+            return current.kind == segment::kinds::Variable;
+        });
+    }
+
+    std::vector<std::string_view> compiled_template::undefinedVariables(const variable_store &vars) const {
+        std::vector<std::string_view> undefined;
+
+        for (std::size_t i = 0; i < m_Chains.size(); ++i) {
+            const auto &chain = m_Chains[i];
+            const auto name = chain.variable();
+
+            if (loopBound(i) || chain.hasDefault() || vars.contains(name)) {
+                continue;
+            }
+
+            if (std::find(undefined.begin(), undefined.end(), name) == undefined.end()) {
+                undefined.push_back(name);
+            }
+        }
+
+        return undefined;
+    }
+
+    std::vector<std::string_view> compiled_template::bind(const variable_store &vars) const {
+        std::vector<std::string_view> values;
+        values.reserve(m_Chains.size());
+
+        for (std::size_t i = 0; i < m_Chains.size(); ++i) {
+            values.push_back(loopBound(i) ? std::string_view{} : vars.get(m_Chains[i].variable()).value_or(std::string_view{}));
+        }
+
+        return values;
+    }
+
+    template <typename literal_fn, typename variable_fn>
+    void compiled_template::execute(const std::vector<std::string_view> &values, literal_fn &&literal, variable_fn &&variable) const {
+        struct frame {
+            std::string_view rest;
+            std::string_view item;
+        };
+
+        // Loops nest lexically, the frame of depth 'n' is always 'frames[n]'
+        std::vector<frame> frames;
+
+        const auto src = source();
+        std::string_view tested;
+        bool passed = false;
+
+        const auto valueOf = [&](uint64_t slot) {
+            const auto depth = m_Depths[slot];
+            return depth == 0 ? values[slot] : frames[depth - 1].item;
+        };
+
+        // Every segment runs once per output it produces, rendering stays linear in the output
+        for (std::size_t next = 0; next < m_Segments.size();) {
+            const auto &seg = m_Segments[next++];
+
+            switch (seg.kind) {
+                case decltype(seg.kind)::Literal:
+                    literal(src.substr(seg.offset, seg.length));
+                    break;
+                case decltype(seg.kind)::Variable:
+                    variable(seg.offset, valueOf(seg.offset));
+                    break;
+                case decltype(seg.kind)::Test:
+                    tested = valueOf(seg.offset);
+                    passed = truthy(tested) != (seg.length != 0);
+                    break;
+                case decltype(seg.kind)::Equals:
+                    passed = tested == src.substr(seg.offset, seg.length);
+                    break;
+                case decltype(seg.kind)::NotEquals:
+                    passed = tested != src.substr(seg.offset, seg.length);
+                    break;
+                case decltype(seg.kind)::JumpUnless:
+                    if (! passed) {
+                        next = seg.length;
+                    }
+                    break;
+                case decltype(seg.kind)::Jump:
+                    next = seg.length;
+                    break;
+                case decltype(seg.kind)::ForBegin:
+                    frames.push_back({ valueOf(seg.offset), {} });
+                    break;
+                case decltype(seg.kind)::ForNext:
+                    if (const auto item = nextItem(frames.back().rest)) {
+                        frames.back().item = *item;
+                    }
+                    else {
+                        frames.pop_back();
+                        next = seg.length;
+                    }
+                    break;
+            }
+        }
+    }
+
+    void compiled_template::renderTo(std::string &out, const std::vector<std::string_view> &values) const {
+        if (m_Flow) {
+            out.reserve(out.size() + m_LiteralSize);
+
+            execute(values, [&](std::string_view text) {
+                out.append(text);
+            }, [&](uint64_t slot, std::string_view value) {
+                m_Chains[slot].apply(value, out);
+            });
+
+            return;
+        }
+
+        std::size_t size = m_LiteralSize;
+
+        for (const auto &seg : m_Segments) {
+            if (seg.kind == segment::kinds::Variable) {
+                size += values[seg.offset].size();
+            }
+        }
+
+        out.reserve(out.size() + size);
+
+        const auto src = source();
+
+        for (const auto &seg : m_Segments) {
+            if (seg.kind == segment::kinds::Literal) {
+                out.append(src.data() + seg.offset, seg.length);
+            }
+            else {
+                m_Chains[seg.offset].apply(values[seg.offset], out);
+            }
+        }
+    }
+
+    void compiled_template::renderTo(std::vector<std::string_view> &chunks, const std::vector<std::string_view> &values, variable_store &filtered) const {
+        chunks.reserve(chunks.size() + m_Segments.size());
+
+        const auto src = source();
+
+        thread_local std::string scratch;
+        thread_local std::string key;
+
+        // A loop item changes between iterations, its filtered values are keyed by the item too
+        const auto variable = [&](uint64_t slot, std::string_view value) {
+            const auto &chain = m_Chains[slot];
+
+            if (chain.filtered()) {
+                key = chain.key();
+
+                if (loopBound(slot)) {
+                    key += '\n';
+                    key += value;
+                }
+
+                const auto id = filtered.intern(key);
+
+                if (! filtered.defined(id)) {
+                    scratch.clear();
+                    chain.apply(value, scratch);
+                    filtered.set(id, scratch);
+                }
+
+                value = filtered.value(id);
+            }
+
+            if (! value.empty()) {
+                chunks.push_back(value);
+            }
+        };
+
+        if (m_Flow) {
+            execute(values, [&](std::string_view text) {
+                chunks.push_back(text);
+            }, variable);
+
+            return;
+        }
+
+        for (const auto &seg : m_Segments) {
+            if (seg.kind == segment::kinds::Literal) {
+                chunks.emplace_back(src.data() + seg.offset, seg.length);
+            }
+            else {
+                variable(seg.offset, values[seg.offset]);
+            }
+        }
+    }
+
+    std::string compiled_template::render(const variable_store &vars) const {
+        std::string out;
+
+        renderTo(out, bind(vars));
+
+        return out;
+    }
+
+}
@@ -0,0 +1,390 @@
+#include "filter_chain.hpp"
+
+#include <array>
+#include <algorithm>
+
+namespace arti {
+
+    namespace {
+        using kinds = filter_chain::kinds;
+
+        struct filter_def {
+            std::string_view name;
+            kinds kind;
+            std::size_t arguments;
+        };
+
+        constexpr std::array<filter_def, 9> Filters{ {
+            { "upper", kinds::Upper, 0 },
+            { "lower", kinds::Lower, 0 },
+            { "snake", kinds::Snake, 0 },
+            { "camel", kinds::Camel, 0 },
+            { "pascal", kinds::Pascal, 0 },
+            { "kebab", kinds::Kebab, 0 },
+            { "trim", kinds::Trim, 0 },
+            { "replace", kinds::Replace, 2 },
+            { "default", kinds::Default, 1 }
+        } };
+
+        bool isAlpha(char c) {
+            return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+        }
+
+        bool isDigit(char c) {
+            return c >= '0' && c <= '9';
+        }
+
+        bool isUpper(char c) {
+            return c >= 'A' && c <= 'Z';
+        }
+
+        bool isLower(char c) {
+            return c >= 'a' && c <= 'z';
+        }
+
+        bool isSpace(char c) {
+            return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+        }
+
+        char toUpper(char c) {
+            return isLower(c) ? static_cast<char>(c - 'a' + 'A') : c;
+        }
+
+        char toLower(char c) {
+            return isUpper(c) ? static_cast<char>(c - 'A' + 'a') : c;
+        }
+
+        class expression_reader {
+          public:
+            explicit expression_reader(std::string_view text)
+                : m_Text{ text } {}
+
+            void skipSpaces() {
+                while (m_Pos < m_Text.size() && m_Text[m_Pos] == ' ') {
+                    ++m_Pos;
+                }
+            }
+
+            bool done() const {
+                return m_Pos >= m_Text.size();
+            }
+
+            bool consume(char c) {
+                skipSpaces();
+
+                if (! done() && m_Text[m_Pos] == c) {
+                    ++m_Pos;
+                    return true;
+                }
+
+                return false;
+            }
+
+            std::string_view identifier() {
+                skipSpaces();
+
+                const auto begin = m_Pos;
+
+                if (! done() && isAlpha(m_Text[m_Pos])) {
+                    while (! done() && (isAlpha(m_Text[m_Pos]) || isDigit(m_Text[m_Pos]) || m_Text[m_Pos] == '_')) {
+                        ++m_Pos;
+                    }
+                }
+
+                return m_Text.substr(begin, m_Pos - begin);
+            }
+
+            // "double quoted" with '\"' and '\\' escapes, or 'single quoted' taken as is
+            std::optional<std::string> quoted() {
+                skipSpaces();
+
+                if (done() || (m_Text[m_Pos] != '"' && m_Text[m_Pos] != '\'')) {
+                    return std::nullopt;
+                }
+
+                const char quote = m_Text[m_Pos++];
+                std::string value;
+
+                while (! done() && m_Text[m_Pos] != quote) {
+                    if (quote == '"' && m_Text[m_Pos] == '\\' && m_Pos + 1 < m_Text.size()) {
+                        ++m_Pos;
+                    }
+
+                    value.push_back(m_Text[m_Pos++]);
+                }
+
+                if (done()) {
+                    return std::nullopt;
+                }
+
+                ++m_Pos;
+                return value;
+            }
+
+          private:
+            std::string_view m_Text;
+            std::size_t m_Pos = 0;
+        };
+
+        // Splits on anything but letters and digits, before an uppercase letter following a
+        // lowercase one or a digit, and before the last letter of an acronym: 'HTTPServer2Go'
+        // gives 'HTTP', 'Server2', 'Go'
+        template <typename fn_t>
+        void forEachWord(std::string_view value, fn_t &&fn) {
+            std::size_t begin = 0;
+            std::size_t index = 0;
+
+            const auto flush = [&](std::size_t end) {
+                if (end > begin) {
+                    fn(value.substr(begin, end - begin), index++);
+                }
+            };
+
+            for (std::size_t i = 0; i < value.size(); ++i) {
+                const char c = value[i];
+
+                if (! isAlpha(c) && ! isDigit(c)) {
+                    flush(i);
+                    begin = i + 1;
+                    continue;
+                }
+
+                if (i > begin && isUpper(c)) {
+                    const char prev = value[i - 1];
+                    const bool acronymEnd = isUpper(prev) && i + 1 < value.size() && isLower(value[i + 1]);
+
+                    if (isLower(prev) || isDigit(prev) || acronymEnd) {
+                        flush(i);
+                        begin = i;
+                    }
+                }
+            }
+
+            flush(value.size());
+        }
+
+        void joinWords(std::string_view value, char separator, std::string &out) {
+            forEachWord(value, [&](std::string_view word, std::size_t index) {
+                if (index > 0) {
+                    out.push_back(separator);
+                }
+
+                for (const char c : word) {
+                    out.push_back(toLower(c));
+                }
+            });
+        }
+
+        void capitalizeWords(std::string_view value, bool lowerFirst, std::string &out) {
+            forEachWord(value, [&](std::string_view word, std::size_t index) {
+                out.push_back(lowerFirst && index == 0 ? toLower(word.front()) : toUpper(word.front()));
+
+                for (const char c : word.substr(1)) {
+                    out.push_back(toLower(c));
+                }
+            });
+        }
+
+        void applyFilter(const filter_chain::filter &current, std::string_view value, std::string &out) {
+            // Case filters add at most a separator per character
+            out.reserve(out.size() + value.size() * 2);
+
+            switch (current.kind) {
+                case decltype(current.kind)::Upper:
+                    for (const char c : value) {
+                        out.push_back(toUpper(c));
+                    }
+                    break;
+                case decltype(current.kind)::Lower:
+                    for (const char c : value) {
+                        out.push_back(toLower(c));
+                    }
+                    break;
+                case decltype(current.kind)::Snake:
+                    joinWords(value, '_', out);
+                    break;
+                case decltype(current.kind)::Kebab:
+                    joinWords(value, '-', out);
+                    break;
+                case decltype(current.kind)::Camel:
+                    capitalizeWords(value, true, out);
+                    break;
+                case decltype(current.kind)::Pascal:
+                    capitalizeWords(value, false, out);
+                    break;
+                case decltype(current.kind)::Trim: {
+                    std::size_t begin = 0;
+                    std::size_t end = value.size();
+
+                    while (begin < end && isSpace(value[begin])) {
+                        ++begin;
+                    }
+
+                    while (end > begin && isSpace(value[end - 1])) {
+                        --end;
+                    }
+
+                    out.append(value.substr(begin, end - begin));
+                    break;
+                }
+                case decltype(current.kind)::Replace: {
+                    const std::string_view from = current.arguments[0];
+                    const std::string_view to = current.arguments[1];
+
+                    std::size_t begin = 0;
+                    std::size_t found;
+
+                    while ((found = value.find(from, begin)) != std::string_view::npos) {
+                        out.append(value.substr(begin, found - begin));
+                        out.append(to);
+                        begin = found + from.size();
+                    }
+
+                    out.append(value.substr(begin));
+                    break;
+                }
+                case decltype(current.kind)::Default:
+                    out.append(value.empty() ? std::string_view{ current.arguments[0] } : value);
+                    break;
+            }
+        }
+
+        void appendQuoted(std::string &out, std::string_view value) {
+            out.push_back('"');
+
+            for (const char c : value) {
+                if (c == '"' || c == '\\') {
+                    out.push_back('\\');
+                }
+
+                out.push_back(c);
+            }
+
+            out.push_back('"');
+        }
+    }
+
+    std::optional<filter_chain> filter_chain::parse(std::string_view expression) {
+        expression_reader reader{ expression };
+        filter_chain chain;
+
+        chain.m_Variable = reader.identifier();
+
+        if (chain.m_Variable.empty()) {
+            return std::nullopt;
+        }
+
+        chain.m_Key = chain.m_Variable;
+
+        while (reader.consume('|')) {
+            const auto name = reader.identifier();
+
+            const auto def = std::find_if(Filters.begin(), Filters.end(), [&](const filter_def &current) {
+                return current.name == name;
+            });
+
+            if (def == Filters.end()) {
+                return std::nullopt;
+            }
+
+            filter current{ def->kind, {} };
+
+            if (reader.consume('(')) {
+                if (! reader.consume(')')) {
+                    do {
+                        auto argument = reader.quoted();
+
+                        if (! argument) {
+                            return std::nullopt;
+                        }
+
+                        current.arguments.push_back(std::move(*argument));
+                    } while (reader.consume(','));
+
+                    if (! reader.consume(')')) {
+                        return std::nullopt;
+                    }
+                }
+            }
+
+            if (current.arguments.size() != def->arguments) {
+                return std::nullopt;
+            }
+
+            // Nothing to look for, every position would match
+            if (current.kind == kinds::Replace && current.arguments[0].empty()) {
+                return std::nullopt;
+            }
+
+            chain.m_Key += " | ";
+            chain.m_Key += def->name;
+
+            if (! current.arguments.empty()) {
+                chain.m_Key.push_back('(');
+
+                for (std::size_t i = 0; i < current.arguments.size(); ++i) {
+                    if (i > 0) {
+                        chain.m_Key += ", ";
+                    }
+
+                    appendQuoted(chain.m_Key, current.arguments[i]);
+                }
+
+                chain.m_Key.push_back(')');
+            }
+
+            chain.m_Filters.push_back(std::move(current));
+        }
+
+        reader.skipSpaces();
+
+        if (! reader.done()) {
+            return std::nullopt;
+        }
+
+        return chain;
+    }
+
+    std::string_view filter_chain::variable() const {
+        return m_Variable;
+    }
+
+    const std::string &filter_chain::key() const {
+        return m_Key;
+    }
+
+    bool filter_chain::filtered() const {
+        return ! m_Filters.empty();
+    }
+
+    bool filter_chain::hasDefault() const {
+        return std::any_of(m_Filters.begin(), m_Filters.end(), [](const filter &current) {
+            return current.kind == kinds::Default;
+        });
+    }
+
+    void filter_chain::apply(std::string_view value, std::string &out) const {
+        if (m_Filters.empty()) {
+            out.append(value);
+            return;
+        }
+
+        // Intermediate results bounce between two buffers kept per thread, once they have
+        // grown a chain runs without allocating and the last filter writes into 'out'
+        thread_local std::array<std::string, 2> scratch;
+
+        for (std::size_t i = 0; i < m_Filters.size(); ++i) {
+            if (i + 1 == m_Filters.size()) {
+                applyFilter(m_Filters[i], value, out);
+                break;
+            }
+
+            auto &next = scratch[i % 2];
+            next.clear();
+
+            applyFilter(m_Filters[i], value, next);
+            value = next;
+        }
+    }
+
+}
@@ -1,114 +1,433 @@
 #include "generator.hpp"
 
-#include <list>
+#include <cstring>
+#include <iterator>
+#include <algorithm>
+#include <optional>
 #include <iostream>
-#include <unordered_set>
+
+#include <unistd.h>
 
 #include <ctre.hpp>
 
-#include "variable_substitutor.hpp"
+#include "compiled_template.hpp"
+#include "template_program.hpp"
+#include "variable_resolver.hpp"
+#include "output_manifest.hpp"
+#include "utils/io.hpp"
+#include "utils/file.hpp"
+#include "utils/hash.hpp"
+#include "utils/trace.hpp"
 
 namespace arti {
 
+    namespace {
+        using file_request = utils::io_backend::file_request;
+        using plan_actions = generator::plan_actions;
+        using planned_entry = generator::planned_entry;
+
+        // What 'request' writes, a passthrough source is mapped into 'source'
+        std::vector<std::string_view> contentOf(const file_request &request, std::optional<utils::mapped_file> &source) {
+            if (! request.source) {
+                return request.chunks;
+            }
+
+            if (auto sourceEx = utils::mapped_file::open(*request.source)) {
+                source.emplace(std::move(sourceEx).value());
+                return { source->view() };
+            }
+
+            return {};
+        }
+
+        // Whether the regular file at 'path' already holds 'content'. It's only
+        // read when the manifest can't vouch for it with its size and mtime.
+        bool holdsContent(const std::string &path, const struct stat &st, const std::vector<std::string_view> &content, uint64_t hash, const output_manifest &manifest) {
+            uint64_t size = 0;
+
+            for (const auto &chunk : content) {
+                size += chunk.size();
+            }
+
+            if (static_cast<uint64_t>(st.st_size) != size) {
+                return false;
+            }
+
+            if (const auto *known = manifest.find(path); known && known->size == size && known->mtime == utils::mtimeOf(st)) {
+                return known->hash == hash;
+            }
+
+            auto existing = utils::mapped_file::open(path);
+
+            if (! existing) {
+                return false;
+            }
+
+            const auto onDisk = existing->view();
+            std::size_t offset = 0;
+
+            for (const auto &chunk : content) {
+                if (onDisk.compare(offset, chunk.size(), chunk) != 0) {
+                    return false;
+                }
+
+                offset += chunk.size();
+            }
+
+            return true;
+        }
+
+        // Hidden next to 'path', and unique per call so concurrent runs into the same output don't share it
+        fs::path replacementPath(const fs::path &path) {
+            return utils::temporaryPath(path.parent_path() / fmt::format(".{}.arti-gen", path.filename().string()));
+        }
+    }
+
     generator::generator(generator_template &&template_v)
-        : m_Template(std::move(template_v))
-        , m_Vars(template_v.m_DefaultVars) { 
+        : m_Owned(std::move(template_v))
+        , m_Template(&m_Owned.value()) {
     }
 
     generator::generator(const generator_template &template_v)
-        : m_Template(template_v) {
+        : m_Template(&template_v) {
     }
 
-    tl::expected<void, std::string> generator::loadVars(const opt::variables_map &params) {
-        for (const auto &[k, v] : m_Template.m_DefaultVars) {
-            m_Vars[k] = v;
-        }
+    tl::expected<void, std::string> generator::loadVars(const opt::variables_map &params, const variable_store &overrides, const template_program *program) {
+        // Only the values this generation sets are stored, the template's are viewed
+        m_Vars = variable_store::over(m_Template->m_FileVars);
+        m_Filtered = variable_store{};
 
-        if (! m_Template.m_NameParamOptional) {
+        if (! m_Template->m_NameParamOptional && ! overrides.contains("name")) {
             if (! params.contains("name")) {
                 return tl::unexpected<std::string>{ "The 'name' parameter is required" };
             }
 
-            m_Vars["name"] = params.at("name").as<std::string>();
+            m_Vars.set("name", params.at("name").as<std::vector<std::string>>().front());
         }
 
-        if (params.contains("define")) {
-            auto additionalVars = params.at("define").as<std::vector<std::string>>();
+        if (auto ex = loadDefines(params, m_Vars); ! ex) {
+            return ex;
+        }
 
-            for (const auto &var : additionalVars) {
-                auto match = ctre::match<"(?<name>[a-zA-Z][a-zA-Z0-9_]*)(=(?<value>.*))?">(var);
+        overrides.forEach([&](std::string_view k, std::string_view v) {
+            m_Vars.set(k, v);
+        });
 
-                if (match) {
-                    m_Vars[match.get<"name">().str()] = match.get<"value">().str();
-                }
-                else {
-                    return tl::unexpected<std::string>{ fmt::format("Invalid variable definition '{}'", var) };
-                } 
-            }
+        if (program) {
+            m_Template->builtins().provide(program->references(), m_Vars);
+        }
+        else {
+            m_Template->builtins().provideAll(m_Vars);
         }
 
         return processVars();
     }
 
-    tl::expected<void, std::string> generator::processVars() {
-        std::map<std::string, std::unordered_set<std::string>> graph;
-        
-        for (const auto [k, v] : m_Vars) {
-            auto match = ctre::match<"[{]{2}([ ]*)?(?<varname>[a-zA-Z][a-zA-Z0-9_]*)([ ]*)?[}]{2}">(v);
+    tl::expected<void, std::string> generator::loadDefines(const opt::variables_map &params, variable_store &vars) {
+        if (! params.contains("define")) {
+            return {};
+        }
+
+        for (const auto &var : params.at("define").as<std::vector<std::string>>()) {
+            auto match = ctre::match<"(?<name>[a-zA-Z][a-zA-Z0-9_]*)(=(?<value>.*))?">(var);
 
-            if (match) {
-                graph[k].insert(match.get<"varname">().str());
+            if (! match) {
+                return tl::unexpected<std::string>{ fmt::format("Invalid variable definition '{}'", var) };
             }
+
+            vars.set(match.get<"name">().to_view(), match.get<"value">().to_view());
+        }
+
+        return {};
+    }
+
+    tl::expected<void, std::string> generator::processVars() {
+        if (auto ex = variable_resolver::resolve(m_Vars); ! ex) {
+            auto [errorCode, errorInfo] = std::move(ex).error();
+
+            return tl::unexpected<std::string>{ std::move(errorInfo) };
+        }
+
+        return {};
+    }
+
+    tl::expected<void, std::string> generator::run() const {
+        return run(run_options{});
+    }
+
+    tl::expected<void, std::string> generator::run(const run_options &options) const {
+        auto programEx = template_program::compile(*m_Template);
+
+        if (! programEx) {
+            return tl::unexpected<std::string>{ std::move(programEx).error() };
+        }
+
+        run_report report;
+
+        auto ex = run(programEx.value(), options, report);
+
+        for (const auto &message : report.messages) {
+            fmt::print("{}\n", message);
+        }
+
+        return ex;
+    }
+
+    tl::expected<void, std::string> generator::run(const template_program &program, const run_options &options, run_report &report) const {
+        if (options.archive) {
+            return archive(program, options, report);
         }
 
-        const auto cycleDetection = [&]() -> bool {
-            std::unordered_map<std::string, bool> visited;
+        auto planEx = plan(program, options);
+
+        if (! planEx) {
+            return tl::unexpected<std::string>{ std::move(planEx).error() };
+        }
+
+        return execute(planEx.value(), options, report);
+    }
 
-            return false;
+    tl::expected<generator::output_plan, std::string> generator::plan(const template_program &program, const run_options &options, bool hashAll) const {
+        return plan(program, options, hashAll, {});
+    }
+
+    tl::expected<generator::output_plan, std::string> generator::plan(const template_program &program, const run_options &options, bool hashAll, const entry_sink &sink) const {
+        using types = template_program::types;
+        using entry_t = template_program::entry;
+        using counters = utils::trace::counters;
+        using span = utils::trace::span;
+
+        const span phase{ span::kinds::Phase, "plan" };
+
+        const auto reportUndefined = [&](const compiled_template &compiled, std::string_view origin, std::vector<std::string> &messages) {
+            for (const auto &name : compiled.undefinedVariables(m_Vars)) {
+                messages.push_back(fmt::format("Warning: undefined variable '{}' used in '{}'", name, origin));
+            }
         };
 
-        const auto topologicalSort = [&]() -> std::list<std::string> {
-            std::unordered_map<std::string, bool> visited;
-            std::list<std::string> order;
+        const bool manifestEnabled = ! options.manifestDirectory.empty();
+        // An archive starts out empty, nothing on disk is in its way
+        const bool onDisk = options.archive == nullptr;
 
-            auto dfs = [&] (const auto &recurse, const std::string &node) -> void {
-                visited[node] = true;
+        output_plan plan;
+        plan.type = program.type();
+        plan.hashed = hashAll || options.update || manifestEnabled;
 
-                for (const auto &neigh : graph[node]) {
-                    if (! visited[neigh]) {
-                        recurse(recurse, neigh);
-                    }
+        output_manifest previous;
+
+        const auto loadPrevious = [&] {
+            if (options.update && manifestEnabled) {
+                previous = output_manifest::load(options.manifestDirectory, plan.output);
+            }
+        };
+
+        // Rendering only collects views into the sources, m_Vars and m_Filtered, execution writes them.
+        // 'checked' is false below a directory about to be created, nothing is there yet.
+        const auto planFile = [&](planned_entry &current, const entry_t &file, bool checked) {
+            auto &request = current.request;
+            request.path = current.path;
+            request.mode = file.mode;
+
+            std::optional<utils::mapped_file> source;
+            std::vector<std::string_view> sourceContent;
+
+            if (file.passthrough) {
+                request.source = &file.templatePath;
+
+                if (plan.hashed) {
+                    sourceContent = contentOf(request, source);
                 }
+            }
+            else {
+                reportUndefined(file.content, file.templatePath.string(), current.messages);
+                file.content.renderTo(request.chunks, file.content.bind(m_Vars), m_Filtered);
 
-                order.push_back(node);
-            };
+                utils::trace::add(counters::Placeholders, file.content.placeholderCount() + file.name.placeholderCount());
+            }
+
+            const auto &content = file.passthrough ? sourceContent : request.chunks;
+
+            if (! file.passthrough || plan.hashed) {
+                utils::hasher hasher;
+
+                for (const auto &chunk : content) {
+                    hasher.update(chunk);
+                    current.size += chunk.size();
+                }
+
+                current.hash = hasher.digest();
+            }
+
+            if (! checked) {
+                return;
+            }
+
+            const auto st = utils::statOf(current.path);
+
+            if (! st) {
+                return;
+            }
 
-            for (const auto &[k, _] : graph) {
-                if (! visited[k])
-                    dfs(dfs, k);
+            if (! S_ISREG(st->st_mode)) {
+                current.action = plan_actions::Conflict;
+            }
+            else if (! options.update) {
+                current.action = plan_actions::Skip;
+            }
+            else {
+                current.mtime = utils::mtimeOf(*st);
+
+                // An unreadable source is reported by the copy
+                const bool same = (! file.passthrough || source) && holdsContent(current.path, *st, content, current.hash, previous);
+
+                current.action = same ? plan_actions::Unchanged : plan_actions::Replace;
+            }
+        };
+
+        const auto emit = [&](planned_entry &current) -> tl::expected<void, std::string> {
+            if (! sink) {
+                return {};
             }
 
-            return order;
+            return sink(current);
         };
 
-        auto order = topologicalSort();
+        const auto baseNewPath = options.outputRoot.empty() ? fs::current_path() : options.outputRoot;
+
+        if (program.type() == types::File) {
+            const auto &file = program.entries().front();
+
+            reportUndefined(file.name, "root", plan.messages);
 
-        for (const auto &process : order) {
-            auto match = ctre::match<"[{]{2}([ ]*)?(?<varname>[a-zA-Z][a-zA-Z0-9_]*)([ ]*)?[}]{2}">(m_Vars[process]);
+            plan.output = (baseNewPath / file.name.render(m_Vars)).string();
+            loadPrevious();
 
-            if (match) {
-                m_Vars[process] = m_Vars[match.get<"varname">().str()];
+            auto &current = plan.entries.emplace_back();
+            current.path = plan.output;
+
+            planFile(current, file, onDisk);
+
+            // Only an update may generate over an existing file
+            if (current.action == plan_actions::Skip) {
+                current.action = plan_actions::Conflict;
+            }
+
+            plan.conflicts = current.action == plan_actions::Conflict ? 1 : 0;
+
+            if (auto ex = emit(current); ! ex) {
+                return tl::unexpected<std::string>{ std::move(ex).error() };
             }
+
+            return std::move(plan);
         }
 
-        return {};
-    }
+        if (program.type() == types::Folder) {
+            reportUndefined(program.root(), "root", plan.messages);
 
-    tl::expected<void, std::string> generator::run() const {
-        if (m_Template.m_Type == decltype(m_Template)::types::Unknown) {
-            return tl::unexpected<std::string>{ "Unexpected template type received" };
+            const auto rootName = program.root().render(m_Vars);
+
+            plan.output = (baseNewPath / rootName).string();
+            loadPrevious();
+
+            const auto &entries = program.entries();
+            plan.entries.reserve(entries.size() + 1);
+
+            auto &root = plan.entries.emplace_back();
+            root.path = plan.output;
+            root.directory = true;
+
+            if (rootName.empty()) {
+                root.action = plan_actions::Conflict;
+            }
+            else if (const auto st = onDisk ? utils::statOf(root.path) : std::nullopt) {
+                root.action = S_ISDIR(st->st_mode) && options.update ? plan_actions::Unchanged : plan_actions::Conflict;
+            }
+
+            // Nothing below an existing root is looked at unless updating
+            if (root.action == plan_actions::Conflict) {
+                plan.conflicts = 1;
+                return std::move(plan);
+            }
+
+            if (auto ex = emit(root); ! ex) {
+                return tl::unexpected<std::string>{ std::move(ex).error() };
+            }
+
+            // Plan index of every program entry, npos for those left out
+            std::vector<std::size_t> planned(entries.size(), std::string::npos);
+
+            for (std::size_t i = 0; i < entries.size(); ++i) {
+                const auto &entry = entries[i];
+                const auto parent = entry.parent == template_program::Root ? 0 : planned[entry.parent];
+
+                if (parent == std::string::npos) {
+                    continue;
+                }
+
+                const auto name = entry.name.render(m_Vars);
+
+                // A name rendering empty, like '{% if tests %}tests{% endif %}', leaves out its entry and all below it
+                if (name.empty()) {
+                    continue;
+                }
+
+                planned[i] = plan.entries.size();
+
+                auto &current = plan.entries.emplace_back();
+                current.directory = entry.directory;
+                current.parent = parent;
+
+                reportUndefined(entry.name, entry.templatePath.string(), current.messages);
+
+                // Built on the parent's rendered path, every name is only rendered once
+                const auto &parentPath = plan.entries[parent].path;
+
+                current.path.reserve(parentPath.size() + 1 + name.size());
+                current.path.append(parentPath).append(1, '/').append(name);
+
+                // A subtree created from scratch needs no checks
+                const auto parentAction = plan.entries[parent].action;
+
+                if (! entry.directory) {
+                    planFile(current, entry, parentAction != plan_actions::Create);
+                }
+                else if (parentAction != plan_actions::Create) {
+                    if (const auto st = utils::statOf(current.path)) {
+                        if (! S_ISDIR(st->st_mode)) {
+                            current.action = plan_actions::Conflict;
+                        }
+                        else {
+                            current.action = options.update ? plan_actions::Unchanged : plan_actions::Skip;
+                        }
+                    }
+                }
+
+                // A conflicting directory can't hold anything
+                if (parentAction == plan_actions::Conflict) {
+                    current.action = plan_actions::Conflict;
+                }
+
+                if (current.action == plan_actions::Conflict) {
+                    ++plan.conflicts;
+                }
+
+                if (auto ex = emit(current); ! ex) {
+                    return tl::unexpected<std::string>{ std::move(ex).error() };
+                }
+            }
+
+            return std::move(plan);
         }
 
+        return tl::unexpected<std::string>{ "Unexpected template type received" };
+    }
+
+    tl::expected<void, std::string> generator::execute(const output_plan &plan, const run_options &options, run_report &report) const {
+        using types = template_program::types;
+        using status_t = utils::io_backend::status_t;
+        using counters = utils::trace::counters;
+        using span = utils::trace::span;
+
         enum class GenerateFileError {
             UnableToOpenTemplate,
             AlreadyExisting,
@@ -116,64 +435,199 @@ namespace arti {
             Unknown
         };
 
-        const auto generateFile = [&](fs::path templateFile, fs::path newFile) -> tl::expected<void, GenerateFileError> {
-            using vars = variable_substitutor;
- 
-            std::ifstream templateFileStream;
-            std::ofstream newFileStream;
-
-            try {
-                templateFileStream.open(templateFile);
+        const auto fileStatus = [&](const status_t &written) -> tl::expected<void, GenerateFileError> {
+            if (written) {
+                return {};
             }
-            catch(...) {
-                return tl::unexpected{ GenerateFileError::UnableToOpenTemplate };
+
+            switch (written.error().error) {
+                case utils::file_errors::AlreadyExisting:
+                    return tl::unexpected{ GenerateFileError::AlreadyExisting };
+                case utils::file_errors::UnableToOpen:
+                    return tl::unexpected{ GenerateFileError::UnableToOpenTemplate };
+                default:
+                    return tl::unexpected{ GenerateFileError::UnableToCreate };
             }
+        };
 
-            if (! templateFileStream.is_open()) {
-                return tl::unexpected{ GenerateFileError::UnableToOpenTemplate };
+        std::copy(plan.messages.begin(), plan.messages.end(), std::back_inserter(report.messages));
+
+        const auto &entries = plan.entries;
+        const auto &first = entries.front();
+
+        if (first.action == plan_actions::Conflict) {
+            std::copy(first.messages.begin(), first.messages.end(), std::back_inserter(report.messages));
+
+            report.rootExisted = true;
+
+            if (plan.type == types::File) {
+                return tl::unexpected<std::string>{ fmt::format("The file '{}' already exists", fs::path{ first.path }.filename().string()) };
             }
 
-            if (fs::exists(newFile)) {
-                return tl::unexpected{ GenerateFileError::AlreadyExisting };
+            return tl::unexpected<std::string>{ fmt::format("The folder '{}' already exists", first.path) };
+        }
+
+        // Checked once, up front: a conflicting path stops the run before anything is written
+        if (plan.conflicts > 0) {
+            const auto conflict = std::find_if(entries.begin(), entries.end(), [](const planned_entry &current) {
+                return current.action == plan_actions::Conflict;
+            });
+
+            return tl::unexpected<std::string>{ fmt::format(
+                "'{}' is in the way of the output ({} conflicting paths), nothing was generated",
+                conflict->path,
+                plan.conflicts
+            ) };
+        }
+
+        const auto io = utils::io_backend::create(options.io, entries.size());
+
+        if (! io) {
+            return tl::unexpected<std::string>{ "The io_uring backend isn't available on this system" };
+        }
+
+        constexpr auto NoParent = utils::io_backend::NoParent;
+
+        // Batch index of every directory entry given to makeDirectories
+        std::vector<std::size_t> batchIndex(entries.size(), NoParent);
+
+        // The batch index of the directory holding entry 'i', unless a variable put a '/' in its name
+        const auto parentIndex = [&](std::size_t i) {
+            const auto &parentPath = entries[entries[i].parent].path;
+            const auto &path = entries[i].path;
+
+            return path.rfind('/') == parentPath.size() && path.starts_with(parentPath) ? batchIndex[entries[i].parent] : NoParent;
+        };
+
+        // Creates and replaces 'files' (indices into entries). Replaced files are written to
+        // a temporary file renamed over the old one, a failed write never truncates it.
+        const auto writeFiles = [&](const std::vector<std::size_t> &files) {
+            std::vector<file_request> toWrite;
+            toWrite.reserve(files.size());
+
+            for (const auto i : files) {
+                toWrite.push_back(entries[i].request);
+
+                if (plan.type == types::Folder) {
+                    toWrite.back().parent = parentIndex(i);
+                }
+
+                if (entries[i].action == plan_actions::Replace) {
+                    toWrite.back().path = replacementPath(entries[i].path);
+                }
             }
 
-            try {
-                fs::copy(templateFile, newFile);
+            auto statuses = io->writeFiles(toWrite, options.jobs);
+
+            for (std::size_t k = 0; k < files.size(); ++k) {
+                const auto &current = entries[files[k]];
+                auto &status = statuses[k];
+
+                if (current.action != plan_actions::Replace) {
+                    continue;
+                }
 
-                newFileStream.open(newFile);
+                const auto &temp = toWrite[k].path;
+
+                // Only a temp this run created is removed, an existing one belongs to another run
+                if (! status) {
+                    if (status.error().error != utils::file_errors::AlreadyExisting) {
+                        ::unlink(temp.c_str());
+                    }
+
+                    continue;
+                }
+
+                if (::rename(temp.c_str(), current.path.c_str()) != 0) {
+                    status = status_t::unexpected_type{ { utils::file_errors::UnableToCreate, fmt::format("{}: {}", current.path, std::strerror(errno)) } };
+                    ::unlink(temp.c_str());
+                }
             }
-            catch(...) {
-                return tl::unexpected{ GenerateFileError::UnableToCreate };
+
+            return statuses;
+        };
+
+        const auto saveManifest = [&](const std::vector<bool> &written) {
+            if (options.manifestDirectory.empty()) {
+                return;
             }
 
-            std::string line;
+            output_manifest next;
 
-            while (std::getline(templateFileStream, line)) {
-                newFileStream << vars::run(line, m_Vars) << '\n';
+            for (std::size_t i = 0; i < entries.size(); ++i) {
+                const auto &current = entries[i];
+
+                if (! written[i]) {
+                    continue;
+                }
+
+                output_manifest::entry value{ current.size, current.mtime, current.hash };
+
+                if (current.action != plan_actions::Unchanged) {
+                    const auto st = utils::statOf(current.path);
+
+                    if (! st) {
+                        continue;
+                    }
+
+                    value.mtime = utils::mtimeOf(*st);
+                }
+
+                next.set(current.path, value);
             }
 
-            return {};
+            next.save(options.manifestDirectory, plan.output);
         };
 
-        if (m_Template.m_Type == decltype(m_Template)::types::File) {
-            using vars = variable_substitutor;
+        const auto countWritten = [&](plan_actions action, const std::string &path, std::vector<std::string> &messages) {
+            switch (action) {
+                case plan_actions::Replace:
+                    ++report.filesUpdated;
+                    messages.push_back(fmt::format("Updated '{}'", path));
+                    break;
+                case plan_actions::Unchanged:
+                    ++report.filesUnchanged;
+                    return;
+                default:
+                    ++report.filesCreated;
+
+                    if (options.update) {
+                        messages.push_back(fmt::format("Created '{}'", path));
+                    }
+                    break;
+            }
+
+            utils::trace::add(counters::FilesCreated);
+        };
 
-            const auto templateFile = m_Template.m_Location / m_Template.m_TemplateRoot;
-            const auto newFile = fs::current_path() / vars::run(m_Template.m_TemplateRoot, m_Vars);
-            
-            if (! fs::exists(templateFile)) {
-                return tl::unexpected<std::string>{ "The template file provided does not exist" };
+        const auto reportUpdate = [&] {
+            if (options.update) {
+                report.messages.push_back(fmt::format(
+                    "{} files updated, {} created, {} unchanged",
+                    report.filesUpdated,
+                    report.filesCreated,
+                    report.filesUnchanged
+                ));
             }
+        };
+
+        if (plan.type == types::File) {
+            std::copy(first.messages.begin(), first.messages.end(), std::back_inserter(report.messages));
 
-            if (auto ex = generateFile(templateFile, newFile); ! ex) {
-                auto errorCode = ex.error();
+            const bool write = first.action != plan_actions::Unchanged;
+            const auto written = write ? fileStatus(writeFiles({ 0 }).front()) : tl::expected<void, GenerateFileError>{};
+
+            if (! written) {
+                auto errorCode = written.error();
+                const auto fileName = fs::path{ first.path }.filename().string();
 
                 switch (errorCode) {
                     case decltype(errorCode)::AlreadyExisting:
-                        return tl::unexpected<std::string>{ fmt::format("The file '{}' already exists", newFile.filename().string()) };
+                        report.rootExisted = true;
+                        return tl::unexpected<std::string>{ fmt::format("The file '{}' already exists", fileName) };
                         break;
                     case decltype(errorCode)::UnableToCreate:
-                        return tl::unexpected<std::string>{ fmt::format("Couldn't create the file '{}'", newFile.filename().string()) };
+                        return tl::unexpected<std::string>{ fmt::format("Couldn't create the file '{}'", fileName) };
                         break;
                     case decltype(errorCode)::UnableToOpenTemplate:
                         return tl::unexpected<std::string>{ "Couldn't open the template file provided" };
@@ -184,90 +638,232 @@ namespace arti {
                 }
             }
 
+            countWritten(first.action, first.path, report.messages);
+            saveManifest({ true });
+            reportUpdate();
+
             return {};
         }
-        
-        if (m_Template.m_Type == decltype(m_Template)::types::Folder) {
-            const auto basePath = m_Template.m_Location;
-            const auto baseTemplatePath = basePath / m_Template.m_TemplateRoot;
-            const auto baseNewPath = fs::current_path();
-
-            if (! fs::exists(baseTemplatePath)) {
-                return tl::unexpected<std::string>{ "The template folder does not exist" };
-            }
-
-            if (
-                auto baseNewPathS = variable_substitutor::run(baseNewPath / m_Template.m_TemplateRoot, m_Vars); 
-                ! baseNewPathS.empty()
-               ) {
-               
-                if (fs::exists(baseNewPathS)) {
-                    return tl::unexpected<std::string>{ fmt::format("The folder '{}' already exists", baseNewPathS) };
+
+        if (plan.type == types::Folder) {
+            if (first.action == plan_actions::Create) {
+                if (auto ex = utils::makeDirectory(first.path); ! ex) {
+                    if (ex.error().error == utils::file_errors::AlreadyExisting) {
+                        report.rootExisted = true;
+                        return tl::unexpected<std::string>{ fmt::format("The folder '{}' already exists", first.path) };
+                    }
+
+                    return tl::unexpected<std::string>{ fmt::format("Unable to create folder '{}'", first.path) };
                 }
-                
-                try {
-                    fs::create_directory(baseNewPathS);
+
+                utils::trace::add(counters::DirectoriesCreated);
+                ++report.directoriesCreated;
+            }
+
+            struct result {
+                std::vector<std::string> messages;
+                tl::expected<void, GenerateFileError> status;
+            };
+
+            std::vector<result> results(entries.size());
+
+            for (std::size_t i = 0; i < entries.size(); ++i) {
+                results[i].messages = entries[i].messages;
+            }
+
+            const auto flushMessages = [&] {
+                for (auto &current : results) {
+                    std::move(current.messages.begin(), current.messages.end(), std::back_inserter(report.messages));
+                    current.messages.clear();
                 }
-                catch(...) {
-                    return tl::unexpected<std::string>{ fmt::format("Unable to create folder '{}'", baseNewPathS) };
+            };
+
+            std::optional<span> phase{ std::in_place, span::kinds::Phase, "create directories" };
+
+            std::vector<std::size_t> directories;
+            std::vector<utils::io_backend::directory_request> directoryRequests;
+
+            // Kept in walk order so parents always come before their children. The root and
+            // directories already there are only opened, what's below them is made relative to them.
+            for (std::size_t i = 0; i < entries.size(); ++i) {
+                if (entries[i].directory) {
+                    batchIndex[i] = directories.size();
+                    directories.push_back(i);
+                    directoryRequests.push_back({ entries[i].path, i == 0 ? NoParent : parentIndex(i), i == 0 || entries[i].action != plan_actions::Create });
                 }
             }
-            else {
-                return tl::unexpected<std::string>{ fmt::format("The folder '{}' already exists", baseNewPathS) };
-            }
-
-            for (const auto &entry : fs::recursive_directory_iterator(baseTemplatePath)) {
-                const auto tPath = entry.path();
-                const auto tName = tPath.filename().string();
-
-                const auto newPath = variable_substitutor::run(
-                    fmt::format("{}/{}", 
-                        tPath.parent_path().string().replace(
-                            0, basePath.string().length(), baseNewPath.string()
-                        ), 
-                        tName
-                    ),
-                    m_Vars
-                );
-
-                if (fs::is_directory(tPath)) {
-                    if (fs::exists(newPath)) {
-                        fmt::print("The directory '{}' already exists, omitting its creation\n", newPath);
-                        continue;
-                    }
 
-                    try {
-                        fs::create_directory(newPath);
-                    }
-                    catch(...) {
-                        return tl::unexpected<std::string>{ fmt::format("Error, Couldn't create the directory '{}'", newPath) };
-                    }
+            const auto directoryStatuses = io->makeDirectories(directoryRequests);
+
+            for (std::size_t k = 0; k < directories.size(); ++k) {
+                const auto &status = directoryStatuses[k];
+
+                if (directoryRequests[k].existing) {
+                    continue;
                 }
-                else if (fs::is_regular_file(tPath)) {
-                    if (auto ex = generateFile(tPath, newPath); ! ex) {
-                        auto errorCode = ex.error();
-
-                        switch (errorCode) {
-                            case decltype(errorCode)::AlreadyExisting:
-                                fmt::print("The file '{}' already exists, omitting its creation\n", newPath);
-                                continue;
-                                break;
-                            case decltype(errorCode)::UnableToCreate:
-                                // TODO: Maybe clean?
-                                return tl::unexpected<std::string>{ fmt::format("Couldn't create the file '{}'", newPath) };
-                                break;
-                            case decltype(errorCode)::UnableToOpenTemplate:
-                                break;
-                            case decltype(errorCode)::Unknown:
-                                return tl::unexpected<std::string>{ "Unknown error ocurred :(" };
-                                break;
-                        }
+
+                if (status) {
+                    utils::trace::add(counters::DirectoriesCreated);
+                    ++report.directoriesCreated;
+                    continue;
+                }
+
+                // Created since it was planned, kept as an existing one
+                if (status.error().error == utils::file_errors::AlreadyExisting) {
+                    results[directories[k]].status = tl::unexpected{ GenerateFileError::AlreadyExisting };
+                    continue;
+                }
+
+                flushMessages();
+                return tl::unexpected<std::string>{ fmt::format("Error, Couldn't create the directory '{}'", entries[directories[k]].path) };
+            }
+
+            phase.emplace(span::kinds::Phase, "write files");
+
+            std::vector<std::size_t> files;
+
+            for (std::size_t i = 1; i < entries.size(); ++i) {
+                const auto action = entries[i].action;
+
+                if (! entries[i].directory && (action == plan_actions::Create || action == plan_actions::Replace)) {
+                    files.push_back(i);
+                }
+            }
+
+            const auto fileStatuses = writeFiles(files);
+            std::vector<bool> written(entries.size(), false);
+
+            for (std::size_t k = 0; k < files.size(); ++k) {
+                results[files[k]].status = fileStatus(fileStatuses[k]);
+            }
+
+            phase.reset();
+
+            // Results are reported in walk order regardless of the completion order
+            for (std::size_t i = 1; i < entries.size(); ++i) {
+                const auto &current = entries[i];
+                auto &result = results[i];
+
+                std::move(result.messages.begin(), result.messages.end(), std::back_inserter(report.messages));
+
+                const bool skipped = current.action == plan_actions::Skip || (! result.status && result.status.error() == GenerateFileError::AlreadyExisting);
+
+                if (current.directory) {
+                    if (skipped) {
+                        report.messages.push_back(fmt::format("The directory '{}' already exists, omitting its creation", current.path));
+                        ++report.skipped;
                     }
+
+                    continue;
+                }
+
+                if (skipped) {
+                    report.messages.push_back(fmt::format("The file '{}' already exists, omitting its creation", current.path));
+                    ++report.skipped;
+                    continue;
+                }
+
+                if (result.status) {
+                    written[i] = true;
+                    countWritten(current.action, current.path, report.messages);
+                    continue;
+                }
+
+                auto errorCode = result.status.error();
+
+                switch (errorCode) {
+                    case decltype(errorCode)::AlreadyExisting:
+                        break;
+                    case decltype(errorCode)::UnableToCreate:
+                        // TODO: Maybe clean?
+                        saveManifest(written);
+                        return tl::unexpected<std::string>{ fmt::format("Couldn't create the file '{}'", current.path) };
+                        break;
+                    case decltype(errorCode)::UnableToOpenTemplate:
+                        report.messages.push_back(fmt::format("Couldn't open the template file of '{}', omitting its creation", current.path));
+                        break;
+                    case decltype(errorCode)::Unknown:
+                        return tl::unexpected<std::string>{ "Unknown error ocurred :(" };
+                        break;
                 }
-                else {
-                    return tl::unexpected<std::string>{ "Unrecognized or invalid file type provided on template" };
+            }
+
+            saveManifest(written);
+            reportUpdate();
+
+            return {};
+        }
+
+        return tl::unexpected<std::string>{ "Unexpected template type received" };
+    }
+
+    tl::expected<void, std::string> generator::archive(const template_program &program, const run_options &options, run_report &report) const {
+        using counters = utils::trace::counters;
+        using span = utils::trace::span;
+
+        const span phase{ span::kinds::Phase, "write archive" };
+
+        auto &writer = *options.archive;
+
+        // The output file or root folder comes first, everything is archived relative to its parent
+        std::optional<fs::path> base;
+        std::vector<std::string> messages;
+
+        const auto write = [&](planned_entry &current) -> tl::expected<void, std::string> {
+            std::move(current.messages.begin(), current.messages.end(), std::back_inserter(messages));
+
+            if (! base) {
+                base = fs::path{ current.path }.parent_path();
+            }
+
+            const auto path = fs::path{ current.path }.lexically_relative(*base).generic_string();
+
+            if (current.directory) {
+                if (auto ex = writer.directory(path); ! ex) {
+                    return tl::unexpected<std::string>{ fmt::format("Couldn't write the archive, {}", ex.error().info) };
                 }
+
+                utils::trace::add(counters::DirectoriesCreated);
+                ++report.directoriesCreated;
+                return {};
+            }
+
+            std::optional<utils::mapped_file> source;
+            auto &request = current.request;
+
+            if (request.source && contentOf(request, source).empty()) {
+                return tl::unexpected<std::string>{ fmt::format("Couldn't open the template file '{}'", request.source->string()) };
             }
+
+            const auto written = source ? writer.file(path, request.mode, { source->view() }) : writer.file(path, request.mode, request.chunks);
+
+            if (! written) {
+                return tl::unexpected<std::string>{ fmt::format("Couldn't write the archive, {}", written.error().info) };
+            }
+
+            // Already in the archive, only the planned path and hash are kept
+            request.chunks = {};
+
+            utils::trace::add(counters::FilesCreated);
+            ++report.filesCreated;
+            return {};
+        };
+
+        auto planEx = plan(program, options, false, write);
+
+        if (planEx) {
+            std::copy(planEx->messages.begin(), planEx->messages.end(), std::back_inserter(report.messages));
+        }
+
+        std::move(messages.begin(), messages.end(), std::back_inserter(report.messages));
+
+        if (! planEx) {
+            return tl::unexpected<std::string>{ std::move(planEx).error() };
+        }
+
+        // Only an empty root name conflicts, the archive itself starts out empty
+        if (planEx->conflicts > 0) {
+            return tl::unexpected<std::string>{ "The root folder name is empty, there's nothing to archive it under" };
         }
 
         return {};
@@ -3,7 +3,12 @@
 #include <utility>
 
 #include <fmt/format.h>
-#include <fmt/chrono.h>
+
+#include "template_pack.hpp"
+#include "template_registry.hpp"
+
+#include "utils/file.hpp"
+#include "utils/trace.hpp"
 
 #include "internal/config.hpp"
 
@@ -14,38 +19,121 @@ namespace arti {
     }
 
     generator_template::expected_t generator_template::loadFromConfig(std::string_view name) {
-        static const toml::table s_UserConfiog = [] {
+        return loadFromConfig(name, arti::config::config_path);
+    }
+
+    generator_template::expected_t generator_template::loadFromConfig(std::string_view name, const fs::path &configPath) {
+        // A single stat decides, a packed template never reads the config files
+        if (const auto packPath = template_pack::location(configPath, name); utils::statOf(packPath)) {
+            return loadFromPack(packPath, configPath);
+        }
+
+        return loadFromDirectory(name, configPath);
+    }
+
+    generator_template::expected_t generator_template::loadFromPack(const fs::path &packPath, const fs::path &configPath) {
+        using span = utils::trace::span;
+
+        auto packEx = [&] {
+            const span phase{ span::kinds::Phase, "pack open" };
+
+            return template_pack::open(packPath);
+        }();
+
+        if (! packEx) {
+            return expected_t::unexpected_type{ { errors::ParseError, std::move(packEx).error().info } };
+        }
+
+        auto pack = std::move(packEx).value();
+        const auto name = pack->name();
+
+        auto tableEx = [&]() -> tl::expected<toml::table, std::string> {
+            const span phase{ span::kinds::Phase, "config parse" };
+
             try {
-                return toml::parse_file(fmt::format("{}/config.toml", arti::config::config_path));
+                auto section = toml::parse(pack->config(), packPath.string());
+
+                if (auto *table = section.get_as<toml::table>(name)) {
+                    return std::move(*table);
+                }
             }
-            catch(std::exception &e) {
-                fmt::print("Couldn't load user config from '{}'"
-                           ", make sure the config files exists and has the right perms\n"
-                           "Reported error: {}\n",
-                           arti::config::config_path,
-                           e.what());
-
-                return toml::table{ };
+            catch (const toml::parse_error &err) {
+                return tl::unexpected<std::string>{ fmt::format("Couldn't parse the config packed in '{}': {}", packPath.string(), err.description()) };
             }
-            catch(...) {
-                fmt::print("Couldn't load user config from '{}'"
-                           ", make sure the config files exists and has the right perms\n",
-                           arti::config::config_path);
 
-                return toml::table{ };
+            return tl::unexpected<std::string>{ fmt::format("The pack '{}' doesn't hold the config of '{}'", packPath.string(), name) };
+        }();
+
+        if (! tableEx) {
+            return expected_t::unexpected_type{ { errors::ParseError, std::move(tableEx).error() } };
+        }
+
+        auto templateEx = fromConfig(name, tableEx.value(), configPath);
+
+        if (! templateEx) {
+            return templateEx;
+        }
+
+        auto temp = std::move(templateEx).value();
+
+        temp.m_Pack = std::move(pack);
+
+        if (auto varsEx = temp.loadDefaultVars(); ! varsEx) {
+            return expected_t::unexpected_type{ std::move(varsEx).error() };
+        }
+
+        return std::move(temp);
+    }
+
+    generator_template::expected_t generator_template::loadFromDirectory(std::string_view name, const fs::path &configPath) {
+        using span = utils::trace::span;
+
+        auto registryEx = [&] {
+            const span phase{ span::kinds::Phase, "config index" };
+
+            return template_registry::open(configPath);
+        }();
+
+        if (! registryEx) {
+            auto [errorCode, errorInfo] = std::move(registryEx).error();
+
+            if (errorCode == template_registry::errors::ConfigNotFound) {
+                return expected_t::unexpected_type{ { errors::ConfigNotFound, std::move(errorInfo) } };
             }
+
+            return expected_t::unexpected_type{ { errors::ParseError, std::move(errorInfo) } };
+        }
+
+        auto tableEx = [&] {
+            const span phase{ span::kinds::Phase, "config parse" };
+
+            return registryEx->table(name);
         }();
 
-        if (s_UserConfiog.empty()) {
-            return expected_t::unexpected_type{ { errors::ConfigNotFound, "User config not found" } };
+        if (! tableEx) {
+            auto [errorCode, errorInfo] = std::move(tableEx).error();
+
+            if (errorCode == template_registry::errors::NotFound) {
+                return expected_t::unexpected_type{ { errors::NotFound, std::move(errorInfo) } };
+            }
+
+            return expected_t::unexpected_type{ { errors::ParseError, std::move(errorInfo) } };
+        }
+
+        auto templateEx = fromConfig(name, tableEx.value(), configPath);
+
+        if (! templateEx) {
+            return templateEx;
         }
 
-        if (! s_UserConfiog.contains(name)) {
-            return expected_t::unexpected_type{ { errors::NotFound, fmt::format("Template '{}' not found on user config", name) } };
+        if (auto varsEx = templateEx->loadDefaultVars(); ! varsEx) {
+            return expected_t::unexpected_type{ std::move(varsEx).error() };
         }
 
-        auto templateConfig = *s_UserConfiog.get(name)->as_table();
+        return templateEx;
+    }
 
+    generator_template::expected_t generator_template::fromConfig(std::string_view name, const toml::table &templateConfig, const fs::path &configPath) {
         auto templateType = [&] {
             auto typeStr = templateConfig.get("type")->value_or<std::string>("unknown");
 
@@ -91,53 +179,92 @@ namespace arti {
         }();
         std::string templateName = templateConfig.get_as<std::string>("name")->value_or("");
         std::string templateRoot = templateConfig.get_as<std::string>("root")->value_or("");
-        fs::path templatePath{ fmt::format("{}/{}", arti::config::config_path, templateConfig.get_as<std::string>("folder")->value_or("")) };
+        fs::path templatePath{ fmt::format("{}/{}", configPath.string(), templateConfig.get_as<std::string>("folder")->value_or("")) };
 
 
-        generator_template temp{
+        return generator_template{
             templateType,
             nameParamOptional,
             templatePath,
             templateName,
             templateRoot
         };
+    }
 
-        temp.loadDefaultVars();
+    generator_template::status_t generator_template::loadDefaultVars() {
+        m_Builtins = std::make_shared<builtin_providers>();
 
-        return std::move(temp);
+        return loadVarsFile();
+    }
+
+    void generator_template::setWorkingDirectory(const fs::path &cwd, builtin_providers::environment_ptr environment) {
+        m_Builtins = std::make_shared<builtin_providers>(cwd, std::move(environment));
+    }
+
+    void generator_template::startProject() {
+        m_Builtins = std::make_shared<builtin_providers>(m_Builtins);
     }
 
-    void generator_template::loadDefaultVars() {
-        m_DefaultVars["now"] = fmt::format("{:%A %B %d, %Y - %I:%M:%S%p}", fmt::localtime(std::time(nullptr)));
-        m_DefaultVars["today"] = fmt::format("{:%A %B %d, %Y}", fmt::localtime(std::time(nullptr)));
-        m_DefaultVars["full_cwd"] = fs::current_path().string();
-        m_DefaultVars["cwd"] = fs::current_path().filename().string();
+    generator_template::status_t generator_template::loadVarsFile() {
+        const utils::trace::span phase{ utils::trace::span::kinds::Phase, "vars.toml" };
 
         const auto varsPath = m_Location / "vars.toml";
 
-        if (! fs::exists(varsPath)) {
-            return;
-        }
+        // Read again when vars.toml changes, a removed value doesn't linger
+        m_FileVars = variable_store{};
+
+        toml::table vars;
 
-        // TODO: Implement 'dynamic' variables, dependency graph?
+        try {
+            if (m_Pack) {
+                const auto *packed = m_Pack->find("vars.toml");
 
-        auto vars = toml::parse_file(varsPath.string());
+                if (! packed) {
+                    return {};
+                }
+
+                const auto contentEx = m_Pack->content(*packed);
+
+                if (! contentEx) {
+                    return status_t::unexpected_type{ { errors::ParseError, contentEx.error().info } };
+                }
+
+                vars = toml::parse(contentEx.value(), varsPath.string());
+            }
+            else {
+                std::error_code ec;
+
+                if (! fs::exists(varsPath, ec)) {
+                    return {};
+                }
+
+                vars = toml::parse_file(varsPath.string());
+            }
+        }
+        catch (const toml::parse_error &err) {
+            return status_t::unexpected_type{ {
+                errors::ParseError,
+                fmt::format("Couldn't parse '{}': {}", varsPath.string(), err.description())
+            } };
+        }
 
         for (const auto &[key, value] : vars) {
-            const std::string k{ key.str() };
+            const std::string_view k{ key.str() };
 
             value.visit([&](auto &&v) {
                 if constexpr (toml::is_string<decltype(v)>) {
-                    m_DefaultVars[k] = v.template value_or<std::string>("");
+                    m_FileVars.set(k, v.template value_or<std::string>(""));
                 }
                 else if constexpr (toml::is_integer<decltype(v)>) {
-                    m_DefaultVars[k] = std::to_string(v.template value_or<int64_t>(0));
+                    m_FileVars.set(k, std::to_string(v.template value_or<int64_t>(0)));
                 }
                 else if constexpr (toml::is_floating_point<decltype(v)>) {
-                    m_DefaultVars[k] = std::to_string(v.template value_or<double>(0.0));
+                    m_FileVars.set(k, std::to_string(v.template value_or<double>(0.0)));
                 }
             });
         }
+
+        return {};
     }
 
     std::string_view generator_template::getName() const {
@@ -148,6 +275,10 @@ namespace arti {
         return m_Location;
     }
 
+    bool generator_template::isPacked() const {
+        return m_Pack != nullptr;
+    }
+
     generator_template::generator_template(types type, bool nameParamOptional, fs::path path,std::string name, std::string root)
         : m_Type(type)
         , m_NameParamOptional(nameParamOptional)
@@ -1,5 +1,7 @@
 #include "options_parser.hpp"
 
+#include "utils/io.hpp"
+
 namespace arti {
 
     options_parser::options_parser()
@@ -10,7 +12,30 @@ namespace arti {
         optionsDef("interactive,i", "Runs program on CLI interactive mode");
         optionsDef("template,t", opt::value<std::string>(), "Specifies the template to use");
         optionsDef("define,d", opt::value<std::vector<std::string>>()->multitoken(), "Variable definition for template substitution");
-        optionsDef("name,n", opt::value<std::string>(), "Specifies the name of the project or file to be generated");
+        optionsDef("name,n", opt::value<std::vector<std::string>>()->multitoken(), "Specifies the name of the project or file to be generated, several names generate a batch");
+        optionsDef("batch,b", opt::value<std::string>(), "Generates every instance listed on a TOML or JSONL manifest");
+        optionsDef("pack", opt::value<std::string>(), "Packs the given template into a single indexed file under the config folder, used instead of its folder from then on");
+        optionsDef("render", opt::value<std::string>(), "Renders a single file, '-' for stdin, to stdout through fixed size buffers whatever its size; '--template' adds its variables, '{% %}' tags aren't run");
+        optionsDef("no-cache", "Neither reads nor writes the compiled template cache");
+        optionsDef("rebuild-cache", "Ignores the compiled template cache and writes a fresh one");
+        optionsDef("update,u", "Generates over existing output, only rewriting the files whose rendered content changed");
+        optionsDef("watch,w", "Generates, then watches the template's folder and regenerates on every change, only rewriting the output files whose content changed");
+        optionsDef("manifest", "Records the generated files so a later '--update' doesn't need to read unchanged ones");
+        optionsDef("dry-run", "Prints every path a run would create, replace or skip and any conflict as JSON, without writing anything");
+        optionsDef("plan", "Same as '--dry-run'");
+        optionsDef("tar", opt::value<std::string>(), "Streams the output as a tar archive into the given file, '-' for stdout, instead of writing it to disk");
+        optionsDef("zstd", opt::value<int>()->implicit_value(3), "Compresses the '--tar' archive or the '--pack' entries with zstd at the given level (3 by default)");
+        optionsDef("jobs,j", opt::value<std::size_t>(), "Number of threads used to generate folder templates (0 uses all cores)");
+        optionsDef("io", opt::value<std::string>()->notifier([](const std::string &value) {
+            if (! utils::io_backend::parse(value)) {
+                throw opt::validation_error{ opt::validation_error::invalid_option_value, "io", value };
+            }
+        }), "File I/O backend: 'uring' batches every operation, 'sync' writes a file at a time honouring '--jobs', 'auto' (default) picks");
+        optionsDef("stats", "Prints timings per phase, I/O and syscall counters after generating");
+        optionsDef("trace", opt::value<std::string>(), "Writes a Chrome/Perfetto trace of the run, with a span per generated file");
+        optionsDef("serve", "Runs as a daemon keeping templates loaded, serving requests over a Unix socket");
+        optionsDef("client,c", "Forwards the command line to a running daemon instead of running it here");
+        optionsDef("socket", opt::value<std::string>(), "Unix socket used by '--serve' and '--client'");
         optionsDef("help,h", "Prints this help message");
     }
 
@@ -0,0 +1,86 @@
+#include "output_manifest.hpp"
+
+#include <fmt/format.h>
+
+#include "utils/file.hpp"
+#include "utils/hash.hpp"
+#include "utils/binary.hpp"
+
+namespace arti {
+
+    namespace {
+        constexpr std::string_view Magic = "arti-gen-manifest";
+        constexpr uint64_t FormatVersion = 1;
+    }
+
+    output_manifest output_manifest::load(const fs::path &directory, const fs::path &output) {
+        output_manifest manifest;
+
+        auto fileEx = utils::mapped_file::open(location(directory, output));
+
+        if (! fileEx) {
+            return manifest;
+        }
+
+        utils::binary_reader in{ fileEx->view() };
+
+        if (in.str() != Magic || in.u64() != FormatVersion) {
+            return manifest;
+        }
+
+        const auto count = in.u64();
+
+        for (uint64_t i = 0; i < count && ! in.failed(); ++i) {
+            const auto path = in.str();
+
+            entry value;
+            value.size = in.u64();
+            value.mtime = static_cast<int64_t>(in.u64());
+            value.hash = in.u64();
+
+            manifest.m_Entries[std::string{ path }] = value;
+        }
+
+        if (in.failed()) {
+            return output_manifest{};
+        }
+
+        return manifest;
+    }
+
+    bool output_manifest::save(const fs::path &directory, const fs::path &output) const {
+        utils::binary_writer out;
+
+        out.str(Magic);
+        out.u64(FormatVersion);
+        out.u64(m_Entries.size());
+
+        for (const auto &[path, value] : m_Entries) {
+            out.str(path);
+            out.u64(value.size);
+            out.u64(static_cast<uint64_t>(value.mtime));
+            out.u64(value.hash);
+        }
+
+        const auto manifestFile = location(directory, output);
+
+        return utils::replaceFile(manifestFile, { out.buffer() }, 0644).has_value();
+    }
+
+    const output_manifest::entry *output_manifest::find(const std::string &path) const {
+        if (auto it = m_Entries.find(path); it != m_Entries.end()) {
+            return &it->second;
+        }
+
+        return nullptr;
+    }
+
+    void output_manifest::set(std::string path, entry value) {
+        m_Entries[std::move(path)] = value;
+    }
+
+    fs::path output_manifest::location(const fs::path &directory, const fs::path &output) {
+        return directory / fmt::format("manifest-{:016x}.bin", utils::hash(output.lexically_normal().native()));
+    }
+
+}
@@ -0,0 +1,212 @@
+#include "server.hpp"
+
+#include <chrono>
+#include <csignal>
+#include <exception>
+#include <cstring>
+#include <vector>
+
+#include <unistd.h>
+#include <sys/un.h>
+
+#include <fmt/format.h>
+
+#include "utils/binary.hpp"
+#include "utils/thread_pool.hpp"
+
+namespace arti {
+
+    namespace {
+        // Requests carry a handful of arguments, anything past this is garbage
+        constexpr uint64_t MaxArguments = 4096;
+        constexpr uint64_t MaxVariables = 65536;
+
+        // A client sends its request right after connecting and reads its output as it comes,
+        // one that stalls past this gives its worker back instead of holding it forever
+        constexpr std::chrono::seconds ConnectionTimeout{ 10 };
+
+        char s_SocketPath[sizeof(sockaddr_un::sun_path)];
+
+        void removeSocketAndExit(int signal) {
+            ::unlink(s_SocketPath);
+            ::_exit(128 + signal);
+        }
+
+        std::string outputFrame(std::string_view text) {
+            utils::binary_writer out;
+
+            out.u64(static_cast<uint64_t>(server::frames::Output));
+            out.str(text);
+
+            return out.buffer();
+        }
+
+        std::string exitFrame(int code) {
+            utils::binary_writer out;
+
+            out.u64(static_cast<uint64_t>(server::frames::Exit));
+            out.u64(static_cast<uint64_t>(code));
+
+            return out.buffer();
+        }
+    }
+
+    server::server(fs::path socketPath)
+        : m_SocketPath(std::move(socketPath)) {
+    }
+
+    tl::expected<void, std::string> server::serve() {
+        auto listenerEx = utils::unix_socket::listen(m_SocketPath);
+
+        if (! listenerEx) {
+            auto [errorCode, errorInfo] = std::move(listenerEx).error();
+
+            return tl::unexpected<std::string>{ fmt::format("Couldn't start the daemon: {}", errorInfo) };
+        }
+
+        auto listener = std::move(listenerEx).value();
+
+        std::strncpy(s_SocketPath, m_SocketPath.c_str(), sizeof(s_SocketPath) - 1);
+        std::signal(SIGINT, removeSocketAndExit);
+        std::signal(SIGTERM, removeSocketAndExit);
+        std::signal(SIGPIPE, SIG_IGN);
+
+        fmt::print("Serving on '{}'\n", m_SocketPath.string());
+        std::fflush(stdout);
+
+        utils::thread_pool pool{ utils::thread_pool::defaultConcurrency() };
+
+        for (;;) {
+            auto connectionEx = listener.accept();
+
+            if (! connectionEx) {
+                continue;
+            }
+
+            auto connection = std::make_shared<utils::unix_socket>(std::move(connectionEx).value());
+
+            if (! connection->setTimeout(ConnectionTimeout)) {
+                continue;
+            }
+
+            pool.submit([this, connection] {
+                handle(*connection);
+            });
+        }
+    }
+
+    void server::handle(const utils::unix_socket &connection) {
+        auto request = connection.receiveFrame();
+
+        if (! request) {
+            return;
+        }
+
+        utils::binary_reader in{ *request };
+
+        const fs::path cwd{ in.str() };
+        const auto argumentCount = in.u64();
+
+        if (in.failed() || argumentCount > MaxArguments || ! cwd.is_absolute()) {
+            return;
+        }
+
+        std::vector<std::string> arguments{ "arti-gen" };
+
+        for (uint64_t i = 0; i < argumentCount; ++i) {
+            arguments.emplace_back(in.str());
+        }
+
+        const auto variableCount = in.u64();
+
+        if (in.failed() || variableCount > MaxVariables) {
+            return;
+        }
+
+        auto environment = std::make_shared<builtin_providers::environment_t>();
+
+        for (uint64_t i = 0; i < variableCount; ++i) {
+            const auto variable = in.str();
+            const auto equals = variable.find('=');
+
+            if (equals != std::string_view::npos) {
+                environment->try_emplace(std::string{ variable.substr(0, equals) }, variable.substr(equals + 1));
+            }
+        }
+
+        if (in.failed()) {
+            return;
+        }
+
+        std::vector<char *> argv;
+        argv.reserve(arguments.size() + 1);
+
+        for (auto &argument : arguments) {
+            argv.push_back(argument.data());
+        }
+
+        argv.push_back(nullptr);
+
+        const command::context ctx{
+            cwd,
+            [this](std::string_view name, template_cache::modes mode) {
+                return load(name, mode);
+            },
+            [&](std::string_view text) {
+                connection.sendFrame(outputFrame(text));
+            },
+            true,
+            std::move(environment)
+        };
+
+        // A single request failing never takes the daemon, or any other client's request, with it
+        int code = 1;
+
+        try {
+            code = command::run(static_cast<int>(arguments.size()), argv.data(), ctx);
+        }
+        catch (const std::exception &e) {
+            connection.sendFrame(outputFrame(fmt::format("The request failed: {}\n", e.what())));
+        }
+        catch (...) {
+            connection.sendFrame(outputFrame("The request failed\n"));
+        }
+
+        connection.sendFrame(exitFrame(code));
+    }
+
+    tl::expected<command::loaded_ptr, std::string> server::load(std::string_view name, template_cache::modes mode) {
+        if (mode == template_cache::modes::Enabled) {
+            command::loaded_ptr loaded;
+
+            {
+                std::lock_guard lock{ m_Mutex };
+
+                if (auto it = m_Templates.find(std::string{ name }); it != m_Templates.end()) {
+                    loaded = it->second;
+                }
+            }
+
+            // Revalidated on every request, only stats unless something was touched
+            if (loaded && template_cache::fresh(*loaded)) {
+                return loaded;
+            }
+        }
+
+        auto loadedEx = template_cache::load(name, mode);
+
+        if (! loadedEx) {
+            return tl::unexpected<std::string>{ std::move(loadedEx).error() };
+        }
+
+        auto loaded = std::make_shared<const template_cache::loaded_t>(std::move(loadedEx).value());
+
+        if (mode != template_cache::modes::Disabled) {
+            std::lock_guard lock{ m_Mutex };
+            m_Templates[std::string{ name }] = loaded;
+        }
+
+        return loaded;
+    }
+
+}
@@ -0,0 +1,256 @@
+#include "stream_renderer.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <algorithm>
+#include <string_view>
+
+#include <unistd.h>
+
+#include "compiled_template.hpp"
+
+#include "utils/scan.hpp"
+#include "utils/trace.hpp"
+
+namespace arti {
+
+    namespace {
+        using counters = utils::trace::counters;
+
+        constexpr auto npos = std::string_view::npos;
+
+        // Gathers small writes into a single one, text as big as the buffer goes straight through
+        class output_buffer {
+          public:
+            explicit output_buffer(int fd)
+                : m_Fd{ fd }, m_Buffer{ std::make_unique<char[]>(stream_renderer::BufferSize) } {}
+
+            bool append(std::string_view text) {
+                if (m_Used + text.size() > stream_renderer::BufferSize && ! flush()) {
+                    return false;
+                }
+
+                if (text.size() >= stream_renderer::BufferSize) {
+                    return writeAll(text);
+                }
+
+                std::memcpy(m_Buffer.get() + m_Used, text.data(), text.size());
+                m_Used += text.size();
+
+                return true;
+            }
+
+            bool flush() {
+                const auto used = std::exchange(m_Used, 0);
+
+                return writeAll({ m_Buffer.get(), used });
+            }
+
+            uint64_t written() const {
+                return m_Written;
+            }
+
+            int error() const {
+                return m_Error;
+            }
+
+          private:
+            bool writeAll(std::string_view text) {
+                while (! text.empty()) {
+                    const auto n = ::write(m_Fd, text.data(), text.size());
+                    utils::trace::add(counters::WriteCalls);
+
+                    if (n < 0 && errno == EINTR) {
+                        continue;
+                    }
+
+                    if (n < 0) {
+                        m_Error = errno;
+                        return false;
+                    }
+
+                    utils::trace::add(counters::BytesWritten, static_cast<uint64_t>(n));
+
+                    m_Written += static_cast<uint64_t>(n);
+                    text.remove_prefix(static_cast<std::size_t>(n));
+                }
+
+                return true;
+            }
+
+            int m_Fd;
+            std::unique_ptr<char[]> m_Buffer;
+            std::size_t m_Used = 0;
+            uint64_t m_Written = 0;
+            int m_Error = 0;
+        };
+    }
+
+    stream_renderer::expected_t stream_renderer::run(int input, int output, const variable_store &vars, builtin_providers &builtins) {
+        using error_t = expected_t::unexpected_type;
+
+        report result;
+        output_buffer out{ output };
+
+        // The unread input is always '[begin, end)' of 'buffer', 'scan' is where to look for '{{' in it
+        auto buffer = std::make_unique<char[]>(BufferSize);
+        std::size_t begin = 0;
+        std::size_t end = 0;
+        std::size_t scan = 0;
+        bool eof = false;
+        int readError = 0;
+
+        std::string scratch;
+
+        // Moves the unread input to the front and reads once after it
+        const auto fill = [&] {
+            if (begin > 0) {
+                std::memmove(buffer.get(), buffer.get() + begin, end - begin);
+                end -= begin;
+                begin = 0;
+            }
+
+            while (true) {
+                const auto n = ::read(input, buffer.get() + end, BufferSize - end);
+                utils::trace::add(counters::ReadCalls);
+
+                if (n < 0 && errno == EINTR) {
+                    continue;
+                }
+
+                if (n < 0) {
+                    readError = errno;
+                    return false;
+                }
+
+                eof = n == 0;
+                end += static_cast<std::size_t>(n);
+                result.bytesRead += static_cast<uint64_t>(n);
+                utils::trace::add(counters::BytesRead, static_cast<uint64_t>(n));
+
+                return true;
+            }
+        };
+
+        // Writes the next 'length' bytes of input as they are
+        const auto emit = [&](std::size_t length) {
+            const bool written = out.append({ buffer.get() + begin, length });
+            begin += length;
+
+            return written;
+        };
+
+        const auto writeFailed = [&] {
+            return error_t{ { errors::UnableToWrite, std::strerror(out.error()) } };
+        };
+
+        const auto remember = [&](std::string_view name) {
+            if (result.undefined.size() < MaxUndefined && std::find(result.undefined.begin(), result.undefined.end(), name) == result.undefined.end()) {
+                result.undefined.emplace_back(name);
+            }
+        };
+
+        while (true) {
+            const std::string_view src{ buffer.get() + begin, end - begin };
+            const auto pos = utils::scanner::findOpening(src, scan);
+
+            if (pos == npos) {
+                // A trailing '{' or '\' may still open, or escape, a placeholder with the next read
+                std::size_t keep = 0;
+
+                if (! eof && ! src.empty() && (src.back() == '{' || src.back() == '\\')) {
+                    keep = src.size() > 1 && src.back() == '{' && src[src.size() - 2] == '\\' ? 2 : 1;
+                }
+
+                if (! emit(src.size() - keep)) {
+                    return writeFailed();
+                }
+
+                scan = 0;
+
+                if (eof) {
+                    break;
+                }
+
+                if (! fill()) {
+                    return error_t{ { errors::UnableToRead, std::strerror(readError) } };
+                }
+
+                continue;
+            }
+
+            // '\{{' and '\{%' are written as a literal '{{' and '{%', like compiled_template does
+            if (pos > 0 && src[pos - 1] == '\\') {
+                if (! emit(pos - 1)) {
+                    return writeFailed();
+                }
+
+                ++begin;
+                scan = 2;
+                continue;
+            }
+
+            if (! emit(pos)) {
+                return writeFailed();
+            }
+
+            // A placeholder never spans lines, its whole line is read first unless it fills the buffer
+            const std::string_view rest{ buffer.get() + begin, end - begin };
+            const auto lineEnd = rest.find('\n');
+
+            if (lineEnd == npos && ! eof && rest.size() < BufferSize) {
+                if (! fill()) {
+                    return error_t{ { errors::UnableToRead, std::strerror(readError) } };
+                }
+
+                scan = 0;
+                continue;
+            }
+
+            const auto line = rest.substr(0, lineEnd);
+
+            if (line[1] == '%') {
+                result.tags = result.tags || line.find("%}", 2) != npos;
+                scan = 1;
+                continue;
+            }
+
+            auto match = compiled_template::matchPlaceholder(line, 0);
+
+            if (! match) {
+                scan = 1;
+                continue;
+            }
+
+            auto value = vars.get(match->chain.variable());
+
+            if (! value) {
+                value = builtins.get(match->chain.variable());
+            }
+
+            if (! value && ! match->chain.hasDefault()) {
+                remember(match->chain.variable());
+            }
+
+            scratch.clear();
+            match->chain.apply(value.value_or(std::string_view{}), scratch);
+
+            if (! out.append(scratch)) {
+                return writeFailed();
+            }
+
+            begin += match->end;
+            scan = 0;
+        }
+
+        if (! out.flush()) {
+            return writeFailed();
+        }
+
+        result.bytesWritten = out.written();
+
+        return result;
+    }
+
+}
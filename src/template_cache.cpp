@@ -0,0 +1,541 @@
+#include "template_cache.hpp"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <fmt/format.h>
+
+#include "template_pack.hpp"
+#include "template_registry.hpp"
+
+#include "internal/config.hpp"
+
+#include "utils/file.hpp"
+#include "utils/hash.hpp"
+#include "utils/trace.hpp"
+#include "utils/binary.hpp"
+
+namespace arti {
+
+    namespace {
+        constexpr std::string_view Magic = "ARTICACH";
+        constexpr uint64_t FormatVersion = 8;
+
+        enum class dependency_kinds : uint64_t {
+            File,
+            Directory,
+            Missing,
+            // 'path' holds a template name, 'hash' the hash of its config section
+            ConfigSection
+        };
+
+        struct dependency {
+            std::string path;
+            dependency_kinds kind;
+            int64_t mtime = 0;
+            uint64_t size = 0;
+            uint64_t hash = 0;
+        };
+
+        dependency fileDependency(const fs::path &path, std::string_view content) {
+            dependency dep{ path.string(), dependency_kinds::File };
+
+            if (auto st = utils::statOf(dep.path)) {
+                dep.mtime = utils::mtimeOf(*st);
+                dep.size = st->st_size;
+            }
+
+            dep.hash = utils::hash(content);
+
+            return dep;
+        }
+
+        dependency pathDependency(const fs::path &path) {
+            dependency dep{ path.string(), dependency_kinds::Missing };
+
+            auto st = utils::statOf(dep.path);
+
+            if (! st) {
+                return dep;
+            }
+
+            if (S_ISDIR(st->st_mode)) {
+                dep.kind = dependency_kinds::Directory;
+                dep.mtime = utils::mtimeOf(*st);
+                return dep;
+            }
+
+            auto file = utils::mapped_file::open(path);
+
+            return fileDependency(path, file ? file->view() : std::string_view{});
+        }
+
+        std::optional<dependency> sectionDependency(std::string_view name) {
+            auto registry = template_registry::open(arti::config::config_path);
+
+            if (! registry) {
+                return std::nullopt;
+            }
+
+            auto section = registry->section(name);
+
+            if (! section) {
+                return std::nullopt;
+            }
+
+            return dependency{ std::string{ name }, dependency_kinds::ConfigSection, 0, 0, utils::hash(section.value()) };
+        }
+
+        // 'touched' is set when the file changed its mtime but not its content
+        bool dependencyValid(const dependency &dep, bool &touched) {
+            if (dep.kind == dependency_kinds::ConfigSection) {
+                auto current = sectionDependency(dep.path);
+
+                return current && current->hash == dep.hash;
+            }
+
+            auto st = utils::statOf(dep.path);
+
+            switch (dep.kind) {
+                case dependency_kinds::Missing:
+                    return ! st && errno == ENOENT;
+                case dependency_kinds::Directory:
+                    return st && S_ISDIR(st->st_mode) && utils::mtimeOf(*st) == dep.mtime;
+                case dependency_kinds::File:
+                case dependency_kinds::ConfigSection:
+                    break;
+            }
+
+            if (! st || ! S_ISREG(st->st_mode) || static_cast<uint64_t>(st->st_size) != dep.size) {
+                return false;
+            }
+
+            if (utils::mtimeOf(*st) == dep.mtime) {
+                return true;
+            }
+
+            auto file = utils::mapped_file::open(dep.path);
+
+            if (! file || utils::hash(file->view()) != dep.hash) {
+                return false;
+            }
+
+            touched = true;
+
+            return true;
+        }
+
+        bool dependenciesValid(std::string_view encoded, bool &touched) {
+            utils::binary_reader in{ encoded };
+
+            const auto count = in.u64();
+
+            if (in.failed() || count == 0) {
+                return false;
+            }
+
+            for (uint64_t i = 0; i < count; ++i) {
+                dependency dep;
+                dep.path = in.str();
+                dep.kind = static_cast<dependency_kinds>(in.u64());
+                dep.mtime = static_cast<int64_t>(in.u64());
+                dep.size = in.u64();
+                dep.hash = in.u64();
+
+                if (in.failed() || ! dependencyValid(dep, touched)) {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        std::string encode(const std::vector<dependency> &dependencies) {
+            utils::binary_writer out;
+
+            out.u64(dependencies.size());
+
+            for (const auto &dep : dependencies) {
+                out.str(dep.path);
+                out.u64(static_cast<uint64_t>(dep.kind));
+                out.u64(static_cast<uint64_t>(dep.mtime));
+                out.u64(dep.size);
+                out.u64(dep.hash);
+            }
+
+            return out.buffer();
+        }
+
+        std::string cacheFileName(std::string_view name) {
+            std::string safe;
+
+            for (const char c : name) {
+                const bool plain = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '-' || c == '_';
+                safe += plain ? c : '_';
+            }
+
+            return fmt::format("{}-{:016x}.bin", safe, utils::hash(name));
+        }
+    }
+
+    std::optional<fs::path> template_cache::directory() {
+        std::vector<fs::path> candidates{ fs::path{ arti::config::config_path } / ".cache" };
+
+        if (const char *xdg = std::getenv("XDG_CACHE_HOME"); xdg && *xdg) {
+            candidates.push_back(fs::path{ xdg } / "arti-gen");
+        }
+        else if (const char *home = std::getenv("HOME"); home && *home) {
+            candidates.push_back(fs::path{ home } / ".cache" / "arti-gen");
+        }
+
+        for (const auto &candidate : candidates) {
+            std::error_code ec;
+            fs::create_directories(candidate, ec);
+
+            if (! ec && ::access(candidate.c_str(), W_OK | X_OK) == 0) {
+                return candidate;
+            }
+        }
+
+        return std::nullopt;
+    }
+
+    std::optional<std::string> template_cache::encodeDependencies(std::string_view name, const generator_template &template_v, const template_program &program) {
+        std::vector<dependency> dependencies;
+
+        // Only this template's own tables, editing another template keeps the entry valid
+        auto section = sectionDependency(name);
+
+        if (! section) {
+            return std::nullopt;
+        }
+
+        dependencies.push_back(std::move(*section));
+        // Packing the template later takes over from this entry
+        dependencies.push_back(pathDependency(template_pack::location(arti::config::config_path, name)));
+        dependencies.push_back(pathDependency(template_v.m_Location / "vars.toml"));
+
+        if (program.type() == generator_template::types::Folder) {
+            dependencies.push_back(pathDependency(template_v.m_Location / template_v.m_TemplateRoot));
+        }
+
+        for (const auto &current : program.entries()) {
+            // Passthrough files have no compiled content, their hash comes from a fresh read
+            if (current.directory || current.passthrough) {
+                dependencies.push_back(pathDependency(current.templatePath));
+            }
+            else {
+                dependencies.push_back(fileDependency(current.templatePath, current.content.source()));
+            }
+        }
+
+        return encode(dependencies);
+    }
+
+
+    template_cache::expected_t template_cache::load(std::string_view name, modes mode) {
+        using error_t = expected_t::unexpected_type;
+        using span = utils::trace::span;
+
+        // A pack is already mapped and indexed, it's never cached again
+        if (const auto packPath = template_pack::location(arti::config::config_path, name); utils::statOf(packPath)) {
+            return loadPack(packPath);
+        }
+
+        const auto cacheDir = mode == modes::Disabled ? std::nullopt : directory();
+        const auto cacheFile = cacheDir ? std::optional{ *cacheDir / cacheFileName(name) } : std::nullopt;
+
+        if (cacheFile && mode == modes::Enabled) {
+            bool refresh = false;
+
+            auto cached = [&] {
+                const span phase{ span::kinds::Phase, "cache read" };
+
+                return read(*cacheFile, refresh);
+            }();
+
+            if (cached) {
+                if (refresh) {
+                    cached->dependencies = encodeDependencies(name, cached->template_v, cached->program).value_or("");
+                    write(*cacheFile, *cached);
+                }
+
+                return std::move(*cached);
+            }
+        }
+
+        auto templateEx = generator_template::loadFromConfig(name);
+
+        if (! templateEx) {
+            auto [errorCode, errorInfo] = std::move(templateEx).error();
+
+            return error_t{ std::move(errorInfo) };
+        }
+
+        auto template_v = std::move(templateEx).value();
+
+        auto programEx = [&] {
+            const span phase{ span::kinds::Phase, "template walk" };
+
+            return template_program::compile(template_v);
+        }();
+
+        if (! programEx) {
+            return error_t{ std::move(programEx).error() };
+        }
+
+        auto dependencies = [&] {
+            const span phase{ span::kinds::Phase, "dependency hashing" };
+
+            return encodeDependencies(name, template_v, programEx.value()).value_or("");
+        }();
+
+        loaded_t loaded{ std::move(template_v), std::move(programEx).value(), false, std::move(dependencies) };
+
+        if (cacheFile) {
+            const span phase{ span::kinds::Phase, "cache write" };
+
+            write(*cacheFile, loaded);
+        }
+
+        return std::move(loaded);
+    }
+
+    template_cache::expected_t template_cache::loadPack(const fs::path &packPath) {
+        using error_t = expected_t::unexpected_type;
+        using span = utils::trace::span;
+
+        auto templateEx = generator_template::loadFromPack(packPath, arti::config::config_path);
+
+        if (! templateEx) {
+            auto [errorCode, errorInfo] = std::move(templateEx).error();
+
+            return error_t{ std::move(errorInfo) };
+        }
+
+        auto template_v = std::move(templateEx).value();
+
+        auto programEx = [&] {
+            const span phase{ span::kinds::Phase, "template walk" };
+
+            return template_program::compile(template_v);
+        }();
+
+        if (! programEx) {
+            return error_t{ std::move(programEx).error() };
+        }
+
+        // Everything comes from the pack, it's the only dependency
+        auto dependencies = encode({ pathDependency(packPath) });
+
+        return loaded_t{ std::move(template_v), std::move(programEx).value(), false, std::move(dependencies) };
+    }
+
+    bool template_cache::fresh(const loaded_t &loaded) {
+        bool touched = false;
+
+        return dependenciesValid(loaded.dependencies, touched);
+    }
+
+    std::optional<template_cache::loaded_t> template_cache::read(const fs::path &cacheFile, bool &refresh) {
+        using types = generator_template::types;
+        using segment = compiled_template::segment;
+
+        auto fileEx = utils::mapped_file::open(cacheFile);
+
+        if (! fileEx) {
+            return std::nullopt;
+        }
+
+        // Every compiled content references the mapping, it stays alive with the program
+        auto mapping = std::make_shared<const utils::mapped_file>(std::move(fileEx).value());
+
+        utils::binary_reader in{ mapping->view() };
+
+        if (in.str() != Magic || in.u64() != FormatVersion) {
+            return std::nullopt;
+        }
+
+        const auto dependencies = in.str();
+
+        if (in.failed() || ! dependenciesValid(dependencies, refresh)) {
+            return std::nullopt;
+        }
+
+        const auto rawType = in.u64();
+        const bool nameParamOptional = in.u64() != 0;
+        const auto location = in.str();
+        const auto templateName = in.str();
+        const auto root = in.str();
+
+        // Only File and Folder programs are compiled and cached
+        if (in.failed() || rawType >= static_cast<uint64_t>(types::Unknown)) {
+            return std::nullopt;
+        }
+
+        const auto type = static_cast<types>(rawType);
+
+        generator_template template_v{ type, nameParamOptional, fs::path{ location }, std::string{ templateName }, std::string{ root } };
+
+        const auto varCount = in.u64();
+
+        for (uint64_t i = 0; i < varCount && ! in.failed(); ++i) {
+            const auto key = in.str();
+            const auto value = in.str();
+
+            template_v.m_FileVars.set(key, value);
+        }
+
+        template_program program;
+        program.m_Type = type;
+        program.m_Root = compiled_template::compile(template_v.m_TemplateRoot);
+
+        const auto entryCount = in.u64();
+
+        for (uint64_t i = 0; i < entryCount && ! in.failed(); ++i) {
+            template_program::entry current;
+            current.templatePath = fs::path{ in.str() };
+            current.parent = in.u64();
+            current.name = compiled_template::compile(std::string{ in.str() });
+            current.directory = in.u64() != 0;
+            current.mode = static_cast<mode_t>(in.u64());
+            current.passthrough = in.u64() != 0;
+
+            // Parents come first, anything else isn't a cache this wrote
+            if (current.parent != template_program::Root && (current.parent >= i || ! program.m_Entries[current.parent].directory)) {
+                return std::nullopt;
+            }
+
+            if (! current.directory && ! current.passthrough) {
+                const auto source = in.str();
+                const auto segmentCount = in.u64();
+
+                // A corrupted count shouldn't turn into a huge allocation, a segment takes 24 bytes
+                if (in.failed() || segmentCount > in.remaining() / 24) {
+                    return std::nullopt;
+                }
+
+                std::vector<segment> segments(segmentCount);
+
+                for (auto &seg : segments) {
+                    const auto kind = in.u64();
+                    seg.offset = in.u64();
+                    seg.length = in.u64();
+
+                    if (in.failed() || kind > static_cast<uint64_t>(segment::kinds::ForNext)) {
+                        return std::nullopt;
+                    }
+
+                    seg.kind = static_cast<segment::kinds>(kind);
+                }
+
+                const auto slotCount = in.u64();
+
+                // Every slot takes at least its 8 bytes of size
+                if (in.failed() || slotCount > in.remaining() / 8) {
+                    return std::nullopt;
+                }
+
+                std::vector<std::string> slots(slotCount);
+
+                for (auto &slot : slots) {
+                    slot = in.str();
+
+                    if (in.failed()) {
+                        return std::nullopt;
+                    }
+                }
+
+                auto content = compiled_template::fromSegments(source, std::move(segments), std::move(slots));
+
+                // Anything a compiler didn't write is compiled again from the template instead
+                if (! content) {
+                    return std::nullopt;
+                }
+
+                current.content = std::move(content).value();
+                current.source = mapping;
+            }
+
+            program.m_Entries.push_back(std::move(current));
+        }
+
+        if (in.failed()) {
+            return std::nullopt;
+        }
+
+        // Generating a file reads its one entry, a truncated cache mustn't leave none
+        if (type == types::File && (program.m_Entries.size() != 1 || program.m_Entries.front().directory)) {
+            return std::nullopt;
+        }
+
+        return loaded_t{ std::move(template_v), std::move(program), true, std::string{ dependencies } };
+    }
+
+    bool template_cache::write(const fs::path &cacheFile, const loaded_t &loaded) {
+        const auto &template_v = loaded.template_v;
+        const auto &program = loaded.program;
+
+        if (loaded.dependencies.empty()) {
+            return false;
+        }
+
+        utils::binary_writer out;
+
+        out.str(Magic);
+        out.u64(FormatVersion);
+        out.str(loaded.dependencies);
+
+        out.u64(static_cast<uint64_t>(template_v.m_Type));
+        out.u64(template_v.m_NameParamOptional ? 1 : 0);
+        out.str(template_v.m_Location.string());
+        out.str(template_v.m_Name);
+        out.str(template_v.m_TemplateRoot);
+
+        // vars.toml values are only ever set, every id is defined
+        out.u64(template_v.m_FileVars.size());
+
+        template_v.m_FileVars.forEach([&](std::string_view k, std::string_view v) {
+            out.str(k);
+            out.str(v);
+        });
+
+        out.u64(program.entries().size());
+
+        for (const auto &current : program.entries()) {
+            out.str(current.templatePath.string());
+            out.u64(current.parent);
+            out.str(current.name.source());
+            out.u64(current.directory ? 1 : 0);
+            out.u64(current.mode);
+            out.u64(current.passthrough ? 1 : 0);
+
+            if (current.directory || current.passthrough) {
+                continue;
+            }
+
+            out.str(current.content.source());
+
+            out.u64(current.content.segments().size());
+
+            for (const auto &seg : current.content.segments()) {
+                out.u64(static_cast<uint64_t>(seg.kind));
+                out.u64(seg.offset);
+                out.u64(seg.length);
+            }
+
+            out.u64(current.content.slots().size());
+
+            for (const auto &slot : current.content.slots()) {
+                out.str(slot);
+            }
+        }
+
+        return utils::replaceFile(cacheFile, { out.buffer() }, 0644).has_value();
+    }
+
+}
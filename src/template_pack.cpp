@@ -0,0 +1,300 @@
+#include "template_pack.hpp"
+
+#include <cerrno>
+#include <limits>
+#include <cstring>
+#include <algorithm>
+
+#ifdef ARTI_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+#include <fmt/format.h>
+
+#include "generator_template.hpp"
+
+#include "utils/binary.hpp"
+
+namespace arti {
+
+    namespace {
+        constexpr std::string_view Magic = "ARTIPACK";
+        constexpr uint64_t FormatVersion = 1;
+
+        enum class compressions : uint64_t {
+            None,
+            Zstd
+        };
+
+        // Compressed copy of 'content', empty when it doesn't get any smaller
+        std::string compress([[maybe_unused]] std::string_view content, [[maybe_unused]] int level) {
+#ifdef ARTI_WITH_ZSTD
+            std::string compressed(ZSTD_compressBound(content.size()), '\0');
+
+            const auto size = ZSTD_compress(compressed.data(), compressed.size(), content.data(), content.size(), level);
+
+            if (ZSTD_isError(size) || size >= content.size()) {
+                return {};
+            }
+
+            compressed.resize(size);
+
+            return compressed;
+#else
+            return {};
+#endif
+        }
+
+        // A zstd block holds at most 128 KiB and takes at least a 3 byte header, no frame of
+        // 'stored' bytes inflates past this
+        uint64_t maxInflated(uint64_t stored) {
+            constexpr uint64_t MaxBlockContent = 128 * 1024;
+
+            return (stored / 3 + 1) * MaxBlockContent;
+        }
+    }
+
+    fs::path template_pack::location(const fs::path &configPath, std::string_view name) {
+        return configPath / "packs" / fmt::format("{}.artipack", name);
+    }
+
+    template_pack::expected_t template_pack::open(const fs::path &path) {
+        using error_t = expected_t::unexpected_type;
+
+        auto fileEx = utils::mapped_file::open(path);
+
+        if (! fileEx) {
+            return error_t{ { errors::NotFound, std::move(fileEx).error().info } };
+        }
+
+        auto pack = std::make_shared<template_pack>();
+        pack->m_Mapping = std::move(fileEx).value();
+
+        const auto invalid = [&] {
+            return error_t{ { errors::Invalid, fmt::format("'{}' isn't a valid template pack", path.string()) } };
+        };
+
+        utils::binary_reader in{ pack->m_Mapping.view() };
+
+        if (in.str() != Magic || in.u64() != FormatVersion) {
+            return invalid();
+        }
+
+        pack->m_Name = in.str();
+        pack->m_Config = in.str();
+
+        const auto count = in.u64();
+
+        for (uint64_t i = 0; i < count && ! in.failed(); ++i) {
+            entry current;
+            current.path = in.str();
+            current.directory = in.u64() != 0;
+            current.mode = static_cast<mode_t>(in.u64());
+
+            const auto compression = static_cast<compressions>(in.u64());
+
+            current.offset = in.u64();
+            current.size = in.u64();
+
+            // Checked below, once the data region is known
+            if (compression == compressions::Zstd) {
+                const auto inflated = in.u64();
+
+                if (inflated > static_cast<uint64_t>(std::numeric_limits<int64_t>::max())) {
+                    return invalid();
+                }
+
+                current.inflated = static_cast<int64_t>(inflated);
+            }
+            else if (compression != compressions::None) {
+                return invalid();
+            }
+
+            pack->m_Entries.push_back(std::move(current));
+        }
+
+        const auto data = in.str();
+
+        if (in.failed()) {
+            return invalid();
+        }
+
+        pack->m_DataOffset = data.data() - pack->m_Mapping.view().data();
+
+        for (auto &current : pack->m_Entries) {
+            if (current.offset > data.size() || current.size > data.size() - current.offset) {
+                return invalid();
+            }
+
+            if (current.inflated < 0) {
+                continue;
+            }
+
+#ifdef ARTI_WITH_ZSTD
+            const auto stored = data.substr(current.offset, current.size);
+            const auto size = static_cast<uint64_t>(current.inflated);
+
+            // Only inflated when read, the size it will allocate has to agree with the frame
+            if (ZSTD_getFrameContentSize(stored.data(), stored.size()) != size || size > maxInflated(stored.size())) {
+                return invalid();
+            }
+#else
+            return error_t{ { errors::Invalid, fmt::format("'{}' holds zstd compressed entries, this build can't read them", path.string()) } };
+#endif
+        }
+
+        pack->m_Inflated.resize(pack->m_Entries.size());
+
+        for (std::size_t i = 0; i < pack->m_Entries.size(); ++i) {
+            if (pack->m_Entries[i].inflated >= 0) {
+                pack->m_Inflated[i] = std::make_unique<inflated_entry>();
+            }
+        }
+
+        return std::shared_ptr<const template_pack>{ std::move(pack) };
+    }
+
+    template_pack::status_t template_pack::write(const fs::path &path, std::string_view name, const generator_template &template_v, std::string_view config, int level) {
+        using error_t = status_t::unexpected_type;
+        using types = generator_template::types;
+
+        const auto &location = template_v.m_Location;
+        const auto root = location / template_v.m_TemplateRoot;
+
+        std::vector<std::pair<fs::path, bool>> paths;
+
+        if (fs::exists(location / "vars.toml")) {
+            paths.emplace_back(location / "vars.toml", false);
+        }
+
+        if (template_v.m_Type == types::File) {
+            if (! fs::is_regular_file(root)) {
+                return error_t{ { errors::NotFound, "The template file provided does not exist" } };
+            }
+
+            paths.emplace_back(root, false);
+        }
+        else {
+            if (! fs::is_directory(root)) {
+                return error_t{ { errors::NotFound, "The template folder does not exist" } };
+            }
+
+            // Same walk as a folder template compiled from its directory, entries keep its order
+            for (const auto &dirEntry : fs::recursive_directory_iterator(root)) {
+                if (dirEntry.is_directory() || dirEntry.is_regular_file()) {
+                    paths.emplace_back(dirEntry.path(), dirEntry.is_directory());
+                }
+            }
+        }
+
+        utils::binary_writer index;
+        std::string data;
+
+        index.str(Magic);
+        index.u64(FormatVersion);
+        index.str(name);
+        index.str(config);
+        index.u64(paths.size());
+
+        for (const auto &[current, directory] : paths) {
+            index.str(current.lexically_relative(location).string());
+            index.u64(directory ? 1 : 0);
+
+            if (directory) {
+                index.u64(0755);
+                index.u64(static_cast<uint64_t>(compressions::None));
+                index.u64(data.size());
+                index.u64(0);
+                continue;
+            }
+
+            auto fileEx = utils::mapped_file::open(current);
+
+            if (! fileEx) {
+                return error_t{ { errors::NotFound, std::move(fileEx).error().info } };
+            }
+
+            const auto content = fileEx->view();
+            const auto compressed = level > 0 ? compress(content, level) : std::string{};
+            const auto stored = compressed.empty() ? content : std::string_view{ compressed };
+
+            index.u64(fileEx->mode());
+            index.u64(static_cast<uint64_t>(compressed.empty() ? compressions::None : compressions::Zstd));
+            index.u64(data.size());
+            index.u64(stored.size());
+
+            if (! compressed.empty()) {
+                index.u64(content.size());
+            }
+
+            data += stored;
+        }
+
+        index.str(data);
+
+        std::error_code ec;
+        fs::create_directories(path.parent_path(), ec);
+
+        // Renamed into place, a generation reading the old pack keeps its mapping
+        if (auto ex = utils::replaceFile(path, { index.buffer() }, 0644); ! ex) {
+            return error_t{ { errors::UnableToWrite, std::move(ex).error().info } };
+        }
+
+        return {};
+    }
+
+    std::string_view template_pack::name() const {
+        return m_Name;
+    }
+
+    std::string_view template_pack::config() const {
+        return m_Config;
+    }
+
+    const std::vector<template_pack::entry> &template_pack::entries() const {
+        return m_Entries;
+    }
+
+    const template_pack::entry *template_pack::find(std::string_view path) const {
+        const auto it = std::find_if(m_Entries.begin(), m_Entries.end(), [&](const entry &current) {
+            return current.path == path;
+        });
+
+        return it == m_Entries.end() ? nullptr : &*it;
+    }
+
+    template_pack::content_t template_pack::content(const entry &current) const {
+        const auto stored = m_Mapping.view().substr(m_DataOffset + current.offset, current.size);
+
+        if (current.inflated < 0) {
+            return stored;
+        }
+
+        // Generation reads entries from several threads, each one is inflated once
+        auto &inflated = *m_Inflated[&current - m_Entries.data()];
+
+        std::call_once(inflated.once, [&] {
+#ifdef ARTI_WITH_ZSTD
+            std::string content(static_cast<std::size_t>(current.inflated), '\0');
+
+            const auto size = ZSTD_decompress(content.data(), content.size(), stored.data(), stored.size());
+
+            if (! ZSTD_isError(size) && size == content.size()) {
+                inflated.content = std::move(content);
+                inflated.valid = true;
+            }
+#endif
+        });
+
+        if (! inflated.valid) {
+            return content_t::unexpected_type{ { errors::Invalid, fmt::format("'{}' of the template pack '{}' doesn't inflate", current.path, m_Name) } };
+        }
+
+        return std::string_view{ inflated.content };
+    }
+
+    const utils::mapped_file &template_pack::mapping() const {
+        return m_Mapping;
+    }
+
+}
@@ -0,0 +1,277 @@
+#include "template_program.hpp"
+
+#include <algorithm>
+
+#include <fmt/format.h>
+
+#include "template_pack.hpp"
+
+#include "utils/scan.hpp"
+
+namespace arti {
+
+    namespace {
+        // Same heuristic as git, a NUL byte early in the file means binary
+        constexpr std::size_t BinaryProbeSize = 8000;
+    }
+
+    template_program::expected_t template_program::compile(const generator_template &template_v) {
+        using error_t = expected_t::unexpected_type;
+
+        template_program program;
+        program.m_Type = template_v.m_Type;
+        program.m_Root = compiled_template::compile(template_v.m_TemplateRoot);
+
+        std::unordered_map<std::string, std::size_t> directories;
+
+        const auto loadFile = [&](const fs::path &templatePath, std::string_view relativePath) -> bool {
+            entry file;
+            file.templatePath = templatePath;
+
+            if (! load(file)) {
+                return false;
+            }
+
+            program.place(std::move(file), relativePath, directories);
+
+            return true;
+        };
+
+        if (template_v.m_Pack) {
+            return fromPack(template_v);
+        }
+
+        if (template_v.m_Type == types::File) {
+            const auto templateFile = template_v.m_Location / template_v.m_TemplateRoot;
+
+            if (! fs::exists(templateFile)) {
+                return error_t{ "The template file provided does not exist" };
+            }
+
+            if (! loadFile(templateFile, template_v.m_TemplateRoot)) {
+                return error_t{ "Couldn't open the template file provided" };
+            }
+
+            return std::move(program);
+        }
+
+        if (template_v.m_Type == types::Folder) {
+            const auto &basePath = template_v.m_Location;
+            const auto baseTemplatePath = basePath / template_v.m_TemplateRoot;
+
+            if (! fs::exists(baseTemplatePath)) {
+                return error_t{ "The template folder does not exist" };
+            }
+
+            for (const auto &dirEntry : fs::recursive_directory_iterator(baseTemplatePath)) {
+                const auto &tPath = dirEntry.path();
+                const auto relativePath = tPath.lexically_relative(basePath).string();
+
+                // Walked depth first, a directory always comes before what it holds
+                if (dirEntry.is_directory()) {
+                    entry dir;
+                    dir.templatePath = tPath;
+                    dir.directory = true;
+
+                    program.place(std::move(dir), relativePath, directories);
+                }
+                else if (dirEntry.is_regular_file()) {
+                    // Unreadable template files are left out, as generation always did
+                    loadFile(tPath, relativePath);
+                }
+                else {
+                    return error_t{ "Unrecognized or invalid file type provided on template" };
+                }
+            }
+
+            return std::move(program);
+        }
+
+        return error_t{ "Unexpected template type received" };
+    }
+
+    template_program::expected_t template_program::fromPack(const generator_template &template_v) {
+        using error_t = expected_t::unexpected_type;
+        using segment = compiled_template::segment;
+
+        const auto &pack = template_v.m_Pack;
+
+        template_program program;
+        program.m_Type = template_v.m_Type;
+        program.m_Root = compiled_template::compile(template_v.m_TemplateRoot);
+
+        // Shares the pack's ownership, so compiled views into it stay valid
+        const std::shared_ptr<const utils::mapped_file> mapping{ pack, &pack->mapping() };
+
+        const auto &rootPath = template_v.m_TemplateRoot;
+        bool found = false;
+
+        std::unordered_map<std::string, std::size_t> directories;
+
+        for (const auto &packed : pack->entries()) {
+            const std::string_view relativePath = packed.path;
+
+            if (relativePath == rootPath) {
+                found = true;
+
+                // A folder's root is created from 'root' itself, only what's below it is an entry
+                if (packed.directory) {
+                    continue;
+                }
+            }
+            else if (! relativePath.starts_with(rootPath) || relativePath.substr(rootPath.size(), 1) != "/") {
+                continue;
+            }
+
+            entry current;
+            current.templatePath = template_v.m_Location / packed.path;
+            current.directory = packed.directory;
+            current.mode = packed.mode;
+
+            if (! packed.directory) {
+                const auto contentEx = pack->content(packed);
+
+                if (! contentEx) {
+                    return error_t{ contentEx.error().info };
+                }
+
+                const auto content = contentEx.value();
+
+                // There's no file on disk to copy, binary content renders as a single literal instead
+                current.content = isBinary(content)
+                    ? *compiled_template::fromSegments(content, { { segment::kinds::Literal, 0, content.size() } }, {})
+                    : compiled_template::compileView(content);
+                current.source = mapping;
+            }
+
+            // Packed in walk order, parents first
+            program.place(std::move(current), relativePath, directories);
+        }
+
+        if (! found && template_v.m_Type == types::File) {
+            return error_t{ "The template file provided does not exist" };
+        }
+
+        return std::move(program);
+    }
+
+    bool template_program::reload(const fs::path &templatePath) {
+        const auto found = std::find_if(m_Entries.begin(), m_Entries.end(), [&](const entry &current) {
+            return ! current.directory && current.templatePath == templatePath;
+        });
+
+        if (found == m_Entries.end()) {
+            return false;
+        }
+
+        entry file;
+        file.templatePath = templatePath;
+
+        if (! load(file)) {
+            return false;
+        }
+
+        // Its place in the tree stays, only what it holds is new
+        found->mode = file.mode;
+        found->passthrough = file.passthrough;
+        found->content = std::move(file.content);
+        found->source = std::move(file.source);
+
+        return true;
+    }
+
+    bool template_program::load(entry &file) {
+        auto sourceEx = utils::mapped_file::open(file.templatePath);
+
+        if (! sourceEx) {
+            return false;
+        }
+
+        // The content is compiled as a view, the mapping must already be at its final address
+        auto source = std::make_shared<const utils::mapped_file>(std::move(sourceEx).value());
+
+        file.mode = source->mode();
+        file.passthrough = isPassthrough(source->view());
+
+        if (! file.passthrough) {
+            file.content = compiled_template::compileView(source->view());
+            file.source = std::move(source);
+        }
+
+        return true;
+    }
+
+    void template_program::place(entry current, std::string_view relativePath, std::unordered_map<std::string, std::size_t> &directories) {
+        // A file template's output name is its whole relative path
+        const auto slash = m_Type == types::Folder ? relativePath.rfind('/') : std::string_view::npos;
+
+        current.parent = Root;
+
+        // Right below the root, the root itself isn't an entry
+        if (slash != std::string_view::npos) {
+            if (auto it = directories.find(std::string{ relativePath.substr(0, slash) }); it != directories.end()) {
+                current.parent = it->second;
+            }
+        }
+
+        current.name = compiled_template::compile(std::string{ relativePath.substr(slash == std::string_view::npos ? 0 : slash + 1) });
+
+        if (current.directory) {
+            directories.emplace(relativePath, m_Entries.size());
+        }
+
+        m_Entries.push_back(std::move(current));
+    }
+
+    bool template_program::isBinary(std::string_view content) {
+        return content.substr(0, BinaryProbeSize).find('\0') != std::string_view::npos;
+    }
+
+    bool template_program::isPassthrough(std::string_view content) {
+        if (isBinary(content)) {
+            return true;
+        }
+
+        // Escaped '\{{' still needs rendering, only files without any '{{' or '{%' are copied
+        return utils::scanner::findOpening(content) == std::string_view::npos;
+    }
+
+    template_program::types template_program::type() const {
+        return m_Type;
+    }
+
+    const compiled_template &template_program::root() const {
+        return m_Root;
+    }
+
+    const std::vector<template_program::entry> &template_program::entries() const {
+        return m_Entries;
+    }
+
+    std::vector<std::string_view> template_program::references() const {
+        std::vector<std::string_view> names;
+
+        const auto collect = [&](const compiled_template &compiled) {
+            const auto &chains = compiled.chains();
+
+            for (std::size_t i = 0; i < chains.size(); ++i) {
+                if (! compiled.loopBound(i)) {
+                    names.push_back(chains[i].variable());
+                }
+            }
+        };
+
+        collect(m_Root);
+
+        for (const auto &current : m_Entries) {
+            collect(current.name);
+            collect(current.content);
+        }
+
+        std::sort(names.begin(), names.end());
+        names.erase(std::unique(names.begin(), names.end()), names.end());
+
+        return names;
+    }
+
+}
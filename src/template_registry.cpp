@@ -0,0 +1,508 @@
+#include "template_registry.hpp"
+
+#include <algorithm>
+
+#include <fmt/format.h>
+
+#include "template_cache.hpp"
+
+#include "utils/file.hpp"
+#include "utils/hash.hpp"
+#include "utils/binary.hpp"
+
+namespace arti {
+
+    namespace {
+        constexpr std::string_view IndexMagic = "ARTIREGI";
+        constexpr uint64_t IndexVersion = 2;
+
+        bool isBareKeyChar(char c) {
+            return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == '-';
+        }
+
+        // Skips a quoted string starting at 'pos', returns the position past its closing quote
+        std::size_t skipString(std::string_view line, std::size_t pos) {
+            const char quote = line[pos++];
+
+            while (pos < line.size() && line[pos] != quote) {
+                if (quote == '"' && line[pos] == '\\') {
+                    ++pos;
+                }
+
+                ++pos;
+            }
+
+            return std::min(pos + 1, line.size());
+        }
+
+        // The bare or quoted key starting at 'pos', which is moved past it. Empty if there's none.
+        std::string keyAt(std::string_view line, std::size_t &pos) {
+            std::string key;
+
+            if (line[pos] == '"' || line[pos] == '\'') {
+                const auto end = skipString(line, pos);
+
+                for (auto i = pos + 1; i + 1 < end; ++i) {
+                    if (line[pos] == '"' && line[i] == '\\' && i + 2 < end) {
+                        ++i;
+                    }
+
+                    key += line[i];
+                }
+
+                pos = end;
+            }
+            else {
+                const auto begin = pos;
+
+                while (pos < line.size() && isBareKeyChar(line[pos])) {
+                    ++pos;
+                }
+
+                key = line.substr(begin, pos - begin);
+            }
+
+            return key;
+        }
+
+        // First key of a '[a.b]' or '[[a.b]]' header line, empty if the line isn't a header
+        std::string headerKey(std::string_view line) {
+            std::size_t pos = line.find_first_not_of(" \t");
+
+            if (pos == std::string_view::npos || line[pos] != '[') {
+                return {};
+            }
+
+            const bool arrayHeader = line.compare(pos, 2, "[[") == 0;
+            pos = line.find_first_not_of(" \t", pos + (arrayHeader ? 2 : 1));
+
+            if (pos == std::string_view::npos) {
+                return {};
+            }
+
+            auto key = keyAt(line, pos);
+
+            if (key.empty()) {
+                return {};
+            }
+
+            // The rest of the key path must close the header, optionally followed by a comment
+            while (pos < line.size() && line[pos] != ']') {
+                if (line[pos] == '"' || line[pos] == '\'') {
+                    pos = skipString(line, pos);
+                }
+                else if (isBareKeyChar(line[pos]) || line[pos] == '.' || line[pos] == ' ' || line[pos] == '\t') {
+                    ++pos;
+                }
+                else {
+                    return {};
+                }
+            }
+
+            if (line.compare(pos, arrayHeader ? 2 : 1, arrayHeader ? "]]" : "]") != 0) {
+                return {};
+            }
+
+            pos = line.find_first_not_of(" \t\r", pos + (arrayHeader ? 2 : 1));
+
+            if (pos != std::string_view::npos && line[pos] != '#') {
+                return {};
+            }
+
+            return key;
+        }
+
+        // First key of a root level 'a.b = ...' or 'a = { ... }' line, which defines table 'a'.
+        // Empty for any other key, a plain value at the root isn't a template.
+        std::string rootTableKey(std::string_view line, std::size_t pos) {
+            auto key = keyAt(line, pos);
+            pos = line.find_first_not_of(" \t", pos);
+
+            if (key.empty() || pos == std::string_view::npos) {
+                return {};
+            }
+
+            if (line[pos] == '.') {
+                return key;
+            }
+
+            if (line[pos] != '=') {
+                return {};
+            }
+
+            pos = line.find_first_not_of(" \t", pos + 1);
+
+            return pos != std::string_view::npos && line[pos] == '{' ? key : std::string{};
+        }
+    }
+
+    template_registry::template_registry(fs::path configPath)
+        : m_ConfigPath(std::move(configPath)) {
+    }
+
+    template_registry::expected_t template_registry::open(const fs::path &configPath) {
+        using error_t = expected_t::unexpected_type;
+
+        template_registry registry{ configPath };
+
+        const auto mainConfig = configPath / "config.toml";
+        const auto fragments = configPath / "config.d";
+
+        std::vector<fs::path> paths;
+
+        if (fs::exists(mainConfig)) {
+            paths.push_back(mainConfig);
+        }
+
+        if (auto st = utils::statOf(fragments); st && S_ISDIR(st->st_mode)) {
+            registry.m_FragmentsMtime = utils::mtimeOf(*st);
+
+            std::vector<fs::path> fragmentPaths;
+            std::error_code ec;
+
+            for (const auto &entry : fs::directory_iterator(fragments, ec)) {
+                if (entry.path().extension() == ".toml" && entry.is_regular_file()) {
+                    fragmentPaths.push_back(entry.path());
+                }
+            }
+
+            std::sort(fragmentPaths.begin(), fragmentPaths.end());
+            paths.insert(paths.end(), fragmentPaths.begin(), fragmentPaths.end());
+        }
+
+        if (paths.empty()) {
+            return error_t{ { errors::ConfigNotFound, "User config not found" } };
+        }
+
+        for (auto &path : paths) {
+            source current{ std::move(path) };
+
+            if (auto st = utils::statOf(current.path)) {
+                current.mtime = utils::mtimeOf(*st);
+                current.size = st->st_size;
+            }
+
+            registry.m_Sources.push_back(std::move(current));
+        }
+
+        const auto cacheDir = template_cache::directory();
+        const auto indexFile = cacheDir
+            ? std::optional{ *cacheDir / fmt::format("registry-{:016x}.idx", utils::hash(configPath.string())) }
+            : std::nullopt;
+
+        if (indexFile && registry.readIndex(*indexFile)) {
+            return std::move(registry);
+        }
+
+        for (uint64_t i = 0; i < registry.m_Sources.size(); ++i) {
+            auto file = utils::mapped_file::open(registry.m_Sources[i].path);
+
+            if (! file) {
+                return error_t{ {
+                    errors::ParseError,
+                    fmt::format("Couldn't load user config from '{}', make sure the config files exists and has the right perms",
+                                registry.m_Sources[i].path.string())
+                } };
+            }
+
+            registry.scan(i, file->view());
+        }
+
+        if (indexFile) {
+            registry.writeIndex(*indexFile);
+        }
+
+        return std::move(registry);
+    }
+
+    template_registry::section_t template_registry::section(std::string_view name) const {
+        using error_t = section_t::unexpected_type;
+
+        auto it = m_Index.find(std::string{ name });
+
+        if (it == m_Index.end()) {
+            return error_t{ { errors::NotFound, fmt::format("Template '{}' not found on user config", name) } };
+        }
+
+        // Root level keys would belong to the table before them, they go ahead of every header
+        auto spans = it->second;
+        std::stable_partition(spans.begin(), spans.end(), [](const span &current) { return current.root; });
+
+        std::string text;
+        uint64_t openSource = m_Sources.size();
+        utils::mapped_file file;
+
+        for (const auto &current : spans) {
+            if (current.source != openSource) {
+                auto fileEx = utils::mapped_file::open(m_Sources[current.source].path);
+
+                if (! fileEx) {
+                    return error_t{ { errors::ParseError, fmt::format("Couldn't read '{}'", m_Sources[current.source].path.string()) } };
+                }
+
+                file = std::move(fileEx).value();
+                openSource = current.source;
+            }
+
+            const auto content = file.view();
+
+            if (current.offset + current.length > content.size()) {
+                return error_t{ { errors::ParseError, fmt::format("'{}' changed while reading it", m_Sources[current.source].path.string()) } };
+            }
+
+            text.append(content.substr(current.offset, current.length));
+            text += '\n';
+        }
+
+        return std::move(text);
+    }
+
+    template_registry::table_t template_registry::table(std::string_view name) const {
+        using error_t = table_t::unexpected_type;
+
+        auto sectionEx = section(name);
+
+        if (! sectionEx) {
+            return error_t{ std::move(sectionEx).error() };
+        }
+
+        toml::table parsed;
+
+        try {
+            parsed = toml::parse(sectionEx.value());
+        }
+        catch(std::exception &e) {
+            return error_t{ { errors::ParseError, fmt::format("Couldn't parse the user config of '{}'\nReported error: {}", name, e.what()) } };
+        }
+
+        auto node = parsed.get(name);
+
+        if (! node) {
+            return error_t{ { errors::NotFound, fmt::format("Template '{}' not found on user config", name) } };
+        }
+
+        if (! node->as_table()) {
+            return error_t{ { errors::ParseError, fmt::format("The template '{}' is not a table", name) } };
+        }
+
+        return *node->as_table();
+    }
+
+    std::vector<std::string> template_registry::names() const {
+        std::vector<std::string> ret;
+        ret.reserve(m_Index.size());
+
+        for (const auto &[name, _] : m_Index) {
+            ret.push_back(name);
+        }
+
+        std::sort(ret.begin(), ret.end());
+
+        return ret;
+    }
+
+    void template_registry::scan(uint64_t sourceIndex, std::string_view content) {
+        std::string current;
+        std::size_t spanBegin = 0;
+        // The table defined by the root level keys being read, they come before any header
+        std::string rootTable;
+        std::size_t rootBegin = 0;
+
+        // Multi-line strings and arrays can hold lines that look like headers
+        std::string_view multilineDelimiter;
+        int arrayDepth = 0;
+
+        const auto closeSpan = [&](std::size_t end) {
+            if (! current.empty() && end > spanBegin) {
+                m_Index[current].push_back({ sourceIndex, spanBegin, end - spanBegin, false });
+            }
+        };
+
+        const auto closeRootSpan = [&](std::size_t end) {
+            if (! rootTable.empty() && end > rootBegin) {
+                m_Index[rootTable].push_back({ sourceIndex, rootBegin, end - rootBegin, true });
+            }
+
+            rootTable.clear();
+        };
+
+        const auto consumeValue = [&](std::string_view line, std::size_t pos) {
+            while (pos < line.size()) {
+                if (! multilineDelimiter.empty()) {
+                    const auto end = line.find(multilineDelimiter, pos);
+
+                    if (end == std::string_view::npos) {
+                        return;
+                    }
+
+                    pos = end + 3;
+                    multilineDelimiter = {};
+                    continue;
+                }
+
+                const char c = line[pos];
+
+                if (c == '#') {
+                    return;
+                }
+
+                if (line.compare(pos, 3, "\"\"\"") == 0 || line.compare(pos, 3, "'''") == 0) {
+                    multilineDelimiter = line.compare(pos, 3, "\"\"\"") == 0 ? "\"\"\"" : "'''";
+                    pos += 3;
+                    continue;
+                }
+
+                if (c == '"' || c == '\'') {
+                    pos = skipString(line, pos);
+                    continue;
+                }
+
+                if (c == '[') {
+                    ++arrayDepth;
+                }
+                else if (c == ']' && arrayDepth > 0) {
+                    --arrayDepth;
+                }
+
+                ++pos;
+            }
+        };
+
+        std::size_t lineBegin = 0;
+
+        while (lineBegin < content.size()) {
+            auto lineEnd = content.find('\n', lineBegin);
+
+            if (lineEnd == std::string_view::npos) {
+                lineEnd = content.size();
+            }
+
+            const auto line = content.substr(lineBegin, lineEnd - lineBegin);
+
+            if (! multilineDelimiter.empty() || arrayDepth > 0) {
+                consumeValue(line, 0);
+            }
+            else if (auto key = headerKey(line); ! key.empty()) {
+                closeRootSpan(lineBegin);
+                closeSpan(lineBegin);
+
+                current = std::move(key);
+                spanBegin = lineBegin;
+            }
+            else if (const auto first = line.find_first_not_of(" \t\r"); first != std::string_view::npos && line[first] != '#') {
+                if (current.empty()) {
+                    closeRootSpan(lineBegin);
+
+                    rootTable = rootTableKey(line, first);
+                    rootBegin = lineBegin;
+                }
+
+                consumeValue(line, line.find('=') == std::string_view::npos ? line.size() : line.find('=') + 1);
+            }
+
+            lineBegin = lineEnd + 1;
+        }
+
+        closeRootSpan(content.size());
+        closeSpan(content.size());
+    }
+
+    bool template_registry::readIndex(const fs::path &indexFile) {
+        auto fileEx = utils::mapped_file::open(indexFile);
+
+        if (! fileEx) {
+            return false;
+        }
+
+        utils::binary_reader in{ fileEx->view() };
+
+        if (in.str() != IndexMagic || in.u64() != IndexVersion) {
+            return false;
+        }
+
+        if (in.str() != m_ConfigPath.string() || static_cast<int64_t>(in.u64()) != m_FragmentsMtime) {
+            return false;
+        }
+
+        if (in.u64() != m_Sources.size()) {
+            return false;
+        }
+
+        for (auto &current : m_Sources) {
+            const auto path = in.str();
+            const auto mtime = static_cast<int64_t>(in.u64());
+            const auto size = in.u64();
+
+            if (in.failed() || path != current.path.string() || mtime != current.mtime || size != current.size) {
+                return false;
+            }
+        }
+
+        const auto count = in.u64();
+        bool valid = true;
+
+        for (uint64_t i = 0; i < count && valid && ! in.failed(); ++i) {
+            auto &spans = m_Index[std::string{ in.str() }];
+            const auto spanCount = in.u64();
+
+            // A corrupted count shouldn't turn into a huge allocation
+            if (spanCount > fileEx->view().size() / 32) {
+                valid = false;
+                break;
+            }
+
+            spans.resize(spanCount);
+
+            for (auto &current : spans) {
+                current.source = in.u64();
+                current.offset = in.u64();
+                current.length = in.u64();
+                current.root = in.u64() != 0;
+
+                valid = valid && current.source < m_Sources.size();
+            }
+        }
+
+        if (in.failed() || ! valid) {
+            m_Index.clear();
+
+            return false;
+        }
+
+        return true;
+    }
+
+    void template_registry::writeIndex(const fs::path &indexFile) const {
+        utils::binary_writer out;
+
+        out.str(IndexMagic);
+        out.u64(IndexVersion);
+        out.str(m_ConfigPath.string());
+        out.u64(static_cast<uint64_t>(m_FragmentsMtime));
+
+        out.u64(m_Sources.size());
+
+        for (const auto &current : m_Sources) {
+            out.str(current.path.string());
+            out.u64(static_cast<uint64_t>(current.mtime));
+            out.u64(current.size);
+        }
+
+        out.u64(m_Index.size());
+
+        for (const auto &[name, spans] : m_Index) {
+            out.str(name);
+            out.u64(spans.size());
+
+            for (const auto &current : spans) {
+                out.u64(current.source);
+                out.u64(current.offset);
+                out.u64(current.length);
+                out.u64(current.root ? 1 : 0);
+            }
+        }
+
+        utils::replaceFile(indexFile, { out.buffer() }, 0644);
+    }
+
+}
@@ -0,0 +1,412 @@
+#include "utils/file.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <climits>
+#include <atomic>
+#include <utility>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#include <linux/fs.h>
+
+#include <fmt/format.h>
+
+#include "utils/trace.hpp"
+
+namespace arti::utils {
+
+    using counters = trace::counters;
+
+    mapped_file::expected_t mapped_file::open(const fs::path &path) {
+        using error_t = expected_t::unexpected_type;
+
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        trace::add(counters::OpenCalls);
+
+        if (fd < 0) {
+            return error_t{ { file_errors::UnableToOpen, fmt::format("{}: {}", path.string(), std::strerror(errno)) } };
+        }
+
+        mapped_file file;
+
+        struct stat st;
+
+        trace::add(counters::StatCalls);
+
+        if (::fstat(fd, &st) != 0) {
+            const auto err = errno;
+            ::close(fd);
+            return error_t{ { file_errors::UnableToOpen, fmt::format("{}: {}", path.string(), std::strerror(err)) } };
+        }
+
+        file.m_Mode = st.st_mode & 07777;
+
+        if (S_ISREG(st.st_mode) && st.st_size > 0) {
+            void *mapping = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            trace::add(counters::MapCalls);
+
+            if (mapping != MAP_FAILED) {
+                trace::add(counters::BytesRead, st.st_size);
+
+                ::madvise(mapping, st.st_size, MADV_SEQUENTIAL);
+                ::close(fd);
+
+                file.m_Mapping = mapping;
+                file.m_Size = st.st_size;
+
+                return std::move(file);
+            }
+        }
+
+        if (S_ISREG(st.st_mode)) {
+            file.m_Buffer.reserve(st.st_size);
+        }
+
+        char chunk[64 * 1024];
+
+        for (;;) {
+            const auto n = ::read(fd, chunk, sizeof(chunk));
+            trace::add(counters::ReadCalls);
+
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+
+            if (n < 0) {
+                const auto err = errno;
+                ::close(fd);
+                return error_t{ { file_errors::UnableToOpen, fmt::format("{}: {}", path.string(), std::strerror(err)) } };
+            }
+
+            if (n == 0) {
+                break;
+            }
+
+            file.m_Buffer.append(chunk, n);
+            trace::add(counters::BytesRead, n);
+        }
+
+        ::close(fd);
+
+        return std::move(file);
+    }
+
+    mapped_file::~mapped_file() {
+        release();
+    }
+
+    mapped_file::mapped_file(mapped_file &&other) noexcept
+        : m_Mapping(std::exchange(other.m_Mapping, nullptr))
+        , m_Size(std::exchange(other.m_Size, 0))
+        , m_Buffer(std::move(other.m_Buffer))
+        , m_Mode(other.m_Mode) {
+    }
+
+    mapped_file &mapped_file::operator=(mapped_file &&other) noexcept {
+        if (this != &other) {
+            release();
+
+            m_Mapping = std::exchange(other.m_Mapping, nullptr);
+            m_Size = std::exchange(other.m_Size, 0);
+            m_Buffer = std::move(other.m_Buffer);
+            m_Mode = other.m_Mode;
+        }
+
+        return *this;
+    }
+
+    std::string_view mapped_file::view() const {
+        if (m_Mapping) {
+            return { static_cast<const char *>(m_Mapping), m_Size };
+        }
+
+        return m_Buffer;
+    }
+
+    mode_t mapped_file::mode() const {
+        return m_Mode;
+    }
+
+    void mapped_file::release() {
+        if (m_Mapping) {
+            ::munmap(m_Mapping, m_Size);
+            m_Mapping = nullptr;
+            m_Size = 0;
+        }
+    }
+
+    std::optional<struct stat> statOf(const fs::path &path) {
+        struct stat st;
+
+        trace::add(counters::StatCalls);
+
+        if (::stat(path.c_str(), &st) != 0) {
+            return std::nullopt;
+        }
+
+        return st;
+    }
+
+    int64_t mtimeOf(const struct stat &st) {
+        return static_cast<int64_t>(st.st_mtim.tv_sec) * 1'000'000'000 + st.st_mtim.tv_nsec;
+    }
+
+    arti::expected<void, file_errors> makeDirectory(const fs::path &path, mode_t mode) {
+        return makeDirectoryAt(AT_FDCWD, path.c_str(), path, mode);
+    }
+
+    arti::expected<void, file_errors> makeDirectoryAt(int at, const char *name, const fs::path &path, mode_t mode) {
+        using expected_t = arti::expected<void, file_errors>;
+        using error_t = expected_t::unexpected_type;
+
+        trace::add(counters::MkdirCalls);
+
+        if (::mkdirat(at, name, mode) != 0) {
+            const auto code = errno == EEXIST ? file_errors::AlreadyExisting : file_errors::UnableToCreate;
+            return error_t{ { code, fmt::format("{}: {}", path.string(), std::strerror(errno)) } };
+        }
+
+        return {};
+    }
+
+    int openDirectoryAt(int at, const char *name) {
+        trace::add(counters::OpenCalls);
+
+        return ::openat(at, name, O_PATH | O_DIRECTORY | O_CLOEXEC);
+    }
+
+    arti::expected<void, file_errors> writeNewFile(
+        const fs::path &path,
+        const std::vector<std::string_view> &chunks,
+        mode_t mode
+    ) {
+        return writeNewFileAt(AT_FDCWD, path.c_str(), path, chunks, mode);
+    }
+
+    arti::expected<void, file_errors> writeNewFileAt(
+        int at,
+        const char *name,
+        const fs::path &path,
+        const std::vector<std::string_view> &chunks,
+        mode_t mode
+    ) {
+        using expected_t = arti::expected<void, file_errors>;
+        using error_t = expected_t::unexpected_type;
+
+        const int fd = ::openat(at, name, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, mode);
+        trace::add(counters::OpenCalls);
+
+        if (fd < 0) {
+            const auto code = errno == EEXIST ? file_errors::AlreadyExisting : file_errors::UnableToCreate;
+            return error_t{ { code, fmt::format("{}: {}", path.string(), std::strerror(errno)) } };
+        }
+
+        // O_CREAT honours the umask, fs::copy semantics keep the template permissions
+        ::fchmod(fd, mode);
+
+        std::vector<iovec> iov;
+        std::string coalesced;
+
+        if (chunks.size() <= IOV_MAX) {
+            iov.reserve(chunks.size());
+
+            for (const auto &chunk : chunks) {
+                if (! chunk.empty()) {
+                    iov.push_back({ const_cast<char *>(chunk.data()), chunk.size() });
+                }
+            }
+        }
+        else {
+            std::size_t size = 0;
+
+            for (const auto &chunk : chunks) {
+                size += chunk.size();
+            }
+
+            coalesced.reserve(size);
+
+            for (const auto &chunk : chunks) {
+                coalesced.append(chunk);
+            }
+
+            iov.push_back({ coalesced.data(), coalesced.size() });
+        }
+
+        auto *cur = iov.data();
+        auto *end = iov.data() + iov.size();
+
+        while (cur != end) {
+            const auto n = ::writev(fd, cur, static_cast<int>(end - cur));
+            trace::add(counters::WriteCalls);
+
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+
+            if (n < 0) {
+                const auto err = errno;
+                ::close(fd);
+                return error_t{ { file_errors::UnableToWrite, fmt::format("{}: {}", path.string(), std::strerror(err)) } };
+            }
+
+            auto written = static_cast<std::size_t>(n);
+            trace::add(counters::BytesWritten, written);
+
+            while (cur != end && written >= cur->iov_len) {
+                written -= cur->iov_len;
+                ++cur;
+            }
+
+            if (cur != end) {
+                cur->iov_base = static_cast<char *>(cur->iov_base) + written;
+                cur->iov_len -= written;
+            }
+        }
+
+        if (::close(fd) != 0) {
+            return error_t{ { file_errors::UnableToWrite, fmt::format("{}: {}", path.string(), std::strerror(errno)) } };
+        }
+
+        return {};
+    }
+
+    fs::path temporaryPath(const fs::path &path) {
+        // The pid tells processes apart, the counter calls of the same process (daemon requests)
+        static std::atomic<uint64_t> counter{ 0 };
+
+        return fmt::format("{}.{}.{}.tmp", path.string(), ::getpid(), counter.fetch_add(1, std::memory_order_relaxed));
+    }
+
+    arti::expected<void, file_errors> replaceFile(
+        const fs::path &path,
+        const std::vector<std::string_view> &chunks,
+        mode_t mode
+    ) {
+        using expected_t = arti::expected<void, file_errors>;
+        using error_t = expected_t::unexpected_type;
+
+        const auto tempFile = temporaryPath(path);
+
+        if (auto ex = writeNewFile(tempFile, chunks, mode); ! ex) {
+            // Only what this call created is removed, an existing file belongs to someone else
+            if (ex.error().error != file_errors::AlreadyExisting) {
+                ::unlink(tempFile.c_str());
+            }
+
+            return ex;
+        }
+
+        if (::rename(tempFile.c_str(), path.c_str()) != 0) {
+            const auto err = errno;
+            ::unlink(tempFile.c_str());
+
+            return error_t{ { file_errors::UnableToWrite, fmt::format("{}: {}", path.string(), std::strerror(err)) } };
+        }
+
+        return {};
+    }
+
+    arti::expected<void, file_errors> copyNewFile(
+        const fs::path &source,
+        const fs::path &path,
+        mode_t mode
+    ) {
+        return copyNewFileAt(source, AT_FDCWD, path.c_str(), path, mode);
+    }
+
+    arti::expected<void, file_errors> copyNewFileAt(
+        const fs::path &source,
+        int at,
+        const char *name,
+        const fs::path &path,
+        mode_t mode
+    ) {
+        using expected_t = arti::expected<void, file_errors>;
+        using error_t = expected_t::unexpected_type;
+
+        const int in = ::open(source.c_str(), O_RDONLY | O_CLOEXEC);
+        trace::add(counters::OpenCalls);
+
+        if (in < 0) {
+            return error_t{ { file_errors::UnableToOpen, fmt::format("{}: {}", source.string(), std::strerror(errno)) } };
+        }
+
+        struct stat st;
+
+        trace::add(counters::StatCalls);
+
+        if (::fstat(in, &st) != 0) {
+            const auto err = errno;
+            ::close(in);
+            return error_t{ { file_errors::UnableToOpen, fmt::format("{}: {}", source.string(), std::strerror(err)) } };
+        }
+
+        const int out = ::openat(at, name, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, mode);
+        trace::add(counters::OpenCalls);
+
+        if (out < 0) {
+            const auto err = errno;
+            ::close(in);
+
+            const auto code = err == EEXIST ? file_errors::AlreadyExisting : file_errors::UnableToCreate;
+            return error_t{ { code, fmt::format("{}: {}", path.string(), std::strerror(err)) } };
+        }
+
+        ::fchmod(out, mode);
+
+        const auto fail = [&](int err) {
+            ::close(in);
+            ::close(out);
+            return error_t{ { file_errors::UnableToWrite, fmt::format("{}: {}", path.string(), std::strerror(err)) } };
+        };
+
+        // A reflink shares the extents, nothing is copied at all (btrfs, XFS)
+        const bool cloned = st.st_size > 0 && ::ioctl(out, FICLONE, in) == 0;
+        trace::add(counters::WriteCalls, st.st_size > 0 ? 1 : 0);
+
+        bool useSendfile = false;
+
+        while (st.st_size > 0 && ! cloned) {
+            const auto n = useSendfile
+                ? ::sendfile(out, in, nullptr, 1 << 30)
+                : ::copy_file_range(in, nullptr, out, nullptr, 1 << 30, 0);
+
+            trace::add(counters::WriteCalls);
+
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+
+            // Cross filesystem copies or kernels without copy_file_range, both use the file offsets
+            if (n < 0 && ! useSendfile && (errno == EXDEV || errno == ENOSYS || errno == EINVAL || errno == EOPNOTSUPP)) {
+                useSendfile = true;
+                continue;
+            }
+
+            if (n < 0) {
+                return fail(errno);
+            }
+
+            if (n == 0) {
+                break;
+            }
+
+            trace::add(counters::BytesWritten, static_cast<uint64_t>(n));
+        }
+
+        ::close(in);
+
+        if (::close(out) != 0) {
+            return error_t{ { file_errors::UnableToWrite, fmt::format("{}: {}", path.string(), std::strerror(errno)) } };
+        }
+
+        return {};
+    }
+
+}
@@ -0,0 +1,140 @@
+#include "utils/hash.hpp"
+
+#include <cstring>
+
+namespace arti::utils {
+
+    namespace {
+        constexpr uint64_t Prime1 = 0x9E3779B185EBCA87ULL;
+        constexpr uint64_t Prime2 = 0xC2B2AE3D27D4EB4FULL;
+        constexpr uint64_t Prime3 = 0x165667B19E3779F9ULL;
+        constexpr uint64_t Prime4 = 0x85EBCA77C2B2AE63ULL;
+        constexpr uint64_t Prime5 = 0x27D4EB2F165667C5ULL;
+
+        constexpr uint64_t rotl(uint64_t x, int r) {
+            return (x << r) | (x >> (64 - r));
+        }
+
+        uint64_t read64(const unsigned char *p) {
+            uint64_t v;
+            std::memcpy(&v, p, sizeof(v));
+            return v;
+        }
+
+        uint32_t read32(const unsigned char *p) {
+            uint32_t v;
+            std::memcpy(&v, p, sizeof(v));
+            return v;
+        }
+
+        constexpr uint64_t round(uint64_t acc, uint64_t input) {
+            acc += input * Prime2;
+            acc = rotl(acc, 31);
+            return acc * Prime1;
+        }
+
+        constexpr uint64_t mergeRound(uint64_t acc, uint64_t val) {
+            acc ^= round(0, val);
+            return acc * Prime1 + Prime4;
+        }
+    }
+
+    hasher::hasher(uint64_t seed)
+        : m_Acc{ seed + Prime1 + Prime2, seed + Prime2, seed, seed - Prime1 }
+        , m_Seed(seed) {
+    }
+
+    hasher &hasher::update(std::string_view data) {
+        auto *p = reinterpret_cast<const unsigned char *>(data.data());
+        auto len = data.size();
+
+        m_Total += len;
+
+        if (m_Buffered + len < sizeof(m_Buffer)) {
+            std::memcpy(m_Buffer + m_Buffered, p, len);
+            m_Buffered += len;
+            return *this;
+        }
+
+        if (m_Buffered > 0) {
+            const auto fill = sizeof(m_Buffer) - m_Buffered;
+            std::memcpy(m_Buffer + m_Buffered, p, fill);
+
+            for (int i = 0; i < 4; ++i) {
+                m_Acc[i] = round(m_Acc[i], read64(m_Buffer + i * 8));
+            }
+
+            p += fill;
+            len -= fill;
+            m_Buffered = 0;
+        }
+
+        while (len >= 32) {
+            for (int i = 0; i < 4; ++i) {
+                m_Acc[i] = round(m_Acc[i], read64(p + i * 8));
+            }
+
+            p += 32;
+            len -= 32;
+        }
+
+        std::memcpy(m_Buffer, p, len);
+        m_Buffered = len;
+
+        return *this;
+    }
+
+    uint64_t hasher::digest() const {
+        uint64_t h;
+
+        if (m_Total >= 32) {
+            h = rotl(m_Acc[0], 1) + rotl(m_Acc[1], 7) + rotl(m_Acc[2], 12) + rotl(m_Acc[3], 18);
+
+            for (int i = 0; i < 4; ++i) {
+                h = mergeRound(h, m_Acc[i]);
+            }
+        }
+        else {
+            h = m_Seed + Prime5;
+        }
+
+        h += m_Total;
+
+        const unsigned char *p = m_Buffer;
+        auto len = m_Buffered;
+
+        while (len >= 8) {
+            h ^= round(0, read64(p));
+            h = rotl(h, 27) * Prime1 + Prime4;
+            p += 8;
+            len -= 8;
+        }
+
+        if (len >= 4) {
+            h ^= static_cast<uint64_t>(read32(p)) * Prime1;
+            h = rotl(h, 23) * Prime2 + Prime3;
+            p += 4;
+            len -= 4;
+        }
+
+        while (len > 0) {
+            h ^= (*p) * Prime5;
+            h = rotl(h, 11) * Prime1;
+            ++p;
+            --len;
+        }
+
+        h ^= h >> 33;
+        h *= Prime2;
+        h ^= h >> 29;
+        h *= Prime3;
+        h ^= h >> 32;
+
+        return h;
+    }
+
+    uint64_t hash(std::string_view data, uint64_t seed) {
+        return hasher{ seed }.update(data).digest();
+    }
+
+}
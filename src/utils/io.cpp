@@ -0,0 +1,754 @@
+#include "utils/io.hpp"
+
+#include <cerrno>
+#include <cstdio>
+#include <climits>
+#include <cstring>
+#include <iterator>
+#include <algorithm>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+
+#if __has_include(<linux/io_uring.h>)
+    #include <linux/io_uring.h>
+
+    // Operations are enums, CQE_SKIP (5.17) stands for headers new enough to know MKDIRAT (5.15)
+    #ifdef IORING_FEAT_CQE_SKIP
+        #define ARTI_IO_URING 1
+    #endif
+#endif
+
+#include <fmt/format.h>
+
+#include "utils/trace.hpp"
+#include "utils/thread_pool.hpp"
+
+namespace arti::utils {
+
+    namespace {
+        using counters = trace::counters;
+        using span = trace::span;
+        using status_t = io_backend::status_t;
+        using error_t = status_t::unexpected_type;
+
+        // Below this many operations the ring setup costs more than the syscalls it saves
+        constexpr std::size_t UringThreshold = 32;
+
+        status_t writeRequest(const io_backend::file_request &request, int at, const char *name) {
+            if (request.source) {
+                return copyNewFileAt(*request.source, at, name, request.path, request.mode);
+            }
+
+            return writeNewFileAt(at, name, request.path, request.chunks, request.mode);
+        }
+
+        class sync_backend final : public io_backend {
+          public:
+            kinds kind() const override {
+                return kinds::Sync;
+            }
+
+            std::vector<status_t> makeDirectories(const std::vector<directory_request> &requests) override {
+                std::vector<status_t> statuses(requests.size());
+                resetHandles(requests.size());
+
+                for (std::size_t i = 0; i < requests.size(); ++i) {
+                    const auto &request = requests[i];
+                    const auto [at, name] = locate(request.path, request.parent);
+
+                    if (! request.existing) {
+                        statuses[i] = makeDirectoryAt(at, name, request.path);
+                    }
+
+                    // One created since it was planned is still good to create things in
+                    if (statuses[i] || statuses[i].error().error == file_errors::AlreadyExisting) {
+                        keepHandle(i, openDirectoryAt(at, name));
+                    }
+                }
+
+                return statuses;
+            }
+
+            std::vector<status_t> writeFiles(const std::vector<file_request> &requests, std::size_t jobs) override {
+                std::vector<status_t> statuses(requests.size());
+
+                const auto write = [&](std::size_t i) {
+                    const span fileSpan{ span::kinds::File, requests[i].path.native() };
+                    const auto [at, name] = locate(requests[i].path, requests[i].parent);
+
+                    statuses[i] = writeRequest(requests[i], at, name);
+                };
+
+                if (jobs > 1) {
+                    thread_pool pool{ jobs };
+
+                    for (std::size_t i = 0; i < requests.size(); ++i) {
+                        pool.submit([&, i] {
+                            write(i);
+                        });
+                    }
+
+                    pool.wait();
+
+                    return statuses;
+                }
+
+                // Every request is attempted, as with several jobs, so each status is its own outcome
+                for (std::size_t i = 0; i < requests.size(); ++i) {
+                    write(i);
+                }
+
+                return statuses;
+            }
+        };
+
+#ifdef ARTI_IO_URING
+        // Minimal io_uring, without liburing: one submission queue filled and
+        // drained a full batch at a time by a single thread
+        class ring {
+          public:
+            static std::unique_ptr<ring> create(unsigned entries) {
+                auto created = std::unique_ptr<ring>{ new ring{} };
+
+                if (! created->setup(entries)) {
+                    return nullptr;
+                }
+
+                return created;
+            }
+
+            ~ring() {
+                if (m_Sqes != nullptr) {
+                    ::munmap(m_Sqes, m_SqesSize);
+                }
+
+                if (m_CqMap != nullptr && m_CqMap != m_SqMap) {
+                    ::munmap(m_CqMap, m_CqMapSize);
+                }
+
+                if (m_SqMap != nullptr) {
+                    ::munmap(m_SqMap, m_SqMapSize);
+                }
+
+                if (m_Fd >= 0) {
+                    ::close(m_Fd);
+                }
+            }
+
+            ring(ring &&) = delete;
+            ring(const ring &) = delete;
+
+            ring &operator=(ring &&) = delete;
+            ring &operator=(const ring &) = delete;
+
+            // Submits 'count' operations, as many per io_uring_enter as the
+            // queue holds, and waits for all of them. 'complete' receives the
+            // index given to 'prepare' and the operation result (-errno on failure).
+            template <typename Prepare, typename Complete>
+            void run(std::size_t count, Prepare &&prepare, Complete &&complete) {
+                for (std::size_t next = 0; next < count;) {
+                    const auto batch = static_cast<unsigned>(std::min<std::size_t>(count - next, m_SqEntries));
+
+                    if (m_Broken) {
+                        for (unsigned i = 0; i < batch; ++i) {
+                            complete(next + i, -EIO);
+                        }
+
+                        next += batch;
+                        continue;
+                    }
+
+                    unsigned tail = *m_SqTail;
+
+                    for (unsigned i = 0; i < batch; ++i, ++tail) {
+                        const unsigned index = tail & m_SqMask;
+                        auto &sqe = m_Sqes[index];
+
+                        std::memset(&sqe, 0, sizeof(sqe));
+                        prepare(next + i, sqe);
+                        sqe.user_data = next + i;
+
+                        m_SqArray[index] = index;
+                    }
+
+                    __atomic_store_n(m_SqTail, tail, __ATOMIC_RELEASE);
+
+                    trace::add(counters::RingOperations, batch);
+
+                    unsigned toSubmit = batch;
+                    unsigned pending = batch;
+
+                    std::vector<bool> done(batch, false);
+
+                    const auto completed = [&](uint64_t index, int res) {
+                        done[index - next] = true;
+                        complete(index, res);
+                    };
+
+                    while (pending > 0) {
+                        const auto ret = ::syscall(__NR_io_uring_enter, m_Fd, toSubmit, pending, IORING_ENTER_GETEVENTS, nullptr, 0);
+                        trace::add(counters::RingEnterCalls);
+
+                        if (ret < 0) {
+                            if (errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+                                continue;
+                            }
+
+                            // Nothing else is submitted once broken, what's pending can't complete
+                            const auto err = errno;
+                            m_Broken = true;
+
+                            reap(completed);
+
+                            for (unsigned i = 0; i < batch; ++i) {
+                                if (! done[i]) {
+                                    complete(next + i, -err);
+                                }
+                            }
+
+                            break;
+                        }
+
+                        toSubmit -= std::min<unsigned>(toSubmit, static_cast<unsigned>(ret));
+
+                        pending -= reap(completed);
+                    }
+
+                    next += batch;
+                }
+            }
+
+          private:
+            ring() = default;
+
+            bool setup(unsigned entries) {
+                io_uring_params params{};
+
+                m_Fd = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+
+                if (m_Fd < 0) {
+                    return false;
+                }
+
+                m_SqMapSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+                m_CqMapSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+                const bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+
+                if (singleMap) {
+                    m_SqMapSize = m_CqMapSize = std::max(m_SqMapSize, m_CqMapSize);
+                }
+
+                m_SqMap = map(m_SqMapSize, IORING_OFF_SQ_RING);
+                m_CqMap = singleMap ? m_SqMap : map(m_CqMapSize, IORING_OFF_CQ_RING);
+
+                m_SqesSize = params.sq_entries * sizeof(io_uring_sqe);
+                m_Sqes = static_cast<io_uring_sqe *>(map(m_SqesSize, IORING_OFF_SQES));
+
+                if (m_SqMap == nullptr || m_CqMap == nullptr || m_Sqes == nullptr) {
+                    return false;
+                }
+
+                auto *sq = static_cast<char *>(m_SqMap);
+                auto *cq = static_cast<char *>(m_CqMap);
+
+                m_SqTail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+                m_SqMask = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+                m_SqArray = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+                m_SqEntries = params.sq_entries;
+
+                m_CqHead = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+                m_CqTail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+                m_CqMask = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+                m_Cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+
+                return supportsOperations();
+            }
+
+            void *map(std::size_t size, off_t offset) {
+                void *mapping = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_Fd, offset);
+
+                return mapping == MAP_FAILED ? nullptr : mapping;
+            }
+
+            bool supportsOperations() {
+                constexpr unsigned ProbeOps = 256;
+
+                std::vector<char> buffer(sizeof(io_uring_probe) + ProbeOps * sizeof(io_uring_probe_op), 0);
+                auto *probe = reinterpret_cast<io_uring_probe *>(buffer.data());
+
+                if (::syscall(__NR_io_uring_register, m_Fd, IORING_REGISTER_PROBE, probe, ProbeOps) < 0) {
+                    return false;
+                }
+
+                for (const unsigned op : { IORING_OP_OPENAT, IORING_OP_WRITEV, IORING_OP_CLOSE, IORING_OP_MKDIRAT }) {
+                    if (op > probe->last_op || (probe->ops[op].flags & IO_URING_OP_SUPPORTED) == 0) {
+                        return false;
+                    }
+                }
+
+                return true;
+            }
+
+            template <typename Complete>
+            unsigned reap(Complete &&complete) {
+                unsigned head = *m_CqHead;
+                const unsigned tail = __atomic_load_n(m_CqTail, __ATOMIC_ACQUIRE);
+                unsigned reaped = 0;
+
+                for (; head != tail; ++head, ++reaped) {
+                    const auto &cqe = m_Cqes[head & m_CqMask];
+
+                    complete(cqe.user_data, cqe.res);
+                }
+
+                __atomic_store_n(m_CqHead, head, __ATOMIC_RELEASE);
+
+                return reaped;
+            }
+
+            int m_Fd = -1;
+            bool m_Broken = false;
+
+            void *m_SqMap = nullptr;
+            std::size_t m_SqMapSize = 0;
+            void *m_CqMap = nullptr;
+            std::size_t m_CqMapSize = 0;
+
+            io_uring_sqe *m_Sqes = nullptr;
+            std::size_t m_SqesSize = 0;
+
+            unsigned *m_SqTail = nullptr;
+            unsigned *m_SqArray = nullptr;
+            unsigned m_SqMask = 0;
+            unsigned m_SqEntries = 0;
+
+            unsigned *m_CqHead = nullptr;
+            unsigned *m_CqTail = nullptr;
+            unsigned m_CqMask = 0;
+            io_uring_cqe *m_Cqes = nullptr;
+        };
+
+        // io_uring has no fchmod, files only need one when the umask removed bits from their mode
+        mode_t processUmask() {
+            static const mode_t mask = [] {
+                mode_t value = 022;
+
+                if (auto *status = std::fopen("/proc/self/status", "re")) {
+                    char line[256];
+
+                    while (std::fgets(line, sizeof(line), status) != nullptr) {
+                        unsigned parsed;
+
+                        if (std::sscanf(line, "Umask: %o", &parsed) == 1) {
+                            value = static_cast<mode_t>(parsed);
+                            break;
+                        }
+                    }
+
+                    std::fclose(status);
+                }
+
+                return value;
+            }();
+
+            return mask;
+        }
+
+        // Files open at once in a uring batch, a quarter of the descriptor limit leaves room
+        // for the directory handles and for whatever else the process has open
+        std::size_t fileWindow(std::size_t entries) {
+            rlimit limit{};
+
+            if (::getrlimit(RLIMIT_NOFILE, &limit) != 0 || limit.rlim_cur == RLIM_INFINITY) {
+                return entries;
+            }
+
+            return std::clamp<std::size_t>(static_cast<std::size_t>(limit.rlim_cur / 4), 1, entries);
+        }
+
+        std::string describe(const fs::path &path, int res) {
+            return fmt::format("{}: {}", path.string(), std::strerror(-res));
+        }
+
+        // Every step (mkdir, open, write, close) of a batch is one submission of the whole
+        // batch, or of a window of its files, a thousand files take a handful of io_uring_enter calls
+        class uring_backend final : public io_backend {
+          public:
+            static constexpr unsigned Entries = 256;
+
+            explicit uring_backend(std::unique_ptr<ring> ring_v)
+                : m_Ring(std::move(ring_v)) {
+            }
+
+            kinds kind() const override {
+                return kinds::Uring;
+            }
+
+            std::vector<status_t> makeDirectories(const std::vector<directory_request> &requests) override {
+                std::vector<status_t> statuses(requests.size());
+                resetHandles(requests.size());
+
+                std::vector<std::size_t> wave;
+                std::vector<std::size_t> step;
+                std::vector<bool> inWave(requests.size(), false);
+
+                // Every directory of a wave is made, then opened for the waves below it
+                const auto flush = [&] {
+                    const span waveSpan{ span::kinds::File, fmt::format("mkdirat x{}", wave.size()) };
+
+                    step.clear();
+                    std::copy_if(wave.begin(), wave.end(), std::back_inserter(step), [&](std::size_t i) {
+                        return ! requests[i].existing;
+                    });
+
+                    m_Ring->run(
+                        step.size(),
+                        [&](std::size_t i, io_uring_sqe &sqe) {
+                            const auto &request = requests[step[i]];
+                            const auto [at, name] = locate(request.path, request.parent);
+
+                            sqe.opcode = IORING_OP_MKDIRAT;
+                            sqe.fd = at;
+                            sqe.addr = reinterpret_cast<uint64_t>(name);
+                            sqe.len = 0777;
+                        },
+                        [&](std::size_t i, int res) {
+                            if (res < 0) {
+                                const auto code = res == -EEXIST ? file_errors::AlreadyExisting : file_errors::UnableToCreate;
+                                statuses[step[i]] = error_t{ { code, describe(requests[step[i]].path, res) } };
+                            }
+                        }
+                    );
+
+                    step.clear();
+                    std::copy_if(wave.begin(), wave.end(), std::back_inserter(step), [&](std::size_t i) {
+                        return statuses[i] || statuses[i].error().error == file_errors::AlreadyExisting;
+                    });
+
+                    m_Ring->run(
+                        step.size(),
+                        [&](std::size_t i, io_uring_sqe &sqe) {
+                            const auto &request = requests[step[i]];
+                            const auto [at, name] = locate(request.path, request.parent);
+
+                            sqe.opcode = IORING_OP_OPENAT;
+                            sqe.fd = at;
+                            sqe.addr = reinterpret_cast<uint64_t>(name);
+                            sqe.open_flags = O_PATH | O_DIRECTORY | O_CLOEXEC;
+                        },
+                        [&](std::size_t i, int res) {
+                            if (res >= 0) {
+                                keepHandle(step[i], res);
+                            }
+                        }
+                    );
+
+                    for (const auto i : wave) {
+                        inWave[i] = false;
+                    }
+
+                    wave.clear();
+                };
+
+                // A directory whose parent is still being created waits for the next wave
+                for (std::size_t i = 0; i < requests.size(); ++i) {
+                    const auto parent = requests[i].parent;
+
+                    if (parent != NoParent && inWave[parent]) {
+                        flush();
+                    }
+
+                    wave.push_back(i);
+                    inWave[i] = true;
+                }
+
+                if (! wave.empty()) {
+                    flush();
+                }
+
+                return statuses;
+            }
+
+            std::vector<status_t> writeFiles(const std::vector<file_request> &requests, std::size_t) override {
+                struct pending_file {
+                    std::size_t request;
+                    int fd = -1;
+                    std::vector<iovec> iov;
+                    std::string coalesced;
+                    std::size_t next = 0;
+                    uint64_t offset = 0;
+                };
+
+                std::vector<status_t> statuses(requests.size());
+                std::vector<std::size_t> rendered;
+
+                std::vector<location> locations;
+                locations.reserve(requests.size());
+
+                for (const auto &request : requests) {
+                    locations.push_back(locate(request.path, request.parent));
+                }
+
+                for (std::size_t i = 0; i < requests.size(); ++i) {
+                    // Copies already stay inside the kernel, see copyNewFile
+                    if (requests[i].source) {
+                        statuses[i] = copyNewFileAt(*requests[i].source, locations[i].at, locations[i].name, requests[i].path, requests[i].mode);
+                    }
+                    else {
+                        rendered.push_back(i);
+                    }
+                }
+
+                // Sized up front, the iovecs point into the elements
+                std::vector<pending_file> files(rendered.size());
+
+                for (std::size_t i = 0; i < files.size(); ++i) {
+                    auto &file = files[i];
+                    const auto &chunks = requests[rendered[i]].chunks;
+
+                    file.request = rendered[i];
+
+                    if (chunks.size() > IOV_MAX) {
+                        for (const auto &chunk : chunks) {
+                            file.coalesced.append(chunk);
+                        }
+
+                        file.iov.push_back({ file.coalesced.data(), file.coalesced.size() });
+                        continue;
+                    }
+
+                    for (const auto &chunk : chunks) {
+                        if (! chunk.empty()) {
+                            file.iov.push_back({ const_cast<char *>(chunk.data()), chunk.size() });
+                        }
+                    }
+                }
+
+                const auto fail = [&](pending_file &file, file_errors code, int res) {
+                    if (statuses[file.request]) {
+                        statuses[file.request] = error_t{ { code, describe(requests[file.request].path, res) } };
+                    }
+                };
+
+                // O_CREAT honours the umask, fs::copy semantics keep the template permissions
+                const auto umask = processUmask();
+                const auto windowSize = fileWindow(Entries);
+
+                // Files are opened, written and closed a window at a time, the open
+                // descriptors stay bounded however big the batch is
+                std::vector<std::size_t> window;
+                std::vector<std::size_t> writing;
+
+                for (std::size_t first = 0; first < files.size(); first += windowSize) {
+                    window.clear();
+
+                    for (std::size_t i = first; i < std::min(files.size(), first + windowSize); ++i) {
+                        window.push_back(i);
+                    }
+
+                    {
+                        const span waveSpan{ span::kinds::File, fmt::format("openat x{}", window.size()) };
+
+                        m_Ring->run(
+                            window.size(),
+                            [&](std::size_t i, io_uring_sqe &sqe) {
+                                const auto &where = locations[files[window[i]].request];
+
+                                sqe.opcode = IORING_OP_OPENAT;
+                                sqe.fd = where.at;
+                                sqe.addr = reinterpret_cast<uint64_t>(where.name);
+                                sqe.open_flags = O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC;
+                                sqe.len = requests[files[window[i]].request].mode;
+                            },
+                            [&](std::size_t i, int res) {
+                                if (res < 0) {
+                                    fail(files[window[i]], res == -EEXIST ? file_errors::AlreadyExisting : file_errors::UnableToCreate, res);
+                                    return;
+                                }
+
+                                files[window[i]].fd = res;
+                            }
+                        );
+                    }
+
+                    // Short writes are resubmitted from where they stopped on the next round
+                    while (true) {
+                        writing.clear();
+
+                        for (const auto i : window) {
+                            if (files[i].fd >= 0 && files[i].next < files[i].iov.size() && statuses[files[i].request]) {
+                                writing.push_back(i);
+                            }
+                        }
+
+                        if (writing.empty()) {
+                            break;
+                        }
+
+                        const span waveSpan{ span::kinds::File, fmt::format("writev x{}", writing.size()) };
+
+                        m_Ring->run(
+                            writing.size(),
+                            [&](std::size_t i, io_uring_sqe &sqe) {
+                                const auto &file = files[writing[i]];
+
+                                sqe.opcode = IORING_OP_WRITEV;
+                                sqe.fd = file.fd;
+                                sqe.addr = reinterpret_cast<uint64_t>(file.iov.data() + file.next);
+                                sqe.len = static_cast<uint32_t>(file.iov.size() - file.next);
+                                sqe.off = file.offset;
+                            },
+                            [&](std::size_t i, int res) {
+                                auto &file = files[writing[i]];
+
+                                if (res <= 0) {
+                                    fail(file, file_errors::UnableToWrite, res == 0 ? -EIO : res);
+                                    return;
+                                }
+
+                                auto written = static_cast<std::size_t>(res);
+                                file.offset += written;
+                                trace::add(counters::BytesWritten, written);
+
+                                while (file.next < file.iov.size() && written >= file.iov[file.next].iov_len) {
+                                    written -= file.iov[file.next].iov_len;
+                                    ++file.next;
+                                }
+
+                                if (file.next < file.iov.size()) {
+                                    auto &current = file.iov[file.next];
+                                    current.iov_base = static_cast<char *>(current.iov_base) + written;
+                                    current.iov_len -= written;
+                                }
+                            }
+                        );
+                    }
+
+                    std::erase_if(window, [&](std::size_t i) {
+                        return files[i].fd < 0;
+                    });
+
+                    {
+                        const span waveSpan{ span::kinds::File, fmt::format("close x{}", window.size()) };
+
+                        m_Ring->run(
+                            window.size(),
+                            [&](std::size_t i, io_uring_sqe &sqe) {
+                                sqe.opcode = IORING_OP_CLOSE;
+                                sqe.fd = files[window[i]].fd;
+                            },
+                            [&](std::size_t i, int res) {
+                                if (res < 0) {
+                                    fail(files[window[i]], file_errors::UnableToWrite, res);
+                                }
+                            }
+                        );
+                    }
+
+                    for (const auto i : window) {
+                        const auto &request = requests[files[i].request];
+                        const auto &where = locations[files[i].request];
+
+                        if (statuses[files[i].request] && (request.mode & umask) != 0) {
+                            ::fchmodat(where.at, where.name, request.mode, 0);
+                        }
+                    }
+                }
+
+                return statuses;
+            }
+
+          private:
+            std::unique_ptr<ring> m_Ring;
+        };
+#endif
+    }
+
+    io_backend::~io_backend() {
+        resetHandles(0);
+    }
+
+    void io_backend::resetHandles(std::size_t count) {
+        for (const auto handle : m_Handles) {
+            if (handle >= 0) {
+                ::close(handle);
+            }
+        }
+
+        m_Handles.assign(count, -1);
+        m_Open = 0;
+    }
+
+    void io_backend::keepHandle(std::size_t index, int handle) {
+        if (handle < 0) {
+            return;
+        }
+
+        if (m_Open >= MaxHandles) {
+            ::close(handle);
+            return;
+        }
+
+        m_Handles[index] = handle;
+        ++m_Open;
+    }
+
+    io_backend::location io_backend::locate(const fs::path &path, std::size_t parent) const {
+        if (parent == NoParent || parent >= m_Handles.size() || m_Handles[parent] < 0) {
+            return { AT_FDCWD, path.c_str() };
+        }
+
+        const auto &native = path.native();
+        const auto slash = native.rfind('/');
+
+        return { m_Handles[parent], native.c_str() + (slash == std::string::npos ? 0 : slash + 1) };
+    }
+
+    std::unique_ptr<io_backend> io_backend::create(kinds kind, std::size_t operations) {
+        if (kind == kinds::Sync || (kind == kinds::Auto && operations < UringThreshold)) {
+            return std::make_unique<sync_backend>();
+        }
+
+#ifdef ARTI_IO_URING
+        if (auto ring_v = ring::create(uring_backend::Entries)) {
+            return std::make_unique<uring_backend>(std::move(ring_v));
+        }
+#endif
+
+        if (kind == kinds::Uring) {
+            return nullptr;
+        }
+
+        return std::make_unique<sync_backend>();
+    }
+
+    std::optional<io_backend::kinds> io_backend::parse(std::string_view name) {
+        for (const auto kind : { kinds::Auto, kinds::Uring, kinds::Sync }) {
+            if (io_backend::name(kind) == name) {
+                return kind;
+            }
+        }
+
+        return std::nullopt;
+    }
+
+    std::string_view io_backend::name(kinds kind) {
+        switch (kind) {
+            case kinds::Auto:
+                return "auto";
+            case kinds::Uring:
+                return "uring";
+            case kinds::Sync:
+                return "sync";
+        }
+
+        return "unknown";
+    }
+
+}
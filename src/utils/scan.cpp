@@ -0,0 +1,172 @@
+#include "utils/scan.hpp"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #define ARTI_SCAN_X86 1
+    #include <immintrin.h>
+#endif
+
+namespace arti::utils {
+
+    namespace {
+        using kernel_fn = std::size_t (*)(const char *, std::size_t, std::size_t);
+
+        constexpr auto npos = std::string_view::npos;
+
+        std::size_t findScalar(const char *data, std::size_t size, std::size_t pos) {
+            while (pos + 1 < size) {
+                const auto *brace = static_cast<const char *>(std::memchr(data + pos, '{', size - pos - 1));
+
+                if (brace == nullptr) {
+                    return npos;
+                }
+
+                pos = brace - data;
+
+                if (data[pos + 1] == '{' || data[pos + 1] == '%') {
+                    return pos;
+                }
+
+                // The next byte isn't a '{' either, it can't start a candidate
+                pos += 2;
+            }
+
+            return npos;
+        }
+
+#ifdef ARTI_SCAN_X86
+        // The first load compares against '{' and the second against '{' or '%',
+        // a set bit in their AND is a '{{' or '{%' start.
+        // Every load stays one byte short of the end for the shifted one.
+        __attribute__((target("sse2")))
+        std::size_t findSSE2(const char *data, std::size_t size, std::size_t pos) {
+            const auto brace = _mm_set1_epi8('{');
+            const auto percent = _mm_set1_epi8('%');
+
+            while (pos + 17 <= size) {
+                const auto first = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + pos));
+                const auto second = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + pos + 1));
+
+                const auto follows = _mm_or_si128(_mm_cmpeq_epi8(second, brace), _mm_cmpeq_epi8(second, percent));
+                const auto matches = _mm_and_si128(_mm_cmpeq_epi8(first, brace), follows);
+                const auto mask = static_cast<unsigned>(_mm_movemask_epi8(matches));
+
+                if (mask != 0) {
+                    return pos + __builtin_ctz(mask);
+                }
+
+                pos += 16;
+            }
+
+            return findScalar(data, size, pos);
+        }
+
+        __attribute__((target("avx2")))
+        std::size_t findAVX2(const char *data, std::size_t size, std::size_t pos) {
+            const auto brace = _mm256_set1_epi8('{');
+            const auto percent = _mm256_set1_epi8('%');
+
+            while (pos + 33 <= size) {
+                const auto first = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + pos));
+                const auto second = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + pos + 1));
+
+                const auto follows = _mm256_or_si256(_mm256_cmpeq_epi8(second, brace), _mm256_cmpeq_epi8(second, percent));
+                const auto matches = _mm256_and_si256(_mm256_cmpeq_epi8(first, brace), follows);
+                const auto mask = static_cast<unsigned>(_mm256_movemask_epi8(matches));
+
+                if (mask != 0) {
+                    return pos + __builtin_ctz(mask);
+                }
+
+                pos += 32;
+            }
+
+            return findSSE2(data, size, pos);
+        }
+#endif
+
+        kernel_fn kernelOf(scanner::kernels kernel) {
+            switch (kernel) {
+#ifdef ARTI_SCAN_X86
+                case scanner::kernels::AVX2:
+                    return findAVX2;
+                case scanner::kernels::SSE2:
+                    return findSSE2;
+#endif
+                default:
+                    return findScalar;
+            }
+        }
+
+        scanner::kernels detect() {
+#ifdef ARTI_SCAN_X86
+            __builtin_cpu_init();
+
+            if (__builtin_cpu_supports("avx2")) {
+                return scanner::kernels::AVX2;
+            }
+
+            if (__builtin_cpu_supports("sse2")) {
+                return scanner::kernels::SSE2;
+            }
+#endif
+
+            return scanner::kernels::Scalar;
+        }
+
+        struct dispatch {
+            scanner::kernels kernel;
+            kernel_fn find;
+        };
+
+        // Resolved on first use, templates may be compiled during static initialization
+        const dispatch &current() {
+            static const dispatch resolved = [] {
+                const auto kernel = detect();
+
+                return dispatch{ kernel, kernelOf(kernel) };
+            }();
+
+            return resolved;
+        }
+    }
+
+    std::size_t scanner::findOpening(std::string_view text, std::size_t pos) {
+        if (pos >= text.size()) {
+            return npos;
+        }
+
+        return current().find(text.data(), text.size(), pos);
+    }
+
+    std::size_t scanner::findOpening(std::string_view text, std::size_t pos, kernels kernel) {
+        if (pos >= text.size() || ! supported(kernel)) {
+            return npos;
+        }
+
+        return kernelOf(kernel)(text.data(), text.size(), pos);
+    }
+
+    scanner::kernels scanner::active() {
+        return current().kernel;
+    }
+
+    bool scanner::supported(kernels kernel) {
+        return kernel <= current().kernel;
+    }
+
+    std::string_view scanner::name(kernels kernel) {
+        switch (kernel) {
+            case kernels::Scalar:
+                return "scalar";
+            case kernels::SSE2:
+                return "sse2";
+            case kernels::AVX2:
+                return "avx2";
+        }
+
+        return "unknown";
+    }
+
+}
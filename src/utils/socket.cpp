@@ -0,0 +1,216 @@
+#include "utils/socket.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <fmt/format.h>
+
+namespace arti::utils {
+
+    namespace {
+        // Requests are a handful of arguments, anything bigger is garbage
+        constexpr uint64_t MaxFrameSize = 64 * 1024 * 1024;
+
+        bool fillAddress(const fs::path &path, sockaddr_un &address) {
+            const auto &native = path.native();
+
+            if (native.size() >= sizeof(address.sun_path)) {
+                return false;
+            }
+
+            std::memset(&address, 0, sizeof(address));
+            address.sun_family = AF_UNIX;
+            std::memcpy(address.sun_path, native.c_str(), native.size() + 1);
+
+            return true;
+        }
+
+        bool sendAll(int fd, const char *data, std::size_t size) {
+            while (size > 0) {
+                const auto n = ::send(fd, data, size, MSG_NOSIGNAL);
+
+                if (n < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+
+                    return false;
+                }
+
+                data += n;
+                size -= static_cast<std::size_t>(n);
+            }
+
+            return true;
+        }
+
+        bool receiveAll(int fd, char *data, std::size_t size) {
+            while (size > 0) {
+                const auto n = ::recv(fd, data, size, 0);
+
+                if (n < 0 && errno == EINTR) {
+                    continue;
+                }
+
+                if (n <= 0) {
+                    return false;
+                }
+
+                data += n;
+                size -= static_cast<std::size_t>(n);
+            }
+
+            return true;
+        }
+    }
+
+    unix_socket::expected_t unix_socket::listen(const fs::path &path) {
+        using error_t = expected_t::unexpected_type;
+
+        sockaddr_un address;
+
+        if (! fillAddress(path, address)) {
+            return error_t{ { socket_errors::PathTooLong, fmt::format("The socket path '{}' is too long", path.string()) } };
+        }
+
+        // Someone answering means a live daemon, otherwise the file is a leftover
+        if (connect(path)) {
+            return error_t{ { socket_errors::AlreadyListening, fmt::format("A daemon is already listening on '{}'", path.string()) } };
+        }
+
+        ::unlink(path.c_str());
+
+        unix_socket listener{ ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0) };
+
+        if (listener.m_Fd < 0) {
+            return error_t{ { socket_errors::UnableToCreate, std::strerror(errno) } };
+        }
+
+        const auto previousMask = ::umask(0077);
+        const int bound = ::bind(listener.m_Fd, reinterpret_cast<const sockaddr *>(&address), sizeof(address));
+        ::umask(previousMask);
+
+        if (bound != 0 || ::listen(listener.m_Fd, SOMAXCONN) != 0) {
+            return error_t{ { socket_errors::UnableToBind, fmt::format("{}: {}", path.string(), std::strerror(errno)) } };
+        }
+
+        return std::move(listener);
+    }
+
+    unix_socket::expected_t unix_socket::connect(const fs::path &path) {
+        using error_t = expected_t::unexpected_type;
+
+        sockaddr_un address;
+
+        if (! fillAddress(path, address)) {
+            return error_t{ { socket_errors::PathTooLong, fmt::format("The socket path '{}' is too long", path.string()) } };
+        }
+
+        unix_socket connection{ ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0) };
+
+        if (connection.m_Fd < 0) {
+            return error_t{ { socket_errors::UnableToCreate, std::strerror(errno) } };
+        }
+
+        if (::connect(connection.m_Fd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0) {
+            return error_t{ { socket_errors::UnableToConnect, fmt::format("{}: {}", path.string(), std::strerror(errno)) } };
+        }
+
+        return std::move(connection);
+    }
+
+    unix_socket::unix_socket(int fd)
+        : m_Fd(fd) {
+    }
+
+    unix_socket::~unix_socket() {
+        release();
+    }
+
+    unix_socket::unix_socket(unix_socket &&other) noexcept
+        : m_Fd(std::exchange(other.m_Fd, -1)) {
+    }
+
+    unix_socket &unix_socket::operator=(unix_socket &&other) noexcept {
+        if (this != &other) {
+            release();
+            m_Fd = std::exchange(other.m_Fd, -1);
+        }
+
+        return *this;
+    }
+
+    unix_socket::expected_t unix_socket::accept() const {
+        using error_t = expected_t::unexpected_type;
+
+        const int fd = ::accept4(m_Fd, nullptr, nullptr, SOCK_CLOEXEC);
+
+        if (fd < 0) {
+            return error_t{ { socket_errors::UnableToAccept, std::strerror(errno) } };
+        }
+
+        return unix_socket{ fd };
+    }
+
+    bool unix_socket::setTimeout(std::chrono::milliseconds timeout) const {
+        const auto seconds = std::chrono::duration_cast<std::chrono::seconds>(timeout);
+
+        timeval value{};
+        value.tv_sec = static_cast<time_t>(seconds.count());
+        value.tv_usec = static_cast<suseconds_t>(std::chrono::duration_cast<std::chrono::microseconds>(timeout - seconds).count());
+
+        return ::setsockopt(m_Fd, SOL_SOCKET, SO_RCVTIMEO, &value, sizeof(value)) == 0
+            && ::setsockopt(m_Fd, SOL_SOCKET, SO_SNDTIMEO, &value, sizeof(value)) == 0;
+    }
+
+    bool unix_socket::sendFrame(std::string_view payload) const {
+        char header[8];
+
+        for (int i = 0; i < 8; ++i) {
+            header[i] = static_cast<char>((static_cast<uint64_t>(payload.size()) >> (i * 8)) & 0xFF);
+        }
+
+        return sendAll(m_Fd, header, sizeof(header)) && sendAll(m_Fd, payload.data(), payload.size());
+    }
+
+    std::optional<std::string> unix_socket::receiveFrame() const {
+        char header[8];
+
+        if (! receiveAll(m_Fd, header, sizeof(header))) {
+            return std::nullopt;
+        }
+
+        uint64_t size = 0;
+
+        for (int i = 0; i < 8; ++i) {
+            size |= static_cast<uint64_t>(static_cast<unsigned char>(header[i])) << (i * 8);
+        }
+
+        if (size > MaxFrameSize) {
+            return std::nullopt;
+        }
+
+        std::string payload(size, '\0');
+
+        if (! receiveAll(m_Fd, payload.data(), payload.size())) {
+            return std::nullopt;
+        }
+
+        return payload;
+    }
+
+    void unix_socket::release() {
+        if (m_Fd >= 0) {
+            ::close(m_Fd);
+            m_Fd = -1;
+        }
+    }
+
+}
@@ -0,0 +1,384 @@
+#include "utils/tar.hpp"
+
+#include <ctime>
+#include <cerrno>
+#include <cstring>
+#include <utility>
+#include <algorithm>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#ifdef ARTI_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+#include <fmt/format.h>
+
+#include "utils/trace.hpp"
+
+namespace arti::utils {
+
+    namespace {
+        using counters = trace::counters;
+
+        constexpr std::size_t BlockSize = 512;
+        constexpr std::size_t BufferSize = 128 * 1024;
+
+        // Biggest size an 11 digit octal field holds
+        constexpr uint64_t MaxUstarSize = 077777777777ull;
+
+        constexpr char Zeros[BlockSize * 2] = {};
+
+        bool writeAll(int fd, std::string_view data) {
+            while (! data.empty()) {
+                const auto n = ::write(fd, data.data(), data.size());
+                trace::add(counters::WriteCalls);
+
+                if (n < 0 && errno == EINTR) {
+                    continue;
+                }
+
+                if (n <= 0) {
+                    return false;
+                }
+
+                trace::add(counters::BytesWritten, n);
+                data.remove_prefix(n);
+            }
+
+            return true;
+        }
+
+        // Zero padded octal filling all but the terminating NUL of the field
+        void putOctal(char *field, std::size_t width, uint64_t value) {
+            const auto text = fmt::format("{:0{}o}", value, width - 1);
+            std::memcpy(field, text.data(), std::min(text.size(), width - 1));
+        }
+
+        // Splits 'path' into the ustar prefix and name fields, false when it can't
+        bool splitUstar(std::string_view path, std::string_view &prefix, std::string_view &name) {
+            if (path.size() <= 100) {
+                prefix = {};
+                name = path;
+                return true;
+            }
+
+            // The last separator leaving a name of at most 100 bytes and a prefix of at most 155
+            for (auto slash = path.find('/', path.size() - 101); slash != std::string_view::npos; slash = path.find('/', slash + 1)) {
+                if (slash <= 155 && slash + 1 < path.size()) {
+                    prefix = path.substr(0, slash);
+                    name = path.substr(slash + 1);
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        // "<length> <key>=<value>\n", where the length counts its own digits too
+        std::string paxRecord(std::string_view key, std::string_view value) {
+            const auto body = key.size() + value.size() + 3;
+            auto length = body + fmt::formatted_size("{}", body);
+
+            if (fmt::formatted_size("{}", length) != fmt::formatted_size("{}", body)) {
+                ++length;
+            }
+
+            return fmt::format("{} {}={}\n", length, key, value);
+        }
+    }
+
+    tar_writer::expected_t tar_writer::open(std::string_view target, int level) {
+        using error_t = expected_t::unexpected_type;
+
+        tar_writer writer;
+        writer.m_Target = target;
+        writer.m_Mtime = std::time(nullptr);
+        writer.m_Buffer.reserve(BufferSize);
+
+        if (level > 0) {
+#ifdef ARTI_WITH_ZSTD
+            auto *stream = ZSTD_createCStream();
+
+            if (stream == nullptr || ZSTD_isError(ZSTD_CCtx_setParameter(stream, ZSTD_c_compressionLevel, level))) {
+                ZSTD_freeCStream(stream);
+                return error_t{ { file_errors::UnableToCreate, fmt::format("Invalid zstd compression level {}", level) } };
+            }
+
+            writer.m_Stream = stream;
+            writer.m_Compressed.resize(ZSTD_CStreamOutSize());
+#else
+            return error_t{ { file_errors::UnableToCreate, "This build doesn't support zstd compression" } };
+#endif
+        }
+
+        if (target == "-") {
+            writer.m_Fd = STDOUT_FILENO;
+            return std::move(writer);
+        }
+
+        const auto temp = temporaryPath(fs::path{ target }).string();
+
+        writer.m_Fd = ::open(temp.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+        trace::add(counters::OpenCalls);
+
+        if (writer.m_Fd < 0) {
+            return error_t{ { file_errors::UnableToCreate, fmt::format("{}: {}", target, std::strerror(errno)) } };
+        }
+
+        writer.m_Owned = true;
+        writer.m_Temp = temp;
+
+        return std::move(writer);
+    }
+
+    bool tar_writer::compressionSupported() {
+#ifdef ARTI_WITH_ZSTD
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    tar_writer::~tar_writer() {
+        release();
+    }
+
+    tar_writer::tar_writer(tar_writer &&other) noexcept
+        : m_Fd(std::exchange(other.m_Fd, -1))
+        , m_Owned(std::exchange(other.m_Owned, false))
+        , m_Target(std::move(other.m_Target))
+        , m_Temp(std::exchange(other.m_Temp, {}))
+        , m_Mtime(other.m_Mtime)
+        , m_Buffer(std::move(other.m_Buffer))
+        , m_Compressed(std::move(other.m_Compressed))
+        , m_Stream(std::exchange(other.m_Stream, nullptr)) { }
+
+    tar_writer &tar_writer::operator=(tar_writer &&other) noexcept {
+        if (this != &other) {
+            release();
+
+            m_Fd = std::exchange(other.m_Fd, -1);
+            m_Owned = std::exchange(other.m_Owned, false);
+            m_Target = std::move(other.m_Target);
+            m_Temp = std::exchange(other.m_Temp, {});
+            m_Mtime = other.m_Mtime;
+            m_Buffer = std::move(other.m_Buffer);
+            m_Compressed = std::move(other.m_Compressed);
+            m_Stream = std::exchange(other.m_Stream, nullptr);
+        }
+
+        return *this;
+    }
+
+    tar_writer::status_t tar_writer::directory(std::string_view path, mode_t mode) {
+        return header(fmt::format("{}/", path), '5', mode, 0);
+    }
+
+    tar_writer::status_t tar_writer::file(std::string_view path, mode_t mode, const std::vector<std::string_view> &chunks) {
+        uint64_t size = 0;
+
+        for (const auto &chunk : chunks) {
+            size += chunk.size();
+        }
+
+        if (auto ex = header(path, '0', mode, size); ! ex) {
+            return ex;
+        }
+
+        for (const auto &chunk : chunks) {
+            if (auto ex = put(chunk); ! ex) {
+                return ex;
+            }
+        }
+
+        return pad(size);
+    }
+
+    tar_writer::status_t tar_writer::finish() {
+        if (auto ex = put({ Zeros, sizeof(Zeros) }); ! ex) {
+            return ex;
+        }
+
+        if (auto ex = flush(true); ! ex) {
+            return ex;
+        }
+
+        // Taken before release(), which removes an archive it's left with
+        const auto temp = std::exchange(m_Temp, {});
+
+        if (auto ex = release(); ! ex) {
+            if (! temp.empty()) {
+                ::unlink(temp.c_str());
+            }
+
+            return ex;
+        }
+
+        if (! temp.empty() && ::rename(temp.c_str(), m_Target.c_str()) != 0) {
+            const auto err = errno;
+            ::unlink(temp.c_str());
+
+            return status_t::unexpected_type{ { file_errors::UnableToWrite, fmt::format("{}: {}", m_Target, std::strerror(err)) } };
+        }
+
+        return {};
+    }
+
+    tar_writer::status_t tar_writer::header(std::string_view path, char type, mode_t mode, uint64_t size) {
+        std::string_view prefix, name;
+
+        const bool pathFits = splitUstar(path, prefix, name);
+        const bool sizeFits = size <= MaxUstarSize;
+
+        // What ustar can't hold goes on a pax extended header describing the next entry
+        if (! pathFits || ! sizeFits) {
+            std::string records;
+
+            if (! pathFits) {
+                records += paxRecord("path", path);
+                prefix = {};
+                name = path.substr(path.size() > 100 ? path.size() - 100 : 0);
+            }
+
+            if (! sizeFits) {
+                records += paxRecord("size", fmt::format("{}", size));
+            }
+
+            if (auto ex = header("././@PaxHeader", 'x', 0644, records.size()); ! ex) {
+                return ex;
+            }
+
+            if (auto ex = put(records); ! ex) {
+                return ex;
+            }
+
+            if (auto ex = pad(records.size()); ! ex) {
+                return ex;
+            }
+        }
+
+        char block[BlockSize] = {};
+
+        std::memcpy(block, name.data(), name.size());
+        putOctal(block + 100, 8, mode & 07777);
+        putOctal(block + 108, 8, 0);
+        putOctal(block + 116, 8, 0);
+        putOctal(block + 124, 12, sizeFits ? size : 0);
+        putOctal(block + 136, 12, static_cast<uint64_t>(m_Mtime));
+        block[156] = type;
+        std::memcpy(block + 257, "ustar", 6);
+        std::memcpy(block + 263, "00", 2);
+        std::memcpy(block + 345, prefix.data(), prefix.size());
+
+        // Computed with the checksum field itself taken as spaces
+        std::memset(block + 148, ' ', 8);
+
+        unsigned sum = 0;
+
+        for (const auto c : block) {
+            sum += static_cast<unsigned char>(c);
+        }
+
+        putOctal(block + 148, 7, sum);
+
+        return put({ block, sizeof(block) });
+    }
+
+    tar_writer::status_t tar_writer::put(std::string_view data) {
+        while (! data.empty()) {
+            const auto n = std::min(data.size(), BufferSize - m_Buffer.size());
+
+            m_Buffer.append(data.data(), n);
+            data.remove_prefix(n);
+
+            if (m_Buffer.size() == BufferSize) {
+                if (auto ex = flush(false); ! ex) {
+                    return ex;
+                }
+            }
+        }
+
+        return {};
+    }
+
+    tar_writer::status_t tar_writer::pad(uint64_t size) {
+        if (const auto rest = size % BlockSize; rest != 0) {
+            return put({ Zeros, BlockSize - rest });
+        }
+
+        return {};
+    }
+
+    tar_writer::status_t tar_writer::flush([[maybe_unused]] bool last) {
+        using error_t = status_t::unexpected_type;
+
+        const auto writeError = [&] {
+            return error_t{ { file_errors::UnableToWrite, fmt::format("{}: {}", m_Target, std::strerror(errno)) } };
+        };
+
+        if (m_Stream == nullptr) {
+            const bool written = writeAll(m_Fd, m_Buffer);
+            m_Buffer.clear();
+
+            return written ? status_t{} : writeError();
+        }
+
+#ifdef ARTI_WITH_ZSTD
+        auto *stream = static_cast<ZSTD_CStream *>(m_Stream);
+
+        ZSTD_inBuffer in{ m_Buffer.data(), m_Buffer.size(), 0 };
+
+        for (;;) {
+            ZSTD_outBuffer out{ m_Compressed.data(), m_Compressed.size(), 0 };
+
+            const auto remaining = ZSTD_compressStream2(stream, &out, &in, last ? ZSTD_e_end : ZSTD_e_continue);
+
+            if (ZSTD_isError(remaining)) {
+                return error_t{ { file_errors::UnableToWrite, fmt::format("{}: {}", m_Target, ZSTD_getErrorName(remaining)) } };
+            }
+
+            if (! writeAll(m_Fd, { m_Compressed.data(), out.pos })) {
+                return writeError();
+            }
+
+            // The frame is only complete once zstd has nothing left to write
+            if (last ? remaining == 0 : in.pos == in.size) {
+                break;
+            }
+        }
+#endif
+
+        m_Buffer.clear();
+
+        return {};
+    }
+
+    tar_writer::status_t tar_writer::release() {
+        using error_t = status_t::unexpected_type;
+
+#ifdef ARTI_WITH_ZSTD
+        ZSTD_freeCStream(static_cast<ZSTD_CStream *>(m_Stream));
+#endif
+        m_Stream = nullptr;
+
+        const bool closed = ! m_Owned || ::close(m_Fd) == 0;
+
+        m_Fd = -1;
+        m_Owned = false;
+
+        // Never finished, whatever was there before stays
+        if (! m_Temp.empty()) {
+            ::unlink(m_Temp.c_str());
+            m_Temp.clear();
+        }
+
+        if (! closed) {
+            return error_t{ { file_errors::UnableToWrite, fmt::format("{}: {}", m_Target, std::strerror(errno)) } };
+        }
+
+        return {};
+    }
+
+}
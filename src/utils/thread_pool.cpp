@@ -0,0 +1,144 @@
+#include "utils/thread_pool.hpp"
+
+namespace arti::utils {
+
+    namespace {
+        thread_local const thread_pool *t_Pool = nullptr;
+        thread_local int t_WorkerIndex = -1;
+    }
+
+    thread_pool::thread_pool(std::size_t workers) {
+        if (workers == 0) {
+            workers = 1;
+        }
+
+        m_Queues.reserve(workers);
+
+        for (std::size_t i = 0; i < workers; ++i) {
+            m_Queues.push_back(std::make_unique<queue>());
+        }
+
+        m_Workers.reserve(workers);
+
+        for (std::size_t i = 0; i < workers; ++i) {
+            m_Workers.emplace_back([this, i] {
+                workerLoop(i);
+            });
+        }
+    }
+
+    thread_pool::~thread_pool() {
+        {
+            std::lock_guard lock{ m_Mutex };
+            m_Stop = true;
+        }
+
+        m_TaskReady.notify_all();
+
+        for (auto &worker : m_Workers) {
+            worker.join();
+        }
+    }
+
+    void thread_pool::submit(task_t task) {
+        const auto index = (t_Pool == this)
+            ? static_cast<std::size_t>(t_WorkerIndex)
+            : m_NextQueue.fetch_add(1, std::memory_order_relaxed) % m_Queues.size();
+
+        m_Pending.fetch_add(1);
+
+        {
+            std::lock_guard lock{ m_Mutex };
+            m_Queued.fetch_add(1);
+        }
+
+        {
+            std::lock_guard lock{ m_Queues[index]->mutex };
+            m_Queues[index]->tasks.push_back(std::move(task));
+        }
+
+        m_TaskReady.notify_one();
+    }
+
+    void thread_pool::wait() {
+        std::unique_lock lock{ m_Mutex };
+
+        m_AllDone.wait(lock, [&] {
+            return m_Pending.load() == 0;
+        });
+    }
+
+    std::size_t thread_pool::size() const {
+        return m_Workers.size();
+    }
+
+    int thread_pool::workerIndex() {
+        return t_WorkerIndex;
+    }
+
+    std::size_t thread_pool::defaultConcurrency() {
+        const auto hw = std::thread::hardware_concurrency();
+
+        return hw == 0 ? 1 : hw;
+    }
+
+    bool thread_pool::tryPop(std::size_t index, task_t &task) {
+        {
+            auto &own = *m_Queues[index];
+            std::lock_guard lock{ own.mutex };
+
+            if (! own.tasks.empty()) {
+                task = std::move(own.tasks.back());
+                own.tasks.pop_back();
+                m_Queued.fetch_sub(1);
+                return true;
+            }
+        }
+
+        for (std::size_t i = 1; i < m_Queues.size(); ++i) {
+            auto &victim = *m_Queues[(index + i) % m_Queues.size()];
+            std::lock_guard lock{ victim.mutex };
+
+            if (! victim.tasks.empty()) {
+                task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+                m_Queued.fetch_sub(1);
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void thread_pool::workerLoop(std::size_t index) {
+        t_Pool = this;
+        t_WorkerIndex = static_cast<int>(index);
+
+        task_t task;
+
+        for (;;) {
+            if (tryPop(index, task)) {
+                task();
+                task = nullptr;
+
+                if (m_Pending.fetch_sub(1) == 1) {
+                    std::lock_guard lock{ m_Mutex };
+                    m_AllDone.notify_all();
+                }
+
+                continue;
+            }
+
+            std::unique_lock lock{ m_Mutex };
+
+            m_TaskReady.wait(lock, [&] {
+                return m_Stop || m_Queued.load() > 0;
+            });
+
+            if (m_Stop && m_Queued.load() == 0) {
+                return;
+            }
+        }
+    }
+
+}
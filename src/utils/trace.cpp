@@ -0,0 +1,210 @@
+#include "utils/trace.hpp"
+
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+
+#include <fmt/format.h>
+
+#include "utils/json.hpp"
+#include "utils/thread_pool.hpp"
+
+namespace arti::utils {
+
+    namespace {
+        using clock_t = std::chrono::steady_clock;
+
+        struct event {
+            trace::span::kinds kind;
+            std::string name;
+            int64_t start;
+            int64_t duration;
+            // 0 is the main thread, pool workers are 1 based
+            int thread;
+        };
+
+        std::atomic<bool> s_Enabled = false;
+        std::array<std::atomic<uint64_t>, static_cast<std::size_t>(trace::counters::Count)> s_Counters{};
+
+        clock_t::time_point s_Start;
+
+        std::mutex s_EventsMutex;
+        std::vector<event> s_Events;
+
+        int64_t microsecondsSince(clock_t::time_point from, clock_t::time_point to) {
+            return std::chrono::duration_cast<std::chrono::microseconds>(to - from).count();
+        }
+    }
+
+    trace::span::span(kinds kind, std::string_view name)
+        : m_Active(trace::enabled())
+        , m_Kind(kind) {
+        if (m_Active) {
+            m_Name = name;
+            m_Start = clock_t::now();
+        }
+    }
+
+    trace::span::~span() {
+        if (! m_Active) {
+            return;
+        }
+
+        const auto end = clock_t::now();
+
+        event current{
+            m_Kind,
+            std::move(m_Name),
+            microsecondsSince(s_Start, m_Start),
+            microsecondsSince(m_Start, end),
+            thread_pool::workerIndex() + 1
+        };
+
+        std::lock_guard lock{ s_EventsMutex };
+        s_Events.push_back(std::move(current));
+    }
+
+    void trace::enable() {
+        s_Start = clock_t::now();
+        s_Enabled.store(true, std::memory_order_relaxed);
+    }
+
+    bool trace::enabled() {
+        return s_Enabled.load(std::memory_order_relaxed);
+    }
+
+    void trace::add(counters counter, uint64_t amount) {
+        if (enabled()) {
+            s_Counters[static_cast<std::size_t>(counter)].fetch_add(amount, std::memory_order_relaxed);
+        }
+    }
+
+    uint64_t trace::get(counters counter) {
+        return s_Counters[static_cast<std::size_t>(counter)].load(std::memory_order_relaxed);
+    }
+
+    std::string trace::stats() {
+        const auto wall = std::chrono::duration<double, std::milli>(clock_t::now() - s_Start).count();
+
+        const auto syscalls = get(counters::OpenCalls) + get(counters::ReadCalls) + get(counters::WriteCalls)
+                            + get(counters::StatCalls) + get(counters::MkdirCalls) + get(counters::MapCalls)
+                            + get(counters::RingEnterCalls);
+
+        std::string out = fmt::format(
+            "Stats:\n"
+            "  wall time:            {:.3f} ms\n"
+            "  bytes read:           {}\n"
+            "  bytes written:        {}\n"
+            "  files created:        {}\n"
+            "  directories created:  {}\n"
+            "  placeholders:         {}\n"
+            "  syscalls:             {} (open {}, read {}, write {}, stat {}, mkdir {}, mmap {}, io_uring_enter {})\n"
+            "  io_uring operations:  {}\n",
+            wall,
+            get(counters::BytesRead),
+            get(counters::BytesWritten),
+            get(counters::FilesCreated),
+            get(counters::DirectoriesCreated),
+            get(counters::Placeholders),
+            syscalls,
+            get(counters::OpenCalls),
+            get(counters::ReadCalls),
+            get(counters::WriteCalls),
+            get(counters::StatCalls),
+            get(counters::MkdirCalls),
+            get(counters::MapCalls),
+            get(counters::RingEnterCalls),
+            get(counters::RingOperations)
+        );
+
+        struct phase {
+            int64_t total = 0;
+            std::size_t count = 0;
+            int64_t firstStart = 0;
+        };
+
+        std::map<std::string, phase> phases;
+
+        {
+            std::lock_guard lock{ s_EventsMutex };
+
+            for (const auto &current : s_Events) {
+                if (current.kind != span::kinds::Phase) {
+                    continue;
+                }
+
+                auto [it, inserted] = phases.try_emplace(current.name, phase{ 0, 0, current.start });
+                it->second.total += current.duration;
+                it->second.count += 1;
+                it->second.firstStart = std::min(it->second.firstStart, current.start);
+            }
+        }
+
+        std::vector<std::pair<std::string, phase>> ordered{ phases.begin(), phases.end() };
+
+        std::sort(ordered.begin(), ordered.end(), [](const auto &lhs, const auto &rhs) {
+            return lhs.second.firstStart < rhs.second.firstStart;
+        });
+
+        if (! ordered.empty()) {
+            out += "  phases:\n";
+        }
+
+        for (const auto &[name, current] : ordered) {
+            out += fmt::format("    {:<24} {:>10.3f} ms", name, current.total / 1000.0);
+            out += current.count > 1 ? fmt::format(" ({} times)\n", current.count) : "\n";
+        }
+
+        return out;
+    }
+
+    bool trace::writeChromeTrace(const fs::path &path) {
+        std::ofstream file{ path };
+
+        if (! file) {
+            return false;
+        }
+
+        std::lock_guard lock{ s_EventsMutex };
+
+        int threads = 0;
+
+        for (const auto &current : s_Events) {
+            threads = std::max(threads, current.thread + 1);
+        }
+
+        file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+        for (int i = 0; i < threads; ++i) {
+            const auto threadName = i == 0 ? std::string{ "main" } : fmt::format("worker {}", i - 1);
+
+            file << fmt::format(
+                "{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":{},\"args\":{{\"name\":\"{}\"}}}},\n",
+                i,
+                threadName
+            );
+        }
+
+        for (std::size_t i = 0; i < s_Events.size(); ++i) {
+            const auto &current = s_Events[i];
+
+            file << fmt::format(
+                "{{\"name\":\"{}\",\"cat\":\"{}\",\"ph\":\"X\",\"ts\":{},\"dur\":{},\"pid\":1,\"tid\":{}}}{}\n",
+                escapeJson(current.name),
+                current.kind == span::kinds::Phase ? "phase" : "file",
+                current.start,
+                current.duration,
+                current.thread,
+                i + 1 < s_Events.size() ? "," : ""
+            );
+        }
+
+        file << "]}\n";
+
+        return static_cast<bool>(file);
+    }
+
+}
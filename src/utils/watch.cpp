@@ -0,0 +1,204 @@
+#include "utils/watch.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <utility>
+#include <string>
+
+#include <poll.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+
+#include <fmt/format.h>
+
+namespace arti::utils {
+
+    namespace {
+        // IN_MODIFY would fire on every write of a save, closing the file is enough
+        constexpr uint32_t Events = IN_CLOSE_WRITE | IN_ATTRIB | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO
+                                  | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR | IN_EXCL_UNLINK;
+
+        constexpr std::size_t BufferSize = 64 * 1024;
+    }
+
+    directory_watcher::expected_t directory_watcher::open(const fs::path &root) {
+        using error_t = expected_t::unexpected_type;
+
+        const int fd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+        if (fd < 0) {
+            return error_t{ { watch_errors::UnableToCreate, std::strerror(errno) } };
+        }
+
+        directory_watcher watcher{ fd, root };
+
+        if (! watcher.watch(root)) {
+            return error_t{ { watch_errors::UnableToWatch, fmt::format("{}: {}", root.string(), std::strerror(errno)) } };
+        }
+
+        return std::move(watcher);
+    }
+
+    directory_watcher::directory_watcher(int fd, fs::path root)
+        : m_Fd(fd)
+        , m_Root(std::move(root)) {
+    }
+
+    directory_watcher::~directory_watcher() {
+        release();
+    }
+
+    directory_watcher::directory_watcher(directory_watcher &&other) noexcept
+        : m_Fd(std::exchange(other.m_Fd, -1))
+        , m_Root(std::move(other.m_Root))
+        , m_Directories(std::move(other.m_Directories)) {
+    }
+
+    directory_watcher &directory_watcher::operator=(directory_watcher &&other) noexcept {
+        if (this != &other) {
+            release();
+
+            m_Fd = std::exchange(other.m_Fd, -1);
+            m_Root = std::move(other.m_Root);
+            m_Directories = std::move(other.m_Directories);
+        }
+
+        return *this;
+    }
+
+    directory_watcher::changes_t directory_watcher::wait(std::chrono::milliseconds settle) {
+        using error_t = changes_t::unexpected_type;
+
+        std::vector<change> changes;
+        std::unordered_map<std::string, std::size_t> index;
+
+        // A path changed several times is reported once, with everything that happened to it
+        const auto note = [&](const fs::path &path, bool directory) -> change & {
+            const auto [it, inserted] = index.try_emplace(path.native(), changes.size());
+
+            if (inserted) {
+                changes.push_back(change{ path, directory });
+            }
+
+            return changes[it->second];
+        };
+
+        alignas(struct inotify_event) char buffer[BufferSize];
+        bool waiting = true;
+
+        while (true) {
+            pollfd polled{ m_Fd, POLLIN, 0 };
+            const int ready = ::poll(&polled, 1, waiting ? -1 : static_cast<int>(settle.count()));
+
+            if (ready < 0 && errno == EINTR) {
+                continue;
+            }
+
+            if (ready < 0) {
+                return error_t{ { watch_errors::UnableToRead, std::strerror(errno) } };
+            }
+
+            // Quiet for 'settle', whatever was being saved is done
+            if (ready == 0) {
+                return changes;
+            }
+
+            waiting = false;
+
+            while (true) {
+                const auto n = ::read(m_Fd, buffer, sizeof(buffer));
+
+                if (n < 0 && errno == EINTR) {
+                    continue;
+                }
+
+                if (n < 0 && errno == EAGAIN) {
+                    break;
+                }
+
+                if (n <= 0) {
+                    return error_t{ { watch_errors::UnableToRead, std::strerror(errno) } };
+                }
+
+                for (auto *cur = buffer; cur < buffer + n;) {
+                    const auto *event = reinterpret_cast<const struct inotify_event *>(cur);
+                    cur += sizeof(struct inotify_event) + event->len;
+
+                    if (event->mask & IN_Q_OVERFLOW) {
+                        note(m_Root, true).created = true;
+                        continue;
+                    }
+
+                    const auto dir = m_Directories.find(event->wd);
+
+                    if (dir == m_Directories.end()) {
+                        continue;
+                    }
+
+                    if (event->mask & IN_IGNORED) {
+                        m_Directories.erase(dir);
+                        continue;
+                    }
+
+                    if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF)) {
+                        note(dir->second, true).removed = true;
+                        continue;
+                    }
+
+                    const bool directory = event->mask & IN_ISDIR;
+                    const auto path = event->len > 0 ? dir->second / event->name : dir->second;
+
+                    auto &current = note(path, directory);
+
+                    if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                        current.created = true;
+
+                        // Anything created inside it before it was watched is found by the walk
+                        if (directory) {
+                            watch(path);
+                        }
+                    }
+
+                    if (event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+                        current.removed = true;
+                    }
+
+                    if (event->mask & (IN_CLOSE_WRITE | IN_ATTRIB)) {
+                        current.written = true;
+                    }
+                }
+            }
+        }
+    }
+
+    bool directory_watcher::watch(const fs::path &directory) {
+        // A directory moved within the tree keeps its watch, only its path is updated
+        const int wd = ::inotify_add_watch(m_Fd, directory.c_str(), Events);
+
+        if (wd < 0) {
+            return false;
+        }
+
+        m_Directories.insert_or_assign(wd, directory);
+
+        std::error_code ec;
+
+        for (const auto &entry : fs::directory_iterator{ directory, ec }) {
+            if (entry.is_directory(ec) && ! entry.is_symlink(ec)) {
+                watch(entry.path());
+            }
+        }
+
+        return true;
+    }
+
+    void directory_watcher::release() {
+        if (m_Fd >= 0) {
+            ::close(m_Fd);
+            m_Fd = -1;
+        }
+
+        m_Directories.clear();
+    }
+
+}
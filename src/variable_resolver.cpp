@@ -0,0 +1,141 @@
+#include "variable_resolver.hpp"
+
+#include <vector>
+#include <cstdint>
+#include <utility>
+#include <string_view>
+
+#include <fmt/format.h>
+
+#include "compiled_template.hpp"
+#include "utils/scan.hpp"
+
+namespace arti {
+
+    namespace {
+        enum class states : uint8_t {
+            Unvisited,
+            Visiting,
+            Done
+        };
+
+        constexpr std::size_t Undefined = static_cast<std::size_t>(-1);
+
+        // One per variable id
+        struct node {
+            // Values without '{{' are final as they are and never compiled
+            bool templated = false;
+            compiled_template compiled;
+            // Node index of every slot, 'Undefined' when the variable doesn't exist
+            std::vector<std::size_t> references;
+            std::string resolved;
+            states state = states::Done;
+        };
+
+        std::string_view finalValue(const node &current, std::string_view value) {
+            return current.templated ? std::string_view{ current.resolved } : value;
+        }
+    }
+
+    variable_resolver::expected_t variable_resolver::resolve(variable_store &vars) {
+        using error_t = expected_t::unexpected_type;
+
+        // Ids are dense, they index the nodes directly
+        std::vector<node> nodes(vars.size());
+
+        bool anyTemplated = false;
+
+        for (variable_store::id_t id = 0; id < nodes.size(); ++id) {
+            auto &current = nodes[id];
+            const auto value = vars.value(id);
+
+            if (! vars.defined(id) || utils::scanner::findOpening(value) == std::string::npos) {
+                continue;
+            }
+
+            current.templated = true;
+            current.state = states::Unvisited;
+            current.compiled = compiled_template::compileView(value);
+
+            const auto &chains = current.compiled.chains();
+            current.references.reserve(chains.size());
+
+            for (std::size_t slot = 0; slot < chains.size(); ++slot) {
+                // A loop's variable is bound to its items, it refers to nothing
+                const auto reference = current.compiled.loopBound(slot) ? variable_store::npos : vars.find(chains[slot].variable());
+                current.references.push_back(reference == variable_store::npos || ! vars.defined(reference) ? Undefined : reference);
+            }
+
+            anyTemplated = true;
+        }
+
+        if (! anyTemplated) {
+            return {};
+        }
+
+        // Iterative DFS, long reference chains can't overflow the stack
+        std::vector<std::pair<std::size_t, std::size_t>> stack;
+        std::vector<std::string_view> values;
+
+        for (std::size_t root = 0; root < nodes.size(); ++root) {
+            if (nodes[root].state != states::Unvisited) {
+                continue;
+            }
+
+            nodes[root].state = states::Visiting;
+            stack.emplace_back(root, 0);
+
+            while (! stack.empty()) {
+                const auto index = stack.back().first;
+                auto &current = nodes[index];
+
+                if (stack.back().second < current.references.size()) {
+                    const auto reference = current.references[stack.back().second++];
+
+                    if (reference == Undefined || nodes[reference].state == states::Done) {
+                        continue;
+                    }
+
+                    if (nodes[reference].state == states::Visiting) {
+                        std::string path;
+
+                        for (auto it = stack.begin(); it != stack.end(); ++it) {
+                            if (! path.empty() || it->first == reference) {
+                                path += fmt::format("{} -> ", vars.name(it->first));
+                            }
+                        }
+
+                        path += vars.name(reference);
+
+                        return error_t{ { errors::Cycle, fmt::format("Cyclic variable definition: {}", path) } };
+                    }
+
+                    nodes[reference].state = states::Visiting;
+                    stack.emplace_back(reference, 0);
+                    continue;
+                }
+
+                values.clear();
+
+                for (const auto reference : current.references) {
+                    values.push_back(reference == Undefined ? std::string_view{} : finalValue(nodes[reference], vars.value(reference)));
+                }
+
+                current.compiled.renderTo(current.resolved, values);
+                current.state = states::Done;
+
+                stack.pop_back();
+            }
+        }
+
+        // Only written back once everything resolved, a cycle leaves 'vars' untouched
+        for (variable_store::id_t id = 0; id < nodes.size(); ++id) {
+            if (nodes[id].templated) {
+                vars.set(id, nodes[id].resolved);
+            }
+        }
+
+        return {};
+    }
+
+}
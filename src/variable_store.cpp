@@ -0,0 +1,163 @@
+#include "variable_store.hpp"
+
+#include <cstring>
+#include <stdexcept>
+#include <algorithm>
+
+#include <fmt/format.h>
+
+namespace arti {
+
+    namespace {
+        constexpr std::size_t BlockSize = 4096;
+    }
+
+    variable_store variable_store::over(const variable_store &base) {
+        variable_store layered;
+
+        layered.m_Base = &base;
+        layered.m_Names = base.m_Names;
+        layered.m_Values = base.m_Values;
+        layered.m_Defined = base.m_Defined;
+
+        return layered;
+    }
+
+    variable_store::variable_store(const variable_store &other) {
+        m_Names.reserve(other.m_Names.size());
+        m_Values.reserve(other.m_Values.size());
+        m_Defined.reserve(other.m_Defined.size());
+        m_Index.reserve(other.m_Names.size());
+
+        for (id_t id = 0; id < other.m_Names.size(); ++id) {
+            const auto copied = intern(other.m_Names[id]);
+
+            if (other.m_Defined[id]) {
+                set(copied, other.m_Values[id]);
+            }
+        }
+    }
+
+    variable_store &variable_store::operator=(const variable_store &other) {
+        if (this != &other) {
+            *this = variable_store{ other };
+        }
+
+        return *this;
+    }
+
+    variable_store::id_t variable_store::intern(std::string_view name) {
+        if (const auto id = find(name); id != npos) {
+            return id;
+        }
+
+        const auto id = static_cast<id_t>(m_Names.size());
+        const auto stored = store(name);
+
+        m_Names.push_back(stored);
+        m_Values.emplace_back();
+        m_Defined.push_back(false);
+        m_Index.emplace(stored, id);
+
+        return id;
+    }
+
+    variable_store::id_t variable_store::find(std::string_view name) const {
+        // Base ids are shared, the base only ever knows fewer names
+        if (m_Base) {
+            if (const auto id = m_Base->find(name); id != npos) {
+                return id;
+            }
+        }
+
+        if (auto it = m_Index.find(name); it != m_Index.end()) {
+            return it->second;
+        }
+
+        return npos;
+    }
+
+    void variable_store::set(std::string_view name, std::string_view value) {
+        set(intern(name), value);
+    }
+
+    void variable_store::set(id_t id, std::string_view value) {
+        m_Values[id] = store(value);
+        m_Defined[id] = true;
+    }
+
+    bool variable_store::contains(std::string_view name) const {
+        const auto id = find(name);
+
+        return id != npos && m_Defined[id];
+    }
+
+    std::optional<std::string_view> variable_store::get(std::string_view name) const {
+        const auto id = find(name);
+
+        if (id == npos || ! m_Defined[id]) {
+            return std::nullopt;
+        }
+
+        return m_Values[id];
+    }
+
+    std::string_view variable_store::at(std::string_view name) const {
+        if (auto value = get(name)) {
+            return *value;
+        }
+
+        throw std::out_of_range{ fmt::format("Undefined variable '{}'", name) };
+    }
+
+    std::size_t variable_store::size() const {
+        return m_Names.size();
+    }
+
+    bool variable_store::defined(id_t id) const {
+        return m_Defined[id];
+    }
+
+    std::string_view variable_store::name(id_t id) const {
+        return m_Names[id];
+    }
+
+    std::string_view variable_store::value(id_t id) const {
+        return m_Values[id];
+    }
+
+    std::string_view variable_store::store(std::string_view text) {
+        if (text.empty()) {
+            return {};
+        }
+
+        // Big values get a block of their own, the last block keeps filling up
+        if (text.size() > BlockSize / 4) {
+            auto block = std::make_unique<char[]>(text.size());
+            std::memcpy(block.get(), text.data(), text.size());
+
+            const std::string_view stored{ block.get(), text.size() };
+
+            m_Blocks.insert(m_Blocks.empty() ? m_Blocks.end() : m_Blocks.end() - 1, std::move(block));
+
+            if (m_Blocks.size() == 1) {
+                m_BlockUsed = BlockSize;
+            }
+
+            return stored;
+        }
+
+        if (m_Blocks.empty() || BlockSize - m_BlockUsed < text.size()) {
+            m_Blocks.push_back(std::make_unique<char[]>(BlockSize));
+            m_BlockUsed = 0;
+        }
+
+        char *begin = m_Blocks.back().get() + m_BlockUsed;
+
+        std::memcpy(begin, text.data(), text.size());
+        m_BlockUsed += text.size();
+
+        return { begin, text.size() };
+    }
+
+}
@@ -0,0 +1,164 @@
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <filesystem>
+#include <string_view>
+
+#include <unistd.h>
+#include <sys/resource.h>
+
+#include <fmt/format.h>
+
+#include "utils/io.hpp"
+
+// Writes a batch of files several times larger than a lowered descriptor limit through each
+// backend, checking every file was created with its content, and a batch with a failing copy in
+// the middle, checking every other request was still attempted. Exits with 1 if any check fails.
+
+namespace {
+
+    namespace fs = std::filesystem;
+
+    using arti::utils::io_backend;
+
+    constexpr rlim_t DescriptorLimit = 256;
+    constexpr std::size_t Files = 2000;
+
+    std::string contentOf(std::size_t i) {
+        return fmt::format("file {}\n", i);
+    }
+
+    bool check(io_backend::kinds kind, const fs::path &root) {
+        const auto name = io_backend::name(kind);
+        auto backend = io_backend::create(kind, Files);
+
+        if (! backend) {
+            fmt::print("{}: not available, skipped\n", name);
+            return true;
+        }
+
+        const auto dir = root / name;
+        fs::create_directory(dir);
+
+        std::vector<std::string> contents;
+        std::vector<io_backend::file_request> requests(Files);
+
+        contents.reserve(Files);
+
+        for (std::size_t i = 0; i < Files; ++i) {
+            contents.push_back(contentOf(i));
+
+            requests[i].path = dir / fmt::format("{}.txt", i);
+            requests[i].chunks = { std::string_view{ contents.back() }.substr(0, 5), std::string_view{ contents.back() }.substr(5) };
+        }
+
+        const auto statuses = backend->writeFiles(requests, 1);
+        std::size_t failures = 0;
+
+        for (std::size_t i = 0; i < Files; ++i) {
+            if (! statuses[i]) {
+                if (failures++ == 0) {
+                    fmt::print(stderr, "{}: {}\n", name, statuses[i].error().info);
+                }
+
+                continue;
+            }
+
+            std::ifstream file{ requests[i].path, std::ios::binary };
+            const std::string written{ std::istreambuf_iterator<char>{ file }, {} };
+
+            if (written != contents[i]) {
+                if (failures++ == 0) {
+                    fmt::print(stderr, "{}: {} has the wrong content\n", name, requests[i].path.string());
+                }
+            }
+        }
+
+        if (failures > 0) {
+            fmt::print(stderr, "{}: {} of {} files failed\n", name, failures, Files);
+            return false;
+        }
+
+        fmt::print("{}: {} files written\n", name, Files);
+        return true;
+    }
+
+
+    // The copy of a missing source fails, the files before and after it are still written
+    bool checkPastFailure(io_backend::kinds kind, std::size_t jobs, const fs::path &root) {
+        const auto name = fmt::format("{} (past a failure, {} jobs)", io_backend::name(kind), jobs);
+        auto backend = io_backend::create(kind, Files);
+
+        if (! backend) {
+            fmt::print("{}: not available, skipped\n", name);
+            return true;
+        }
+
+        const auto dir = root / fmt::format("{}-failure-{}", io_backend::name(kind), jobs);
+        fs::create_directory(dir);
+
+        const auto missing = root / "missing.txt";
+        const std::string content = contentOf(0);
+
+        std::vector<io_backend::file_request> requests(3);
+
+        for (std::size_t i = 0; i < requests.size(); ++i) {
+            requests[i].path = dir / fmt::format("{}.txt", i);
+            requests[i].chunks = { content };
+        }
+
+        requests[1].source = &missing;
+
+        const auto statuses = backend->writeFiles(requests, jobs);
+
+        if (statuses[1] || ! statuses[0] || ! statuses[2] || ! fs::exists(requests[2].path)) {
+            fmt::print(stderr, "{}: expected only the copy of a missing source to fail\n", name);
+            return false;
+        }
+
+        fmt::print("{}: later files written\n", name);
+        return true;
+    }
+
+}
+
+int main() {
+    rlimit limit{};
+
+    if (::getrlimit(RLIMIT_NOFILE, &limit) != 0) {
+        std::perror("getrlimit");
+        return 1;
+    }
+
+    limit.rlim_cur = std::min(limit.rlim_cur, DescriptorLimit);
+
+    if (::setrlimit(RLIMIT_NOFILE, &limit) != 0) {
+        std::perror("setrlimit");
+        return 1;
+    }
+
+    std::string pattern = (fs::temp_directory_path() / "arti-io-XXXXXX").string();
+
+    if (::mkdtemp(pattern.data()) == nullptr) {
+        std::perror("mkdtemp");
+        return 1;
+    }
+
+    const fs::path root{ pattern };
+    bool passed = true;
+
+    for (const auto kind : { io_backend::kinds::Uring, io_backend::kinds::Auto, io_backend::kinds::Sync }) {
+        passed = check(kind, root) && passed;
+        passed = checkPastFailure(kind, 1, root) && passed;
+        passed = checkPastFailure(kind, 4, root) && passed;
+    }
+
+    std::error_code ec;
+    fs::remove_all(root, ec);
+
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,236 @@
+#include <array>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdio>
+#include <optional>
+#include <string_view>
+
+#include <unistd.h>
+
+#include <fmt/format.h>
+
+#include "compiled_template.hpp"
+#include "stream_renderer.hpp"
+#include "variable_store.hpp"
+#include "builtin_providers.hpp"
+
+// Streams inputs with placeholders, escapes and tags straddling the read buffer's edges, and lines
+// longer than the buffer, checking the output byte for byte against compiled_template::render.
+// Exits with 1 on the first mismatch.
+
+namespace {
+
+    using arti::stream_renderer;
+
+    constexpr std::size_t BufferSize = stream_renderer::BufferSize;
+
+    // Written to the input file in one go, a read stops exactly at the buffer's edge
+    constexpr std::size_t WholeFile = 0;
+
+    // Everything written to 'fd' from its start
+    std::optional<std::string> readBack(int fd) {
+        if (::lseek(fd, 0, SEEK_SET) != 0) {
+            return std::nullopt;
+        }
+
+        std::string ret;
+        std::array<char, 64 * 1024> buffer;
+
+        while (true) {
+            const auto n = ::read(fd, buffer.data(), buffer.size());
+
+            if (n < 0) {
+                return std::nullopt;
+            }
+
+            if (n == 0) {
+                return ret;
+            }
+
+            ret.append(buffer.data(), static_cast<std::size_t>(n));
+        }
+    }
+
+    bool writeAll(int fd, std::string_view text) {
+        while (! text.empty()) {
+            const auto n = ::write(fd, text.data(), text.size());
+
+            if (n <= 0) {
+                return false;
+            }
+
+            text.remove_prefix(static_cast<std::size_t>(n));
+        }
+
+        return true;
+    }
+
+    // Renders 'input' through the stream renderer. It's read from a file, or from a pipe written
+    // 'chunk' bytes at a time so reads end wherever the writer paused.
+    std::optional<std::string> stream(std::string_view input, std::size_t chunk, const arti::variable_store &vars) {
+        std::FILE *output = std::tmpfile();
+
+        if (! output) {
+            return std::nullopt;
+        }
+
+        arti::builtin_providers builtins;
+        stream_renderer::expected_t result = stream_renderer::expected_t::unexpected_type{ { stream_renderer::errors::UnableToRead, "" } };
+
+        if (chunk == WholeFile) {
+            std::FILE *file = std::tmpfile();
+
+            if (file && writeAll(::fileno(file), input) && ::lseek(::fileno(file), 0, SEEK_SET) == 0) {
+                result = stream_renderer::run(::fileno(file), ::fileno(output), vars, builtins);
+            }
+
+            if (file) {
+                std::fclose(file);
+            }
+        }
+        else {
+            int fds[2];
+
+            if (::pipe(fds) != 0) {
+                std::fclose(output);
+                return std::nullopt;
+            }
+
+            std::thread writer{ [&] {
+                for (std::size_t pos = 0; pos < input.size(); pos += chunk) {
+                    if (! writeAll(fds[1], input.substr(pos, chunk))) {
+                        break;
+                    }
+                }
+
+                ::close(fds[1]);
+            } };
+
+            result = stream_renderer::run(fds[0], ::fileno(output), vars, builtins);
+
+            // Drained so the writer never blocks on a renderer that gave up
+            std::array<char, 4096> rest;
+            while (::read(fds[0], rest.data(), rest.size()) > 0) {}
+
+            writer.join();
+            ::close(fds[0]);
+        }
+
+        auto rendered = result ? readBack(::fileno(output)) : std::nullopt;
+        std::fclose(output);
+
+        return rendered;
+    }
+
+    // Where the two outputs first differ, with a little context
+    std::string describeMismatch(std::string_view expected, std::string_view actual) {
+        std::size_t pos = 0;
+
+        while (pos < expected.size() && pos < actual.size() && expected[pos] == actual[pos]) {
+            ++pos;
+        }
+
+        const auto from = pos > 16 ? pos - 16 : 0;
+
+        return fmt::format("sizes {} and {}, first difference at {}: expected '{}', got '{}'",
+                           expected.size(), actual.size(), pos, expected.substr(from, 48), actual.substr(from, 48));
+    }
+
+}
+
+int main() {
+    arti::variable_store vars;
+    vars.set("name", "World");
+    vars.set("x", "1");
+
+    // Each is placed right before, across and right after the buffer's edge
+    const std::vector<std::string_view> tokens{
+        "{{ name }}",
+        "{{name}}",
+        "{{ name | upper }}",
+        "{{ name | replace(\"o\", \"}}\") }}",
+        "{{ missing | default(\"none\") }}",
+        "\\{{ name }}",
+        "\\{% if x %}",
+        "{% if x %}",
+        "{{ name }}{{ name }}",
+        "\\\\{{ name }}",
+        "{{ name",
+        "{{",
+        "{",
+        "\\",
+        "\\{",
+        "}}",
+    };
+
+    const std::vector<std::size_t> chunks{ WholeFile, 4099, 61 };
+
+    std::size_t cases = 0;
+    std::size_t failures = 0;
+
+    const auto check = [&](const std::string &input, std::string_view what) {
+        const auto expected = arti::compiled_template::compile(input).render(vars);
+
+        for (const auto chunk : chunks) {
+            ++cases;
+
+            const auto actual = stream(input, chunk, vars);
+
+            if (! actual) {
+                fmt::print(stderr, "{} ({}): the stream renderer failed\n", what, chunk == WholeFile ? "file" : fmt::format("pipe, {} byte writes", chunk));
+                ++failures;
+            }
+            else if (*actual != expected) {
+                fmt::print(stderr, "{} ({}): {}\n", what, chunk == WholeFile ? "file" : fmt::format("pipe, {} byte writes", chunk), describeMismatch(expected, *actual));
+                ++failures;
+            }
+        }
+    };
+
+    for (const auto token : tokens) {
+        for (std::size_t edge : { BufferSize, 2 * BufferSize }) {
+            for (std::size_t offset = edge - token.size() - 2; offset <= edge + 2; ++offset) {
+                // On a line of its own, and at the end of a line longer than the buffer
+                for (const bool longLine : { false, true }) {
+                    std::string input;
+
+                    if (longLine) {
+                        input.assign(offset, 'a');
+                    }
+                    else {
+                        input.assign(offset - 1, 'a');
+                        input += '\n';
+                    }
+
+                    input += token;
+                    input += " tail\n{{ name }} end\n";
+
+                    check(input, fmt::format("'{}' at {}{}", token, offset, longLine ? " on a long line" : ""));
+                }
+            }
+        }
+
+        // Last in the input, no newline after it
+        check(std::string(BufferSize - token.size() / 2, 'a') + std::string{ token }, fmt::format("'{}' at the end", token));
+    }
+
+    // Several buffers worth of a single line, placeholders all along it
+    std::string longLine;
+
+    while (longLine.size() < 3 * BufferSize) {
+        longLine += "text {{ name | lower }} more \\{{ name }} {";
+    }
+
+    check(longLine, "a line three buffers long");
+    check(longLine + "\n" + longLine, "two lines three buffers long");
+
+    if (failures > 0) {
+        fmt::print(stderr, "{} of {} cases failed\n", failures, cases);
+        return 1;
+    }
+
+    fmt::print("{} cases passed\n", cases);
+
+    return 0;
+}